@@ -43,3 +43,158 @@ function debug(message) end
 -- Exits the game.
 function quit() end
 
+-- Called by the engine once per simulation tick, if the game defines it.
+---@param dt number The fixed tick duration in seconds
+function update(dt) end
+
+-- Called by the engine once per rendered frame, if the game defines it. The
+-- draw functions only work from inside it.
+function draw() end
+
+-- Draws a sprite in screen space, unaffected by the camera. Lazy sprites are
+-- loaded in the background the first time they're drawn, and skipped until
+-- then.
+---@param key string The sprite's resource key
+---@param x number
+---@param y number
+---@param layer? integer Between 0 and 255, drawn back to front
+---@param depth? number Sorts within the layer, the sprite's bottom edge by default
+function draw_sprite(key, x, y, layer, depth) end
+
+-- Moves the camera entities are drawn through. It covers the whole screen.
+---@param x number The world position shown at the top left of the screen
+---@param y number
+---@param zoom? number Screen pixels per world unit, positive
+function set_camera(x, y, zoom) end
+
+-- Replaces a tile layer of the scene, or adds one right after the last.
+-- Tiles are numbered from 1 across the tileset sprite and then down, 0 being
+-- no tile.
+---@param index integer The layer, counted from 1
+---@param tileset string The sprite holding the tiles
+---@param tile_width integer
+---@param tile_height integer
+---@param rows integer[][] The tile numbers, row by row
+---@param layer? integer Between 0 and 255, just below the sprites by default
+---@return boolean set
+function set_tile_layer(index, tileset, tile_width, tile_height, rows, layer) end
+
+-- Changes a tile of a tile layer, 0 clearing it. Tiles out of range are
+-- ignored.
+---@param index integer The layer, counted from 1
+---@param x integer In tiles, counted from 0
+---@param y integer
+---@param tile integer
+---@return boolean set False if there's no such layer
+function set_tile(index, x, y, tile) end
+
+-- The tile number at a position of a tile layer, 0 for none or out of range.
+---@param index integer The layer, counted from 1
+---@param x integer In tiles, counted from 0
+---@param y integer
+---@return integer
+function get_tile(index, x, y) end
+
+-- Draws white text in screen space, unaffected by the camera. Only works
+-- from inside draw.
+---@param font string The font's resource key
+---@param text string UTF-8, with newlines starting new lines
+---@param x number
+---@param y number
+---@param size? integer In points, 16 by default and at most 256
+---@param layer? integer Between 0 and 255, above the sprites by default
+function draw_text(font, text, x, y, size, layer) end
+
+-- Spawns an entity at a world position. Ids are never reused, the entity
+-- functions do nothing once an entity is despawned.
+---@param x number
+---@param y number
+---@param sprite? string The sprite to draw it with
+---@param class? string The class to find it by
+---@return number? id Nil if there's no scene
+function spawn_entity(x, y, sprite, class) end
+
+-- Despawns an entity.
+---@param id number
+---@return boolean despawned False if it was gone already
+function despawn_entity(id) end
+
+-- Whether an entity is still there.
+---@param id number
+---@return boolean
+function entity_exists(id) end
+
+-- The world position of an entity.
+---@param id number
+---@return number? x Nil if the entity is gone
+---@return number? y
+function get_entity_position(id) end
+
+-- Moves an entity to a world position. It's teleported there unless
+-- `interpolate` is true, in which case it's drawn sliding over from where it
+-- was at the start of the tick.
+---@param id number
+---@param x number
+---@param y number
+---@param interpolate? boolean False by default
+---@return boolean moved False if the entity is gone
+function set_entity_position(id, x, y, interpolate) end
+
+-- The class of an entity.
+---@param id number
+---@return string? class Nil if the entity has none or is gone
+function get_entity_class(id) end
+
+-- Changes the class of an entity.
+---@param id number
+---@param class string? Nil takes the class away
+---@return boolean set False if the entity is gone
+function set_entity_class(id, class) end
+
+-- The entities of a class, in no particular order.
+---@param class string
+---@return number[] ids
+function find_entities(class) end
+
+---@enum CollissionPhase
+CollissionPhase = {
+    Enter = 0,
+    Stay = 1,
+    Exit = 2,
+}
+
+---@class CollissionEvent
+---@field x integer The middle of where the two overlap, or last did for exits
+---@field y integer
+---@field phase CollissionPhase
+---@field a number The id of one entity
+---@field b number The id of the other
+
+-- Called by the engine after every simulation tick with collissions, if the
+-- game defines it, with all of the tick's events at once.
+---@param events CollissionEvent[]
+function collide(events) end
+
+-- Gives an entity a rectangular collider, its top left at the entity's
+-- position. Two entities collide only if each one's layers are in the
+-- other's mask.
+---@param id number
+---@param width number
+---@param height number
+---@param layers? integer Bitset, layer 1 by default
+---@param mask? integer Bitset of the layers it collides with, all by default
+---@return boolean set False if the entity is gone
+function set_entity_rect_collider(id, width, height, layers, mask) end
+
+-- Gives an entity a circular collider, its bounds' top left at the entity's
+-- position. Layers work as with rectangular colliders.
+---@param id number
+---@param radius number
+---@param layers? integer
+---@param mask? integer
+---@return boolean set False if the entity is gone
+function set_entity_circle_collider(id, radius, layers, mask) end
+
+-- Takes an entity's collider away. Whatever it touched gets exit events.
+---@param id number
+function remove_entity_collider(id) end
@@ -0,0 +1,314 @@
+#include "Atlas.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <spdlog/logger.h>
+
+#include "Result.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+SkylinePacker::SkylinePacker(const int width, const int height)
+    : m_Width(width)
+    , m_Height(height)
+    , m_Skyline { Segment { .X = 0, .Y = 0, .Width = width } }
+    , m_UsedArea(0)
+{
+}
+
+std::optional<SDL_Rect> SkylinePacker::Insert(const int width, const int height)
+{
+    std::optional<size_t> bestIndex;
+    int bestTop = 0;
+    int bestX = 0;
+
+    for (size_t i = 0; i < m_Skyline.size(); i++) {
+        const auto y = Fit(i, width, height);
+        if (!y)
+            continue;
+
+        const int top = *y + height;
+        if (!bestIndex || top < bestTop || (top == bestTop && m_Skyline[i].X < bestX)) {
+            bestIndex = i;
+            bestTop = top;
+            bestX = m_Skyline[i].X;
+        }
+    }
+
+    if (!bestIndex)
+        return std::nullopt;
+
+    const SDL_Rect rect { bestX, bestTop - height, width, height };
+    Place(*bestIndex, rect);
+    m_UsedArea += static_cast<uint64_t>(width) * height;
+    return rect;
+}
+
+int SkylinePacker::GetUsedHeight() const
+{
+    int height = 0;
+    for (const auto& segment : m_Skyline)
+        height = std::max(height, segment.Y);
+    return height;
+}
+
+std::optional<int> SkylinePacker::Fit(const size_t index, const int width, const int height) const
+{
+    if (m_Skyline[index].X + width > m_Width)
+        return std::nullopt;
+
+    int y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0; i++) {
+        // The segments span the whole width, so this can't run off the end.
+        y = std::max(y, m_Skyline[i].Y);
+        if (y + height > m_Height)
+            return std::nullopt;
+        remaining -= m_Skyline[i].Width;
+    }
+    return y;
+}
+
+void SkylinePacker::Place(const size_t index, const SDL_Rect& rect)
+{
+    m_Skyline.insert(m_Skyline.begin() + index, Segment { .X = rect.x, .Y = rect.y + rect.h, .Width = rect.w });
+
+    // Cut the segments the new one now shadows.
+    for (size_t i = index + 1; i < m_Skyline.size();) {
+        const int shadowEnd = m_Skyline[i - 1].X + m_Skyline[i - 1].Width;
+        auto& segment = m_Skyline[i];
+        if (segment.X >= shadowEnd)
+            break;
+
+        const int overlap = shadowEnd - segment.X;
+        segment.X += overlap;
+        segment.Width -= overlap;
+        if (segment.Width > 0)
+            break;
+        m_Skyline.erase(m_Skyline.begin() + i);
+    }
+
+    for (size_t i = 0; i + 1 < m_Skyline.size();) {
+        if (m_Skyline[i].Y == m_Skyline[i + 1].Y) {
+            m_Skyline[i].Width += m_Skyline[i + 1].Width;
+            m_Skyline.erase(m_Skyline.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+}
+
+Atlas::~Atlas()
+{
+    Destroy();
+}
+
+Atlas::Atlas(Atlas&& other) noexcept
+    : m_Pages(std::move(other.m_Pages))
+    , m_Regions(std::move(other.m_Regions))
+    , m_Stats(other.m_Stats)
+    , m_Mirror(other.m_Mirror)
+{
+    other.m_Pages.clear();
+}
+
+Atlas& Atlas::operator=(Atlas&& other) noexcept
+{
+    if (this != &other) {
+        Destroy();
+        m_Pages = std::move(other.m_Pages);
+        m_Regions = std::move(other.m_Regions);
+        m_Stats = other.m_Stats;
+        m_Mirror = other.m_Mirror;
+        other.m_Pages.clear();
+    }
+    return *this;
+}
+
+void Atlas::Destroy()
+{
+    for (auto* page : m_Pages) {
+        if (m_Mirror)
+            m_Mirror->Remove(page);
+        SDL_DestroyTexture(page);
+    }
+    m_Pages.clear();
+}
+
+namespace {
+
+    // Copies `sprite` into `page` at `x`, `y` and repeats its outermost
+    // pixels `padding` times around it. Both are 32-bit surfaces.
+    void CopyExtruded(SDL_Surface* page, const SDL_Surface* sprite, const int x, const int y, const int padding)
+    {
+        const int width = sprite->w;
+        const int height = sprite->h;
+
+        for (int row = -padding; row < height + padding; row++) {
+            const int sourceRow = std::clamp(row, 0, height - 1);
+            const auto* source = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(sprite->pixels) + sourceRow * sprite->pitch);
+            auto* destination = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(page->pixels) + (y + row) * page->pitch) + x;
+
+            std::fill(destination - padding, destination, source[0]);
+            std::memcpy(destination, source, static_cast<size_t>(width) * sizeof(uint32_t));
+            std::fill(destination + width, destination + width + padding, source[width - 1]);
+        }
+    }
+
+} // namespace
+
+Result<Atlas> Atlas::Build(
+    const std::shared_ptr<spdlog::logger> logger,
+    SDL_Renderer* renderer,
+    const std::vector<SDL_Surface*>& sprites,
+    int pageSize,
+    const int padding,
+    TextureMirror* mirror
+)
+{
+    ENG_TRACE_ZONE("Atlas::Build");
+
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0 && info.max_texture_height > 0)
+        pageSize = std::min({ pageSize, info.max_texture_width, info.max_texture_height });
+
+    Atlas atlas;
+    atlas.m_Regions.resize(sprites.size());
+    atlas.m_Mirror = mirror;
+
+    // Tallest first packs a skyline tightest.
+    std::vector<size_t> order(sprites.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&sprites](const size_t a, const size_t b) {
+        if (sprites[a]->h != sprites[b]->h)
+            return sprites[a]->h > sprites[b]->h;
+        return sprites[a]->w > sprites[b]->w;
+    });
+
+    struct Placement {
+        size_t Sprite;
+        size_t Page;
+        SDL_Rect Rect;
+    };
+
+    std::vector<SkylinePacker> packers;
+    std::vector<Placement> placements;
+    uint64_t spriteArea = 0;
+
+    for (const size_t index : order) {
+        const int width = sprites[index]->w + 2 * padding;
+        const int height = sprites[index]->h + 2 * padding;
+        if (width > pageSize || height > pageSize || sprites[index]->w == 0 || sprites[index]->h == 0)
+            continue;
+
+        std::optional<SDL_Rect> rect;
+        size_t page = 0;
+        for (; page < packers.size() && !rect; page++)
+            rect = packers[page].Insert(width, height);
+        if (rect) {
+            page--;
+        } else {
+            packers.emplace_back(pageSize, pageSize);
+            rect = packers.back().Insert(width, height);
+        }
+
+        placements.push_back(Placement { .Sprite = index, .Page = page, .Rect = *rect });
+        spriteArea += static_cast<uint64_t>(sprites[index]->w) * sprites[index]->h;
+    }
+
+    uint64_t pageArea = 0;
+    for (size_t page = 0; page < packers.size(); page++) {
+        // Pages are cut down to what's used, which mostly trims the last one.
+        const int pageHeight = packers[page].GetUsedHeight();
+
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, pageSize, pageHeight, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!surface) {
+            logger->error("Couldn't create an atlas page: {}", SDL_GetError());
+            return Error(Error::Sdl, "Couldn't create an atlas page");
+        }
+        std::memset(surface->pixels, 0, static_cast<size_t>(surface->pitch) * pageHeight);
+
+        for (const auto& placement : placements) {
+            if (placement.Page != page)
+                continue;
+
+            SDL_Surface* sprite = sprites[placement.Sprite];
+            SDL_Surface* converted = nullptr;
+            if (sprite->format->format != SDL_PIXELFORMAT_RGBA32) {
+                converted = SDL_ConvertSurfaceFormat(sprite, SDL_PIXELFORMAT_RGBA32, 0);
+                if (!converted) {
+                    logger->error("Couldn't convert a sprite for the atlas: {}", SDL_GetError());
+                    SDL_FreeSurface(surface);
+                    return Error(Error::Sdl, "Couldn't convert a sprite for the atlas");
+                }
+                sprite = converted;
+            }
+
+            SDL_LockSurface(sprite);
+            CopyExtruded(surface, sprite, placement.Rect.x + padding, placement.Rect.y + padding, padding);
+            SDL_UnlockSurface(sprite);
+
+            if (converted)
+                SDL_FreeSurface(converted);
+        }
+
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        if (texture && mirror)
+            mirror->Add(texture, *surface);
+        SDL_FreeSurface(surface);
+        if (!texture) {
+            logger->error("Couldn't create an atlas texture: {}", SDL_GetError());
+            return Error(Error::Sdl, "Couldn't create an atlas texture");
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        atlas.m_Pages.push_back(texture);
+        pageArea += static_cast<uint64_t>(pageSize) * pageHeight;
+    }
+
+    for (const auto& placement : placements) {
+        atlas.m_Regions[placement.Sprite] = AtlasRegion {
+            .Texture = atlas.m_Pages[placement.Page],
+            .Rect = SDL_Rect {
+                placement.Rect.x + padding,
+                placement.Rect.y + padding,
+                placement.Rect.w - 2 * padding,
+                placement.Rect.h - 2 * padding,
+            },
+        };
+    }
+
+    atlas.m_Stats = AtlasStats {
+        .Sprites = placements.size(),
+        .Pages = atlas.m_Pages.size(),
+        .Occupancy = pageArea == 0 ? 0.0 : static_cast<double>(spriteArea) / pageArea,
+        .Bytes = static_cast<size_t>(pageArea * 4),
+    };
+
+    logger->info(
+        "Packed {} sprites into {} atlas pages of {} px, {:.1f}% occupied, {} textures saved",
+        atlas.m_Stats.Sprites,
+        atlas.m_Stats.Pages,
+        pageSize,
+        atlas.m_Stats.Occupancy * 100.0,
+        atlas.m_Stats.Sprites - atlas.m_Stats.Pages
+    );
+    if (placements.size() != sprites.size())
+        logger->debug("{} sprites didn't fit an atlas page", sprites.size() - placements.size());
+
+    return Result(std::move(atlas));
+}
+
+} // namespace engine
@@ -0,0 +1,105 @@
+#ifndef ENG_ATLAS_HPP
+#define ENG_ATLAS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <spdlog/logger.h>
+
+#include "Result.hpp"
+#include "TextureMirror.hpp"
+
+namespace engine {
+
+// Skyline bottom-left rectangle packer: keeps the top edge of everything
+// placed so far as a list of horizontal segments and puts each rectangle
+// where its top ends up lowest.
+class SkylinePacker final {
+public:
+    SkylinePacker(const int width, const int height);
+    ~SkylinePacker() = default;
+
+    std::optional<SDL_Rect> Insert(const int width, const int height);
+
+    // The lowest height the packed rectangles fit in.
+    int GetUsedHeight() const;
+    inline uint64_t GetUsedArea() const { return m_UsedArea; }
+
+private:
+    struct Segment {
+        int X;
+        int Y;
+        int Width;
+    };
+
+    int m_Width;
+    int m_Height;
+    std::vector<Segment> m_Skyline;
+    uint64_t m_UsedArea;
+
+    // Top of a `width` wide rectangle placed at segment `index`, or nullopt
+    // if it doesn't fit there.
+    std::optional<int> Fit(const size_t index, const int width, const int height) const;
+    void Place(const size_t index, const SDL_Rect& rect);
+};
+
+struct AtlasRegion {
+    SDL_Texture* Texture;
+    SDL_Rect Rect;
+};
+
+struct AtlasStats {
+    size_t Sprites;
+    size_t Pages;
+    // Sprite area over page area, in the range 0-1.
+    double Occupancy;
+    size_t Bytes;
+};
+
+// A few large textures ("pages") holding many sprites. Every sprite is
+// surrounded by `padding` pixels copied from its own edges, so filtering at
+// its border never samples a neighbour. Owns the pages.
+class Atlas final {
+public:
+    Atlas() = default;
+    ~Atlas();
+
+    Atlas(const Atlas&) = delete;
+    Atlas& operator=(const Atlas&) = delete;
+    Atlas(Atlas&& other) noexcept;
+    Atlas& operator=(Atlas&& other) noexcept;
+
+    // Packs `sprites`, largest first, into pages of at most `pageSize`
+    // squared (clamped to what `renderer` supports). Sprites too big for a
+    // page get no region and are left to the caller. The surfaces are only
+    // read. Pages are copied into `mirror` while they live, if given.
+    static Result<Atlas> Build(
+        const std::shared_ptr<spdlog::logger> logger,
+        SDL_Renderer* renderer,
+        const std::vector<SDL_Surface*>& sprites,
+        int pageSize,
+        const int padding,
+        TextureMirror* mirror = nullptr
+    );
+
+    // Indexed like the `sprites` passed to `Build`.
+    inline const std::optional<AtlasRegion>& GetRegion(const size_t index) const { return m_Regions[index]; }
+    inline const AtlasStats& GetStats() const { return m_Stats; }
+
+private:
+    std::vector<SDL_Texture*> m_Pages;
+    std::vector<std::optional<AtlasRegion>> m_Regions;
+    AtlasStats m_Stats {};
+    TextureMirror* m_Mirror = nullptr;
+
+    void Destroy();
+};
+
+} // namespace engine
+
+#endif // !ENG_ATLAS_HPP
@@ -0,0 +1,861 @@
+// eng-bench: micro-benchmarks of engine subsystems, run headless.
+//
+//   eng-bench sprites [sprite count...]
+//   eng-bench raster [sprite count...]
+//   eng-bench entities [entity count...]
+//   eng-bench collissions [collider count...]
+//   eng-bench narrow [pair count...]
+//   eng-bench streaming [sprite count...]
+//   eng-bench tiles [layer size in tiles...]
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_stdinc.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_video.h>
+#include <spdlog/logger.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include "ChunkCache.hpp"
+#include "Clock.hpp"
+#include "CollissionSystem.hpp"
+#include "Components.hpp"
+#include "Config.hpp"
+#include "EntityStore.hpp"
+#include "Game.hpp"
+#include "NarrowPhase.hpp"
+#include "RenderQueue.hpp"
+#include "ResourceManager.hpp"
+#include "Simd.hpp"
+#include "SoftwareRasterizer.hpp"
+#include "SpriteBatch.hpp"
+#include "SpriteStreamer.hpp"
+#include "StringInterner.hpp"
+#include "Task.hpp"
+#include "TextureMirror.hpp"
+#include "TextureUpload.hpp"
+#include "Tilemap.hpp"
+#include "Vector2.hpp"
+
+namespace {
+
+using namespace engine;
+
+constexpr int ScreenWidth = 1280;
+constexpr int ScreenHeight = 720;
+constexpr unsigned int FramesPerRun = 20;
+
+std::vector<size_t> ParseCounts(const std::shared_ptr<spdlog::logger> logger, const std::vector<std::string_view>& args, std::vector<size_t> defaults)
+{
+    if (args.empty())
+        return defaults;
+
+    std::vector<size_t> counts;
+    for (const auto arg : args) {
+        size_t count = 0;
+        auto [_, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), count);
+        if (ec != std::errc() || count == 0) {
+            logger->error("Invalid count: {}", arg);
+            return {};
+        }
+        counts.push_back(count);
+    }
+    return counts;
+}
+
+// Median milliseconds per call of `frame`.
+double MeasureFrames(const std::function<void()>& frame)
+{
+    std::vector<double> samples;
+    for (unsigned int i = 0; i < FramesPerRun; i++) {
+        const auto begin = Clock::now();
+        frame();
+        samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+struct BenchSprite {
+    SDL_Rect Source;
+    SDL_FRect Destination;
+};
+
+int BenchSprites(const std::shared_ptr<spdlog::logger> logger, const std::vector<size_t>& counts)
+{
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        logger->error("SDL init failed: {}", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Window* window = SDL_CreateWindow("eng-bench", 0, 0, ScreenWidth, ScreenHeight, 0);
+    SDL_Renderer* renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE) : nullptr;
+    // A 2x2 atlas of 32 px sprites, like the resource manager produces.
+    SDL_Texture* texture = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, 64, 64) : nullptr;
+    if (!texture) {
+        logger->error("Couldn't set up rendering: {}", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    std::vector<uint32_t> pixels(64 * 64, 0xff8040ff);
+    SDL_UpdateTexture(texture, nullptr, pixels.data(), 64 * sizeof(uint32_t));
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    SpriteBatch batch(renderer);
+    std::mt19937 random(42);
+
+    for (const size_t count : counts) {
+        std::uniform_real_distribution<float> x(0.0f, ScreenWidth - 32.0f);
+        std::uniform_real_distribution<float> y(0.0f, ScreenHeight - 32.0f);
+        std::uniform_int_distribution<int> region(0, 3);
+
+        std::vector<BenchSprite> sprites(count);
+        for (auto& sprite : sprites) {
+            const int index = region(random);
+            sprite.Source = SDL_Rect { (index % 2) * 32, (index / 2) * 32, 32, 32 };
+            sprite.Destination = SDL_FRect { x(random), y(random), 32.0f, 32.0f };
+        }
+
+        const double copyMs = MeasureFrames([&] {
+            SDL_RenderClear(renderer);
+            for (const auto& sprite : sprites)
+                SDL_RenderCopyF(renderer, texture, &sprite.Source, &sprite.Destination);
+            SDL_RenderPresent(renderer);
+        });
+
+        const double batchMs = MeasureFrames([&] {
+            batch.ResetStats();
+            SDL_RenderClear(renderer);
+            for (const auto& sprite : sprites)
+                batch.Draw(texture, sprite.Source, sprite.Destination);
+            batch.Flush();
+            SDL_RenderPresent(renderer);
+        });
+
+        const auto& stats = batch.GetStats();
+        logger->info(
+            "{:7} sprites: SDL_RenderCopy {:8.2f} ms ({} draw calls), batched {:8.2f} ms ({} draw calls, {} vertices), {:.2f}x",
+            count, copyMs, count, batchMs, stats.DrawCalls, stats.Vertices, batchMs == 0.0 ? 0.0 : copyMs / batchMs
+        );
+    }
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
+
+// FNV-1a over the frame, to tell whether two kernel levels agree.
+uint64_t HashFrame(const SoftwareRasterizer& rasterizer)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    const size_t count = static_cast<size_t>(rasterizer.GetWidth()) * rasterizer.GetHeight();
+    for (size_t i = 0; i < count; i++) {
+        hash ^= rasterizer.GetPixels()[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+int BenchRaster(const std::shared_ptr<spdlog::logger> logger, const std::vector<size_t>& counts)
+{
+    auto tasks = TaskDispatcher::New(logger);
+    if (tasks.IsErr()) {
+        logger->error("Couldn't start the task workers: {}", tasks.UnwrapErr().ToString());
+        return 1;
+    }
+
+    // A 2x2 atlas of 32 px sprites with soft edges, so every blend path
+    // sees partial alpha. The rasterizer only needs the CPU copy, keyed by
+    // a handle that's never dereferenced.
+    TextureMirror mirror;
+    int handle = 0;
+    auto* texture = reinterpret_cast<SDL_Texture*>(&handle);
+    std::vector<uint32_t> pixels(64 * 64);
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            const auto alpha = static_cast<uint32_t>(std::min({ x % 32, 31 - x % 32, y % 32, 31 - y % 32 }) * 32);
+            pixels[y * 64 + x] = std::min<uint32_t>(alpha, 255) << 24 | static_cast<uint32_t>(x * 4) << 16 | static_cast<uint32_t>(y * 4) << 8 | 0x40;
+        }
+    }
+    mirror.Create(texture, 64, 64);
+    mirror.Update(texture, SDL_Rect { 0, 0, 64, 64 }, pixels.data(), 64 * sizeof(uint32_t));
+
+    SoftwareRasterizer rasterizer(mirror, simd::Level::Scalar);
+    rasterizer.Resize(ScreenWidth, ScreenHeight);
+    std::mt19937 random(42);
+
+    for (const size_t count : counts) {
+        std::uniform_real_distribution<float> x(-16.0f, ScreenWidth - 16.0f);
+        std::uniform_real_distribution<float> y(-16.0f, ScreenHeight - 16.0f);
+        std::uniform_real_distribution<float> size(16.0f, 64.0f);
+        std::uniform_int_distribution<int> region(0, 3);
+        std::uniform_int_distribution<int> kind(0, 15);
+
+        RenderQueue queue;
+        double area = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            const int index = region(random);
+            const int variant = kind(random);
+            const float side = size(random);
+            // Mostly alpha blended, with some of every other mode, tinted
+            // and rotated sprites.
+            const BlendMode blend = variant == 0 ? BlendMode::Add : variant == 1 ? BlendMode::Modulate : variant == 2 ? BlendMode::None : BlendMode::Blend;
+            const SDL_Color color = variant == 3 ? SDL_Color { 255, 128, 64, 160 } : SDL_Color { 255, 255, 255, 255 };
+            const float rotation = variant == 4 ? 30.0f : 0.0f;
+            queue.Submit(
+                renderKey::DefaultLayer,
+                renderKey::ClampDepth(i),
+                texture,
+                SDL_Rect { (index % 2) * 32, (index / 2) * 32, 32, 32 },
+                SDL_FRect { x(random), y(random), side, side },
+                color,
+                rotation,
+                blend
+            );
+            area += static_cast<double>(side) * side;
+        }
+        queue.Sort();
+
+        std::string report;
+        uint64_t reference = 0;
+        for (int level = 0; level <= static_cast<int>(simd::GetLevel()); level++) {
+            rasterizer.SetLevel(static_cast<simd::Level>(level));
+            const double ms = MeasureFrames([&] { rasterizer.Draw(queue, tasks.Unwrap().get()); });
+            const uint64_t hash = HashFrame(rasterizer);
+            if (level == 0) {
+                reference = hash;
+            } else if (hash != reference) {
+                logger->error("{} kernels differ from the scalar ones at {} sprites", simd::ToString(rasterizer.GetLevel()), count);
+                return 1;
+            }
+            report += fmt::format(", {} {:7.2f} ms ({:6.0f} Mpx/s)", simd::ToString(rasterizer.GetLevel()), ms, ms == 0.0 ? 0.0 : area / ms / 1000.0);
+        }
+
+        const auto& stats = rasterizer.GetStats();
+        logger->info(
+            "{:7} sprites on {} threads, {} tiles, {} binned{}",
+            count, tasks.Unwrap()->GetWorkerCount() + 1, stats.Tiles, stats.Binned, report
+        );
+    }
+
+    return 0;
+}
+
+// The entity layout `EntityStore` replaced, every component inline.
+struct AosEntity {
+    unsigned int Id;
+    std::optional<std::string> Class;
+
+    Vector2 Position;
+
+    std::optional<Collission> CollisionComp;
+    std::optional<Sprite> SpriteComp;
+};
+
+int BenchEntities(const std::shared_ptr<spdlog::logger> logger, const std::vector<size_t>& counts)
+{
+    const Vector2 step(1, 1);
+    const Collission collission {
+        .RelativePosition = Vector2(),
+        .Type = CollissionType::Circular,
+        .Data = { .Circular = { .Radius = 8 } },
+    };
+    const Sprite sprite { .Texture = nullptr, .Source = SDL_Rect { 0, 0, 32, 32 } };
+    const Symbol enemy = StringInterner::Global().Intern("enemy");
+    const Symbol bullet = StringInterner::Global().Intern("bullet");
+
+    for (const size_t count : counts) {
+        // Every entity has a class and a position, every other one is an
+        // enemy with a collission shape too, the rest bullets.
+        std::vector<AosEntity> entities(count);
+        EntityStore store;
+        store.Reserve(count);
+        std::vector<EntityId> ids(count);
+        for (size_t i = 0; i < count; i++) {
+            auto& entity = entities[i];
+            entity.Id = static_cast<unsigned int>(i);
+            entity.Class = i % 2 == 0 ? "enemy" : "bullet";
+            entity.Position = Vector2(static_cast<unsigned int>(i), 0);
+            if (i % 2 == 0)
+                entity.CollisionComp = collission;
+
+            ids[i] = i % 2 == 0
+                ? store.Create(Transform { entity.Position, entity.Position }, EntityClass { enemy }, Collission(collission))
+                : store.Create(Transform { entity.Position, entity.Position }, EntityClass { bullet });
+        }
+
+        const double aosIterateMs = MeasureFrames([&] {
+            for (auto& entity : entities)
+                entity.Position += step;
+        });
+        const double storeIterateMs = MeasureFrames([&] {
+            store.Each<Transform>([&step](const EntityId, Transform& transform) {
+                transform.Position += step;
+            });
+        });
+
+        // Gives every entity a sprite and takes it away again.
+        const double aosChangeMs = MeasureFrames([&] {
+            for (auto& entity : entities)
+                entity.SpriteComp = sprite;
+            for (auto& entity : entities)
+                entity.SpriteComp.reset();
+        });
+        const double storeChangeMs = MeasureFrames([&] {
+            for (const EntityId id : ids)
+                store.Add(id, sprite);
+            for (const EntityId id : ids)
+                store.Remove<Sprite>(id);
+        });
+
+        // Despawns every other entity and spawns as many, like a wave of
+        // bullets. Erasing from the middle of the vector would be quadratic,
+        // so there's no AoS figure.
+        const double storeChurnMs = MeasureFrames([&] {
+            for (size_t i = 1; i < count; i += 2)
+                store.Destroy(ids[i]);
+            for (size_t i = 1; i < count; i += 2)
+                ids[i] = store.Create(Transform { step, step }, EntityClass { bullet });
+        });
+
+        // Moves every bullet, found by scanning and comparing names or from
+        // the class index.
+        const double aosQueryMs = MeasureFrames([&] {
+            for (auto& entity : entities) {
+                if (entity.Class == "bullet")
+                    entity.Position += step;
+            }
+        });
+        const double storeQueryMs = MeasureFrames([&] {
+            for (const EntityId id : store.GetClass(bullet))
+                store.Find<Transform>(id)->Position += step;
+        });
+
+        // What the class costs per entity: the optional string and whatever
+        // it allocated, against the symbol, its place in the class index and
+        // the slot's position in that.
+        const size_t inlineCapacity = std::string().capacity();
+        size_t stringBytes = 0;
+        for (const auto& entity : entities) {
+            stringBytes += sizeof(entity.Class);
+            if (entity.Class.has_value() && entity.Class->capacity() > inlineCapacity)
+                stringBytes += entity.Class->capacity() + 1;
+        }
+        const double stringPerEntity = static_cast<double>(stringBytes) / static_cast<double>(count);
+        const double symbolPerEntity = static_cast<double>(sizeof(EntityClass) + sizeof(EntityId) + sizeof(uint32_t));
+
+        logger->info(
+            "{:8} entities: position iteration AoS {:8.3f} ms, SoA {:8.3f} ms ({:.2f}x); sprite add/remove AoS {:8.3f} ms, SoA {:8.3f} ms; "
+            "despawn/respawn half {:8.3f} ms ({} archetypes); class query scan {:8.3f} ms, index {:8.3f} ms; "
+            "class {:.1f} B/entity as a string, {:.1f} B as a symbol, {:.1f} KiB saved",
+            count, aosIterateMs, storeIterateMs, storeIterateMs == 0.0 ? 0.0 : aosIterateMs / storeIterateMs,
+            aosChangeMs, storeChangeMs, storeChurnMs, store.GetArchetypeCount(), aosQueryMs, storeQueryMs,
+            stringPerEntity, symbolPerEntity, (stringPerEntity - symbolPerEntity) * static_cast<double>(count) / 1024.0
+        );
+    }
+
+    return 0;
+}
+
+int BenchCollissions(const std::shared_ptr<spdlog::logger> logger, const std::vector<size_t>& counts)
+{
+    std::mt19937 random(42);
+
+    for (const size_t count : counts) {
+        // Circles and squares of 8-24 px at the same density at every
+        // count, on four layers. Every fourth collider only collides with
+        // its own layer.
+        const auto side = static_cast<unsigned int>(std::sqrt(static_cast<double>(count)) * 48.0);
+        EntityStore store;
+        store.Reserve(count);
+        std::vector<EntityId> ids(count);
+        for (size_t i = 0; i < count; i++) {
+            const unsigned int size = 8 + random() % 17;
+            const uint32_t layer = 1u << (random() % 4);
+            Collission collission {
+                .RelativePosition = Vector2(),
+                .Type = i % 2 == 0 ? CollissionType::Circular : CollissionType::Rectangular,
+                .Data = { .Rectangular = { .Width = size, .Height = size } },
+                .Layers = layer,
+                .Mask = i % 4 == 3 ? layer : UINT32_MAX,
+            };
+            if (collission.Type == CollissionType::Circular)
+                collission.Data.Circular = CircularCollission { .Radius = size / 2 };
+            const Vector2 position(1 + random() % side, 1 + random() % side);
+            ids[i] = store.Create(Transform { position, position }, std::move(collission));
+        }
+
+        // Everything moves a pixel back and forth, so pairs enter and exit.
+        CollissionSystem collissions;
+        unsigned int frame = 0;
+        const Vector2 step(1, 1);
+        const double updateMs = MeasureFrames([&] {
+            store.Each<Transform>([&](const EntityId, Transform& transform) {
+                transform.Position = frame % 2 == 0 ? transform.Position + step : transform.Position - step;
+            });
+            frame++;
+            collissions.Update(store);
+        });
+        const auto& stats = collissions.GetStats();
+
+        // Every pair's layers and bounds, the way there'd be no broad phase.
+        // Quadratic, so only for the smaller counts.
+        double pairwiseMs = 0.0;
+        size_t pairwiseOverlaps = 0;
+        if (count <= 10'000) {
+            struct Bounds {
+                int Left;
+                int Top;
+                int Right;
+                int Bottom;
+                uint32_t Layers;
+                uint32_t Mask;
+            };
+            std::vector<Bounds> bounds;
+            store.Each<Transform, Collission>([&](const EntityId, const Transform& transform, const Collission& collission) {
+                const auto size = static_cast<int>(collission.Type == CollissionType::Circular
+                        ? collission.Data.Circular.Radius * 2
+                        : collission.Data.Rectangular.Width);
+                const auto left = static_cast<int>(transform.Position.X);
+                const auto top = static_cast<int>(transform.Position.Y);
+                bounds.push_back(Bounds { left, top, left + size, top + size, collission.Layers, collission.Mask });
+            });
+            pairwiseMs = MeasureFrames([&] {
+                pairwiseOverlaps = 0;
+                for (size_t i = 0; i < bounds.size(); i++) {
+                    const auto& a = bounds[i];
+                    for (size_t j = i + 1; j < bounds.size(); j++) {
+                        const auto& b = bounds[j];
+                        if ((a.Layers & b.Mask) != 0 && (b.Layers & a.Mask) != 0
+                            && a.Left < b.Right && b.Left < a.Right && a.Top < b.Bottom && b.Top < a.Bottom)
+                            pairwiseOverlaps++;
+                    }
+                }
+            });
+        }
+
+        logger->info(
+            "{:8} colliders: update {:8.3f} ms ({:.0f} colliders/s); {} cell entries, {} pairs pruned by layer, {} candidates, {} contacts, {} events; "
+            "pairwise {}",
+            count, updateMs, updateMs == 0.0 ? 0.0 : static_cast<double>(count) * 1000.0 / updateMs,
+            stats.Cells, stats.Pruned, stats.Candidates, stats.Contacts, collissions.GetEvents().size(),
+            count <= 10'000 ? fmt::format("{:8.3f} ms ({} overlaps)", pairwiseMs, pairwiseOverlaps) : std::string("skipped")
+        );
+    }
+
+    return 0;
+}
+
+int BenchNarrow(const std::shared_ptr<spdlog::logger> logger, const std::vector<size_t>& counts)
+{
+    std::mt19937 random(42);
+    // Pixel and half pixel coordinates like the collission system's, close
+    // enough that about a tenth of the pairs touch and some only share an
+    // edge.
+    std::uniform_int_distribution<int> position(0, 399);
+    std::uniform_int_distribution<int> extent(1, 79);
+    const auto next = [&](std::uniform_int_distribution<int>& distribution) {
+        return static_cast<float>(distribution(random)) * 0.5f;
+    };
+
+    for (const size_t count : counts) {
+        narrow::PairBatch pairs;
+        for (size_t i = 0; i < count; i++) {
+            const narrow::Shape a { next(position), next(position), next(extent), next(extent) };
+            const narrow::Shape b { next(position), next(position), next(extent), next(extent) };
+            pairs.Push(a, b);
+        }
+
+        constexpr const char* Names[] = { "rect-rect", "circle-circle", "rect-circle" };
+        std::vector<uint8_t> reference(count);
+        std::vector<uint8_t> touching(count);
+        for (size_t test = 0; test < 3; test++) {
+            std::string report;
+            size_t hits = 0;
+            for (int level = 0; level <= static_cast<int>(simd::GetLevel()); level++) {
+                const auto& kernels = narrow::GetKernels(static_cast<simd::Level>(level));
+                const narrow::PairTest kernel = test == 0 ? kernels.Rectangles : test == 1 ? kernels.Circles : kernels.RectangleCircle;
+                const double ms = MeasureFrames([&] { kernel(pairs, touching.data()); });
+                if (level == 0) {
+                    reference = touching;
+                    hits = static_cast<size_t>(std::count(reference.begin(), reference.end(), 1));
+                } else if (touching != reference) {
+                    logger->error("{} {} kernel differs from the scalar one at {} pairs", simd::ToString(kernels.Level), Names[test], count);
+                    return 1;
+                }
+                report += fmt::format(", {} {:7.3f} ms ({:7.1f} M pairs/s)", simd::ToString(kernels.Level), ms, ms == 0.0 ? 0.0 : static_cast<double>(count) / ms / 1000.0);
+            }
+
+            logger->info("{:8} {:13} pairs, {} touching{}", count, Names[test], hits, report);
+        }
+    }
+
+    return 0;
+}
+
+// Lazy sprites drawn by a script every frame, streamed in like the engine
+// does: the draws that miss are requested, decoded on the task workers and
+// uploaded within the frame budget. Compared with loading them all with
+// `Get` on first draw, stalling that frame.
+int BenchStreaming(const std::shared_ptr<spdlog::logger> logger, const std::vector<size_t>& counts)
+{
+    constexpr int SpriteSize = 128;
+    constexpr unsigned int FrameRate = 60;
+    constexpr unsigned int MaxFrames = FrameRate * 60;
+
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        logger->error("SDL init failed: {}", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Window* window = SDL_CreateWindow("eng-bench", 0, 0, ScreenWidth, ScreenHeight, 0);
+    SDL_Renderer* renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE) : nullptr;
+    auto tasks = TaskDispatcher::New(logger);
+    if (!renderer || tasks.IsErr()) {
+        logger->error("Couldn't set up streaming: {}", renderer ? tasks.UnwrapErr().ToString() : SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    const Config cfg = Config::Default();
+    const auto root = std::filesystem::temp_directory_path() / "eng-bench-streaming";
+    std::error_code ec;
+    std::filesystem::create_directories(root, ec);
+
+    const size_t maxCount = *std::max_element(counts.begin(), counts.end());
+    game::ResourceTable table;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, SpriteSize, SpriteSize, 32, SDL_PIXELFORMAT_RGBA32);
+    for (size_t i = 0; surface && i < maxCount; i++) {
+        SDL_FillRect(surface, nullptr, SDL_MapRGBA(surface->format, static_cast<Uint8>(i), static_cast<Uint8>(i >> 8), 0x80, 0xff));
+        const auto source = fmt::format("sprite{}.bmp", i);
+        if (SDL_SaveBMP(surface, (root / source).string().c_str()) != 0)
+            break;
+        table.Entries.push_back(game::ResourceDef {
+            .Type = game::ResourceType::Sprite,
+            .Key = fmt::format("sprite{}", i),
+            .Source = source,
+            .Lazy = true,
+        });
+    }
+    if (surface)
+        SDL_FreeSurface(surface);
+
+    int status = 0;
+    if (table.Entries.size() != maxCount) {
+        logger->error("Couldn't write the sprites to {}: {}", root.string(), SDL_GetError());
+        status = 1;
+    }
+
+    TextureUploadQueue uploads(renderer, cfg.Render.UploadBudget);
+    for (const size_t count : counts) {
+        if (status != 0)
+            break;
+
+        game::ResourceTable drawn;
+        drawn.Entries.assign(table.Entries.begin(), table.Entries.begin() + static_cast<std::ptrdiff_t>(count));
+
+        auto resources = ResourceManager::New(logger, renderer, root, nullptr, tasks.Unwrap(), uploads, drawn, cfg);
+        if (resources.IsErr()) {
+            status = 1;
+            break;
+        }
+
+        SpriteStreamer streamer;
+        std::unordered_map<std::string, Sprite> drawable;
+        std::vector<std::string> requests;
+        FramePacer pacer(FrameRate);
+        double longestMs = 0.0;
+        unsigned int frames = 0;
+        const auto begin = Clock::now();
+        while (drawable.size() < count && frames < MaxFrames) {
+            const auto frameBegin = Clock::now();
+
+            requests.clear();
+            for (const auto& def : drawn.Entries) {
+                if (!drawable.contains(def.Key))
+                    requests.push_back(def.Key);
+            }
+            streamer.Request(*resources.Unwrap(), requests);
+            uploads.Process();
+            streamer.Collect([&](const std::string& key, const Sprite& sprite) {
+                drawable.emplace(key, sprite);
+            });
+
+            longestMs = std::max(longestMs, std::chrono::duration<double, std::milli>(Clock::now() - frameBegin).count());
+            frames++;
+            pacer.Wait();
+        }
+        const double streamedMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        const auto stats = streamer.GetStats();
+        streamer.Clear();
+
+        auto synchronous = ResourceManager::New(logger, renderer, root, nullptr, tasks.Unwrap(), uploads, drawn, cfg);
+        if (synchronous.IsErr()) {
+            status = 1;
+            break;
+        }
+        const auto stallBegin = Clock::now();
+        std::vector<ResourceHandle> handles;
+        for (const auto& def : drawn.Entries) {
+            if (auto handle = synchronous.Unwrap()->Get(def.Key); handle.IsOk())
+                handles.push_back(handle.UnwrapMove());
+        }
+        const double stallMs = std::chrono::duration<double, std::milli>(Clock::now() - stallBegin).count();
+        handles.clear();
+
+        logger->info(
+            "{:6} sprites: streamed in {} frames over {:8.2f} ms, longest frame {:7.2f} ms ({} failed); loaded on first draw in one {:8.2f} ms frame",
+            count, frames, streamedMs, longestMs, stats.Failed + stats.Loading, stallMs
+        );
+    }
+
+    std::filesystem::remove_all(root, ec);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return status;
+}
+
+// A square tile layer scrolling by under the screen, a few tiles changing
+// every frame, drawn tile by tile and from chunks cached as textures like
+// the rendering engine does. Both are checked to draw the same first.
+int BenchTiles(const std::shared_ptr<spdlog::logger> logger, const std::vector<size_t>& sizes)
+{
+    constexpr int TileSize = 16;
+    constexpr int EditsPerFrame = 4;
+
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        logger->error("SDL init failed: {}", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Window* window = SDL_CreateWindow("eng-bench", 0, 0, ScreenWidth, ScreenHeight, 0);
+    SDL_Renderer* renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE) : nullptr;
+    // A 4x4 tileset.
+    SDL_Texture* texture = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, TileSize * 4, TileSize * 4) : nullptr;
+    if (!texture) {
+        logger->error("Couldn't set up rendering: {}", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    // Every other row is semi-transparent, so cached chunks have to blend
+    // the same as tiles drawn directly.
+    std::vector<uint32_t> pixels(TileSize * 4 * TileSize * 4);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        const uint32_t alpha = (i / (TileSize * 4)) % 2 == 0 ? 0xff : static_cast<uint32_t>(i * 40503u) & 0xff;
+        pixels[i] = alpha << 24 | (static_cast<uint32_t>(i * 2654435761u) >> 8);
+    }
+    SDL_UpdateTexture(texture, nullptr, pixels.data(), TileSize * 4 * sizeof(uint32_t));
+
+    const Tileset tileset {
+        .Texture = texture,
+        .Source = SDL_Rect { 0, 0, TileSize * 4, TileSize * 4 },
+        .TileWidth = TileSize,
+        .TileHeight = TileSize,
+    };
+
+    SpriteBatch batch(renderer);
+    ChunkCache cache(renderer, batch, Config::Default().Render.ChunkCacheBudget);
+    if (!cache.IsEnabled())
+        logger->warn("The renderer has no render targets, chunks are drawn tile by tile");
+    // The view is drawn into it both ways and read back to compare them.
+    SDL_Texture* screen = cache.IsEnabled()
+        ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, ScreenWidth, ScreenHeight)
+        : nullptr;
+    std::vector<uint32_t> direct(static_cast<size_t>(ScreenWidth) * ScreenHeight);
+    std::vector<uint32_t> cached(direct.size());
+    int status = 0;
+    std::mt19937 random(42);
+    std::vector<TileChunkInstance> chunks;
+
+    for (const size_t size : sizes) {
+        const int tiles = static_cast<int>(std::min<size_t>(size, 1 << 14));
+        std::uniform_int_distribution<int> tile(EmptyTile, 16);
+        std::uniform_int_distribution<int> coordinate(0, tiles - 1);
+
+        TileLayer layer(tiles, tiles, tileset, renderKey::DefaultLayer - 1);
+        for (int y = 0; y < tiles; y++) {
+            for (int x = 0; x < tiles; x++)
+                layer.SetTile(x, y, static_cast<TileId>(tile(random)));
+        }
+
+        // Scrolls diagonally, wrapping around the layer.
+        const int span = std::max(tiles * TileSize - std::max(ScreenWidth, ScreenHeight), 1);
+        int scroll = 0;
+        const auto prepare = [&] {
+            scroll = (scroll + 7) % span;
+            for (int i = 0; i < EditsPerFrame; i++)
+                layer.SetTile(coordinate(random), coordinate(random), static_cast<TileId>(tile(random)));
+            chunks.clear();
+            layer.GetChunks(SDL_Rect { scroll, scroll, ScreenWidth, ScreenHeight }, chunks);
+            SDL_RenderClear(renderer);
+        };
+        const auto toScreen = [&](const SDL_Rect& bounds) {
+            return SDL_FRect {
+                static_cast<float>(bounds.x - scroll),
+                static_cast<float>(bounds.y - scroll),
+                static_cast<float>(bounds.w),
+                static_cast<float>(bounds.h),
+            };
+        };
+
+        const auto drawTiles = [&] {
+            for (const auto& chunk : chunks) {
+                const SDL_FRect dest = toScreen(chunk.Bounds);
+                for (int y = 0; y < TileChunk::Size; y++) {
+                    for (int x = 0; x < TileChunk::Size; x++) {
+                        const TileId id = chunk.Tiles->Tiles[y * TileChunk::Size + x];
+                        if (id == EmptyTile)
+                            continue;
+                        const SDL_FRect tileDest { dest.x + x * TileSize, dest.y + y * TileSize, TileSize, TileSize };
+                        batch.Draw(chunk.Set.Texture, chunk.Set.GetTileSource(id), tileDest);
+                    }
+                }
+            }
+            batch.Flush();
+        };
+        const auto drawChunks = [&] {
+            cache.BeginFrame();
+            for (const auto& chunk : chunks) {
+                if (SDL_Texture* chunkTexture = cache.Get(chunk))
+                    batch.Draw(chunkTexture, SDL_Rect { 0, 0, chunk.Bounds.w, chunk.Bounds.h }, toScreen(chunk.Bounds));
+            }
+            batch.Flush();
+            cache.Trim();
+        };
+
+        if (screen) {
+            const auto capture = [&](const std::function<void()>& draw, std::vector<uint32_t>& out) {
+                SDL_SetRenderTarget(renderer, screen);
+                SDL_SetRenderDrawColor(renderer, 64, 96, 128, 255);
+                SDL_RenderClear(renderer);
+                draw();
+                SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, out.data(), ScreenWidth * static_cast<int>(sizeof(uint32_t)));
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                SDL_SetRenderTarget(renderer, nullptr);
+            };
+            prepare();
+            capture(drawTiles, direct);
+            capture(drawChunks, cached);
+
+            // Off by one is left to rounding.
+            const auto differs = [](const uint32_t a, const uint32_t b) {
+                for (int shift = 0; shift < 32; shift += 8) {
+                    if (std::abs(static_cast<int>(a >> shift & 0xff) - static_cast<int>(b >> shift & 0xff)) > 1)
+                        return true;
+                }
+                return false;
+            };
+            const auto mismatch = std::mismatch(direct.begin(), direct.end(), cached.begin(), [&](const uint32_t a, const uint32_t b) { return !differs(a, b); });
+            if (mismatch.first != direct.end()) {
+                const auto i = static_cast<size_t>(mismatch.first - direct.begin());
+                logger->error("Cached chunks differ from tiles drawn directly at {}, {}: {:08x} instead of {:08x}", i % ScreenWidth, i / ScreenWidth, cached[i], direct[i]);
+                status = 1;
+                break;
+            }
+        }
+
+        const double tileMs = MeasureFrames([&] {
+            prepare();
+            drawTiles();
+            SDL_RenderPresent(renderer);
+        });
+
+        size_t renders = 0;
+        const double cachedMs = MeasureFrames([&] {
+            prepare();
+            drawChunks();
+            SDL_RenderPresent(renderer);
+            renders = cache.GetStats().Renders;
+        });
+
+        logger->info(
+            "{:5}x{:<5} tiles, {:3} chunks in view: tile by tile {:8.2f} ms, cached chunks {:8.2f} ms ({} redrawn last frame, {} cached, {:.2f}x)",
+            tiles, tiles, chunks.size(), tileMs, cachedMs, renders, cache.GetStats().Textures, cachedMs == 0.0 ? 0.0 : tileMs / cachedMs
+        );
+    }
+
+    cache.Clear();
+    if (screen)
+        SDL_DestroyTexture(screen);
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return status;
+}
+
+} // namespace
+
+int main(const int argc, const char** argv)
+{
+    auto logger = spdlog::stdout_color_mt("console");
+    logger->set_pattern("\033[90m%Y-%m-%d %H:%M:%S t%t %^[%l]%$ %v");
+
+    const std::vector<std::string_view> args(argv + 1, argv + argc);
+    if (!args.empty()) {
+        const std::vector<std::string_view> rest(args.begin() + 1, args.end());
+
+        if (args[0] == "sprites") {
+            const auto counts = ParseCounts(logger, rest, { 10'000, 50'000, 100'000 });
+            return counts.empty() ? 1 : BenchSprites(logger, counts);
+        }
+        if (args[0] == "raster") {
+            const auto counts = ParseCounts(logger, rest, { 1'000, 10'000, 50'000 });
+            return counts.empty() ? 1 : BenchRaster(logger, counts);
+        }
+        if (args[0] == "entities") {
+            const auto counts = ParseCounts(logger, rest, { 10'000, 100'000, 1'000'000 });
+            return counts.empty() ? 1 : BenchEntities(logger, counts);
+        }
+        if (args[0] == "collissions") {
+            const auto counts = ParseCounts(logger, rest, { 1'000, 10'000, 100'000 });
+            return counts.empty() ? 1 : BenchCollissions(logger, counts);
+        }
+        if (args[0] == "narrow") {
+            const auto counts = ParseCounts(logger, rest, { 100'000, 1'000'000 });
+            return counts.empty() ? 1 : BenchNarrow(logger, counts);
+        }
+        if (args[0] == "streaming") {
+            const auto counts = ParseCounts(logger, rest, { 100, 500 });
+            return counts.empty() ? 1 : BenchStreaming(logger, counts);
+        }
+        if (args[0] == "tiles") {
+            const auto sizes = ParseCounts(logger, rest, { 256, 4'096 });
+            return sizes.empty() ? 1 : BenchTiles(logger, sizes);
+        }
+    }
+
+    logger->error("Usage: eng-bench sprites|raster [sprite count...], eng-bench entities [entity count...], "
+                  "eng-bench collissions [collider count...], eng-bench narrow [pair count...], "
+                  "eng-bench streaming [sprite count...], eng-bench tiles [layer size in tiles...]");
+    return 1;
+}
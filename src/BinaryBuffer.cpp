@@ -1,9 +1,14 @@
 #include "BinaryBuffer.hpp"
 
 #include <cstddef>
+#include <filesystem>
+#include <fstream>
 #include <iterator>
+#include <system_error>
 #include <vector>
 
+#include "Result.hpp"
+
 namespace engine {
 
 BinaryBuffer::BinaryBuffer()
@@ -16,6 +21,25 @@ BinaryBuffer::BinaryBuffer(const size_t initialCapacity)
     m_Bytes.reserve(initialCapacity);
 }
 
+Result<BinaryBuffer> BinaryBuffer::FromFile(const std::filesystem::path& path)
+{
+    std::error_code errCode;
+    const auto size = std::filesystem::file_size(path, errCode);
+    if (errCode)
+        return Error(Error::Io, "Couldn't stat the file");
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return Error(Error::Io, "Couldn't open the file");
+
+    BinaryBuffer buffer(size);
+    buffer.m_Bytes.resize(size);
+    if (!file.read(reinterpret_cast<char*>(buffer.m_Bytes.data()), static_cast<std::streamsize>(size)))
+        return Error(Error::Io, "Couldn't read the file");
+
+    return Result(std::move(buffer));
+}
+
 void BinaryBuffer::Push(const std::byte value)
 {
     m_Bytes.push_back(value);
@@ -2,8 +2,11 @@
 #define ENG_BINARY_BUFFER_HPP
 
 #include <cstddef>
+#include <filesystem>
 #include <vector>
 
+#include "Result.hpp"
+
 namespace engine {
 
 class BinaryBuffer final {
@@ -12,12 +15,21 @@ public:
     BinaryBuffer(const size_t initialCapacity);
     ~BinaryBuffer() = default;
 
+    BinaryBuffer(const BinaryBuffer&) = default;
+    BinaryBuffer(BinaryBuffer&&) = default;
+    BinaryBuffer& operator=(const BinaryBuffer&) = default;
+    BinaryBuffer& operator=(BinaryBuffer&&) = default;
+
+    static Result<BinaryBuffer> FromFile(const std::filesystem::path& path);
+
     void Push(const std::byte value);
     void Insert(const size_t pos, const std::byte value);
     void Remove(const size_t pos);
 
     void Reserve(const size_t count);
 
+    inline size_t GetSize() const { return m_Bytes.size(); }
+
     const std::vector<std::byte>& GetBytes() const;
     std::vector<std::byte>& GetBytes();
 
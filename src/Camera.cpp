@@ -0,0 +1,27 @@
+#include "Camera.hpp"
+
+#include <SDL2/SDL_rect.h>
+
+namespace engine {
+
+SDL_FRect Camera::GetView() const
+{
+    return SDL_FRect {
+        static_cast<float>(Position.X),
+        static_cast<float>(Position.Y),
+        Viewport.w / Zoom,
+        Viewport.h / Zoom,
+    };
+}
+
+SDL_FRect Camera::ToScreen(const SDL_FRect& world) const
+{
+    return SDL_FRect {
+        Viewport.x + (world.x - Position.X) * Zoom,
+        Viewport.y + (world.y - Position.Y) * Zoom,
+        world.w * Zoom,
+        world.h * Zoom,
+    };
+}
+
+} // namespace engine
@@ -0,0 +1,27 @@
+#ifndef ENG_CAMERA_HPP
+#define ENG_CAMERA_HPP
+
+#include <SDL2/SDL_rect.h>
+
+#include "Vector2.hpp"
+
+namespace engine {
+
+// Maps the world onto a part of the screen. Entity sprites are drawn
+// through it, script draw commands are in screen space.
+struct Camera {
+    // World position shown at the top left of the viewport.
+    Vector2 Position;
+    // Screen pixels per world unit.
+    float Zoom = 1.0f;
+    // Where on the screen the world is drawn.
+    SDL_Rect Viewport {};
+
+    // The part of the world inside the viewport.
+    SDL_FRect GetView() const;
+    SDL_FRect ToScreen(const SDL_FRect& world) const;
+};
+
+} // namespace engine
+
+#endif // !ENG_CAMERA_HPP
@@ -0,0 +1,146 @@
+#include "ChunkCache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <SDL2/SDL_blendmode.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+
+#include "Trace.hpp"
+
+namespace engine {
+
+ChunkCache::ChunkCache(SDL_Renderer* renderer, SpriteBatch& batch, const size_t budgetBytes)
+    : m_Renderer(renderer)
+    , m_Batch(batch)
+    , m_BudgetBytes(budgetBytes)
+    , m_Enabled(budgetBytes > 0 && SDL_RenderTargetSupported(renderer) == SDL_TRUE)
+    , m_Entries()
+    , m_Lru()
+    , m_Frame(0)
+    , m_Stats()
+{
+}
+
+ChunkCache::~ChunkCache()
+{
+    Clear();
+}
+
+void ChunkCache::BeginFrame()
+{
+    m_Frame++;
+    m_Stats.Renders = 0;
+    m_Stats.Evictions = 0;
+}
+
+SDL_Texture* ChunkCache::Get(const TileChunkInstance& chunk)
+{
+    if (!m_Enabled)
+        return nullptr;
+
+    auto it = m_Entries.find(chunk.Key);
+    if (it == m_Entries.end()) {
+        SDL_Texture* texture = SDL_CreateTexture(
+            m_Renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_TARGET,
+            chunk.Bounds.w,
+            chunk.Bounds.h
+        );
+        if (!texture)
+            return nullptr;
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+        m_Lru.push_front(chunk.Key);
+        const size_t bytes = static_cast<size_t>(chunk.Bounds.w) * chunk.Bounds.h * 4;
+        it = m_Entries.emplace(chunk.Key, Entry {
+            .Texture = texture,
+            .Version = chunk.Version,
+            .LastFrame = m_Frame,
+            .Bytes = bytes,
+            .LruPosition = m_Lru.begin(),
+        }).first;
+        m_Stats.Textures++;
+        m_Stats.Bytes += bytes;
+        Draw(texture, chunk);
+        return texture;
+    }
+
+    auto& entry = it->second;
+    m_Lru.splice(m_Lru.begin(), m_Lru, entry.LruPosition);
+    entry.LastFrame = m_Frame;
+    if (entry.Version != chunk.Version) {
+        entry.Version = chunk.Version;
+        Draw(entry.Texture, chunk);
+    }
+    return entry.Texture;
+}
+
+void ChunkCache::Trim()
+{
+    while (m_Stats.Bytes > m_BudgetBytes && !m_Lru.empty()) {
+        const auto victim = m_Entries.find(m_Lru.back());
+        if (victim->second.LastFrame == m_Frame)
+            break;
+
+        SDL_DestroyTexture(victim->second.Texture);
+        m_Stats.Bytes -= victim->second.Bytes;
+        m_Stats.Textures--;
+        m_Stats.Evictions++;
+        m_Entries.erase(victim);
+        m_Lru.pop_back();
+    }
+}
+
+void ChunkCache::Clear()
+{
+    for (auto& [key, entry] : m_Entries)
+        SDL_DestroyTexture(entry.Texture);
+    m_Entries.clear();
+    m_Lru.clear();
+    m_Stats.Textures = 0;
+    m_Stats.Bytes = 0;
+}
+
+void ChunkCache::Draw(SDL_Texture* texture, const TileChunkInstance& chunk)
+{
+    ENG_TRACE_ZONE("ChunkCache::Draw");
+
+    SDL_Texture* previous = SDL_GetRenderTarget(m_Renderer);
+    m_Batch.Flush();
+    SDL_SetRenderTarget(m_Renderer, texture);
+    SDL_SetRenderDrawColor(m_Renderer, 0, 0, 0, 0);
+    SDL_RenderClear(m_Renderer);
+
+    // Tiles never overlap, so they're copied as they are. Blending them
+    // into the cleared target would multiply their colour by alpha, and
+    // then again when the chunk is drawn.
+    const auto& set = chunk.Set;
+    SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+    SDL_GetTextureBlendMode(set.Texture, &blendMode);
+    SDL_SetTextureBlendMode(set.Texture, SDL_BLENDMODE_NONE);
+    for (int y = 0; y < TileChunk::Size; y++) {
+        for (int x = 0; x < TileChunk::Size; x++) {
+            const TileId tile = chunk.Tiles->Tiles[y * TileChunk::Size + x];
+            if (tile == EmptyTile)
+                continue;
+            const SDL_FRect destination {
+                static_cast<float>(x * set.TileWidth),
+                static_cast<float>(y * set.TileHeight),
+                static_cast<float>(set.TileWidth),
+                static_cast<float>(set.TileHeight),
+            };
+            m_Batch.Draw(set.Texture, set.GetTileSource(tile), destination);
+        }
+    }
+
+    m_Batch.Flush();
+    SDL_SetTextureBlendMode(set.Texture, blendMode);
+    SDL_SetRenderTarget(m_Renderer, previous);
+    m_Stats.Renders++;
+}
+
+} // namespace engine
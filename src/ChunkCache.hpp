@@ -0,0 +1,76 @@
+#ifndef ENG_CHUNK_CACHE_HPP
+#define ENG_CHUNK_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+#include <SDL2/SDL_render.h>
+
+#include "SpriteBatch.hpp"
+#include "Tilemap.hpp"
+
+namespace engine {
+
+struct ChunkCacheStats {
+    size_t Textures = 0;
+    size_t Bytes = 0;
+    // Counted since the last `BeginFrame`.
+    size_t Renders = 0;
+    size_t Evictions = 0;
+};
+
+// Tile layer chunks drawn into textures, so a chunk costs a single quad a
+// frame and its tiles are only drawn again once they change. Textures over
+// the byte budget are freed least recently used first, but never ones used
+// in the current frame.
+class ChunkCache final {
+public:
+    // Draws the tiles through `batch`. Disabled if the renderer doesn't
+    // support render targets, or with a `budgetBytes` of 0.
+    ChunkCache(SDL_Renderer* renderer, SpriteBatch& batch, const size_t budgetBytes);
+    ~ChunkCache();
+
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+
+    inline bool IsEnabled() const { return m_Enabled; }
+
+    void BeginFrame();
+    // Returns the texture showing `chunk`, drawing it first if it isn't
+    // cached or is out of date. Null if it couldn't be created. Changes the
+    // render target, so must not be called while drawing into one.
+    SDL_Texture* Get(const TileChunkInstance& chunk);
+    // Evicts chunks not used this frame until within the budget.
+    void Trim();
+    // Frees every texture, for when the renderer lost their contents.
+    void Clear();
+
+    inline const ChunkCacheStats& GetStats() const { return m_Stats; }
+
+private:
+    struct Entry {
+        SDL_Texture* Texture;
+        uint64_t Version;
+        uint64_t LastFrame;
+        size_t Bytes;
+        std::list<uint64_t>::iterator LruPosition;
+    };
+
+    SDL_Renderer* m_Renderer;
+    SpriteBatch& m_Batch;
+    const size_t m_BudgetBytes;
+    const bool m_Enabled;
+    std::unordered_map<uint64_t, Entry> m_Entries;
+    // Keys, most recently used first.
+    std::list<uint64_t> m_Lru;
+    uint64_t m_Frame;
+    ChunkCacheStats m_Stats;
+
+    void Draw(SDL_Texture* texture, const TileChunkInstance& chunk);
+};
+
+} // namespace engine
+
+#endif // !ENG_CHUNK_CACHE_HPP
@@ -0,0 +1,75 @@
+#include "Clock.hpp"
+
+#include <chrono>
+#include <string_view>
+#include <thread>
+
+#include <spdlog/logger.h>
+
+namespace engine {
+
+// Sleep granularity on most desktop schedulers is around 1ms, so the final
+// stretch is spun instead.
+constexpr auto SpinMargin = std::chrono::microseconds(1500);
+
+void WaitUntil(const Clock::time_point deadline)
+{
+    auto now = Clock::now();
+    if (deadline - now > SpinMargin)
+        std::this_thread::sleep_until(deadline - SpinMargin);
+
+    while (Clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+FramePacer::FramePacer(const unsigned int maxFrameRate)
+    : m_FrameDuration(
+        maxFrameRate == 0
+            ? Clock::duration::zero()
+            : std::chrono::duration_cast<Clock::duration>(Seconds(1.0 / maxFrameRate)))
+    , m_NextFrame(Clock::now())
+{
+}
+
+void FramePacer::Wait()
+{
+    if (!IsCapped())
+        return;
+
+    m_NextFrame += m_FrameDuration;
+
+    const auto now = Clock::now();
+    if (m_NextFrame < now) {
+        // We're running late. Don't try to catch up by rendering frames
+        // back-to-back, just start a new schedule from now.
+        m_NextFrame = now;
+        return;
+    }
+
+    WaitUntil(m_NextFrame);
+}
+
+PhaseTimer::PhaseTimer()
+    : m_Start(Clock::now())
+    , m_LapStart(m_Start)
+    , m_Phases()
+{
+}
+
+void PhaseTimer::Lap(const std::string_view name)
+{
+    const auto now = Clock::now();
+    m_Phases.emplace_back(name, now - m_LapStart);
+    m_LapStart = now;
+}
+
+void PhaseTimer::Report(spdlog::logger& logger, const std::string_view title) const
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    logger.info("{} took {:.1f} ms", title, Milliseconds(m_LapStart - m_Start).count());
+    for (const auto& [name, duration] : m_Phases)
+        logger.info("  {:<24} {:8.2f} ms", name, Milliseconds(duration).count());
+}
+
+} // namespace engine
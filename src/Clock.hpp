@@ -0,0 +1,57 @@
+#ifndef ENG_CLOCK_HPP
+#define ENG_CLOCK_HPP
+
+#include <chrono>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <spdlog/logger.h>
+
+namespace engine {
+
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+// Blocks until `deadline`. Sleeps for the bulk of the wait and spins for the
+// last `SpinMargin` so the wake-up isn't at the mercy of the OS scheduler.
+void WaitUntil(const Clock::time_point deadline);
+
+class FramePacer final {
+public:
+    // A `maxFrameRate` of 0 disables the frame cap.
+    FramePacer(const unsigned int maxFrameRate);
+    ~FramePacer() = default;
+
+    // Waits until the start of the next frame slot.
+    void Wait();
+
+    inline bool IsCapped() const { return m_FrameDuration.count() > 0; }
+
+private:
+    Clock::duration m_FrameDuration;
+    Clock::time_point m_NextFrame;
+};
+
+// Measures the wall time of consecutive phases, e.g. of start-up, and logs
+// them as a report.
+class PhaseTimer final {
+public:
+    PhaseTimer();
+    ~PhaseTimer() = default;
+
+    // Ends the current phase, naming it `name`, and starts the next one.
+    // `name` must outlive the timer.
+    void Lap(const std::string_view name);
+
+    void Report(spdlog::logger& logger, const std::string_view title) const;
+
+private:
+    Clock::time_point m_Start;
+    Clock::time_point m_LapStart;
+    std::vector<std::pair<std::string_view, Clock::duration>> m_Phases;
+};
+
+} // namespace engine
+
+#endif // !ENG_CLOCK_HPP
@@ -0,0 +1,227 @@
+#include "CollissionSystem.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "SpatialHash.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+namespace {
+
+    template <typename T>
+    bool IsBefore(const T& a, const T& b)
+    {
+        return std::make_tuple(a.A.Pack(), a.B.Pack()) < std::make_tuple(b.A.Pack(), b.B.Pack());
+    }
+
+} // namespace
+
+CollissionSystem::CollissionSystem(const int cellSize, const simd::Level level)
+    : m_CellSize(cellSize)
+    , m_Kernels(&narrow::GetKernels(level))
+    , m_Proxies()
+    , m_Entries()
+    , m_Candidates()
+    , m_Rectangles()
+    , m_Circles()
+    , m_Mixed()
+    , m_Touching()
+    , m_Previous()
+    , m_Events()
+    , m_Stats()
+{
+}
+
+void CollissionSystem::Update(EntityStore& entities)
+{
+    ENG_TRACE_ZONE("CollissionSystem::Update");
+
+    m_Stats = CollissionStats();
+    Gather(entities);
+    FindCandidates();
+    TestCandidates();
+    Compare();
+
+    ENG_TRACE_COUNTER("Collission candidates", m_Stats.Candidates);
+    ENG_TRACE_COUNTER("Collission contacts", m_Stats.Contacts);
+}
+
+void CollissionSystem::Gather(EntityStore& entities)
+{
+    m_Proxies.clear();
+    m_Entries.clear();
+
+    entities.Each<Transform, Collission>([this](const EntityId id, const Transform& transform, const Collission& collission) {
+        // Colliding with nothing.
+        if (collission.Layers == 0 || collission.Mask == 0)
+            return;
+
+        const bool circular = collission.Type == CollissionType::Circular;
+        const unsigned int width = circular ? collission.Data.Circular.Radius * 2 : collission.Data.Rectangular.Width;
+        const unsigned int height = circular ? collission.Data.Circular.Radius * 2 : collission.Data.Rectangular.Height;
+        if (width == 0 || height == 0)
+            return;
+
+        const Vector2 position = transform.Position + collission.RelativePosition;
+        const int left = static_cast<int>(position.X);
+        const int top = static_cast<int>(position.Y);
+        const Proxy proxy {
+            .Id = id,
+            .Left = left,
+            .Top = top,
+            .Right = left + static_cast<int>(width),
+            .Bottom = top + static_cast<int>(height),
+            .Layers = collission.Layers,
+            .Mask = collission.Mask,
+            .Type = collission.Type,
+            .Shape = {
+                .X = static_cast<float>(left) + static_cast<float>(width) * 0.5f,
+                .Y = static_cast<float>(top) + static_cast<float>(height) * 0.5f,
+                .HalfWidth = static_cast<float>(width) * 0.5f,
+                .HalfHeight = static_cast<float>(height) * 0.5f,
+            },
+        };
+
+        const auto index = static_cast<uint32_t>(m_Proxies.size());
+        m_Proxies.push_back(proxy);
+        const int cellLeft = spatialHash::FloorDiv(proxy.Left, m_CellSize);
+        const int cellRight = spatialHash::FloorDiv(proxy.Right - 1, m_CellSize);
+        const int cellBottom = spatialHash::FloorDiv(proxy.Bottom - 1, m_CellSize);
+        for (int y = spatialHash::FloorDiv(proxy.Top, m_CellSize); y <= cellBottom; y++) {
+            for (int x = cellLeft; x <= cellRight; x++)
+                m_Entries.push_back(CellEntry { .Cell = spatialHash::GetCellKey(x, y), .Proxy = index });
+        }
+    });
+
+    m_Stats.Colliders = m_Proxies.size();
+    m_Stats.Cells = m_Entries.size();
+}
+
+void CollissionSystem::FindCandidates()
+{
+    ENG_TRACE_ZONE("CollissionSystem::FindCandidates");
+
+    m_Candidates.clear();
+    // Ascending proxies within a cell keep the pairs' order independent of
+    // the sort.
+    std::sort(m_Entries.begin(), m_Entries.end(), [](const CellEntry& a, const CellEntry& b) {
+        return a.Cell != b.Cell ? a.Cell < b.Cell : a.Proxy < b.Proxy;
+    });
+
+    for (size_t begin = 0; begin < m_Entries.size();) {
+        const uint64_t cell = m_Entries[begin].Cell;
+        size_t end = begin + 1;
+        while (end < m_Entries.size() && m_Entries[end].Cell == cell)
+            end++;
+
+        for (size_t i = begin; i < end; i++) {
+            const Proxy& a = m_Proxies[m_Entries[i].Proxy];
+            for (size_t j = i + 1; j < end; j++) {
+                const Proxy& b = m_Proxies[m_Entries[j].Proxy];
+                if ((a.Layers & b.Mask) == 0 || (b.Layers & a.Mask) == 0) {
+                    m_Stats.Pruned++;
+                    continue;
+                }
+                if (a.Left >= b.Right || b.Left >= a.Right || a.Top >= b.Bottom || b.Top >= a.Bottom)
+                    continue;
+
+                // Pairs sharing several cells are only taken in one.
+                const int overlapX = spatialHash::FloorDiv(std::max(a.Left, b.Left), m_CellSize);
+                const int overlapY = spatialHash::FloorDiv(std::max(a.Top, b.Top), m_CellSize);
+                if (spatialHash::GetCellKey(overlapX, overlapY) != cell)
+                    continue;
+
+                m_Candidates.push_back(Candidate { .A = m_Entries[i].Proxy, .B = m_Entries[j].Proxy });
+            }
+        }
+        begin = end;
+    }
+
+    m_Stats.Candidates = m_Candidates.size();
+}
+
+void CollissionSystem::TestCandidates()
+{
+    ENG_TRACE_ZONE("CollissionSystem::TestCandidates");
+
+    for (Batch* batch : { &m_Rectangles, &m_Circles, &m_Mixed }) {
+        batch->Pairs.Clear();
+        batch->Candidates.clear();
+    }
+    for (size_t i = 0; i < m_Candidates.size(); i++) {
+        const Proxy& a = m_Proxies[m_Candidates[i].A];
+        const Proxy& b = m_Proxies[m_Candidates[i].B];
+        Batch& batch = a.Type != b.Type ? m_Mixed : a.Type == CollissionType::Rectangular ? m_Rectangles : m_Circles;
+        if (a.Type == CollissionType::Circular && b.Type == CollissionType::Rectangular)
+            batch.Pairs.Push(b.Shape, a.Shape);
+        else
+            batch.Pairs.Push(a.Shape, b.Shape);
+        batch.Candidates.push_back(static_cast<uint32_t>(i));
+    }
+
+    m_Touching.clear();
+    TestBatch(m_Rectangles, m_Kernels->Rectangles);
+    TestBatch(m_Circles, m_Kernels->Circles);
+    TestBatch(m_Mixed, m_Kernels->RectangleCircle);
+
+    m_Stats.Contacts = m_Touching.size();
+}
+
+void CollissionSystem::TestBatch(Batch& batch, const narrow::PairTest test)
+{
+    batch.Touching.resize(batch.Pairs.GetSize());
+    test(batch.Pairs, batch.Touching.data());
+
+    for (size_t i = 0; i < batch.Touching.size(); i++) {
+        if (batch.Touching[i] == 0)
+            continue;
+
+        const Proxy& a = m_Proxies[m_Candidates[batch.Candidates[i]].A];
+        const Proxy& b = m_Proxies[m_Candidates[batch.Candidates[i]].B];
+        const bool ordered = a.Id.Index < b.Id.Index;
+        m_Touching.push_back(Touching {
+            .A = ordered ? a.Id : b.Id,
+            .B = ordered ? b.Id : a.Id,
+            .Point = Vector2(
+                static_cast<unsigned int>((std::max(a.Left, b.Left) + std::min(a.Right, b.Right)) / 2),
+                static_cast<unsigned int>((std::max(a.Top, b.Top) + std::min(a.Bottom, b.Bottom)) / 2)
+            ),
+        });
+    }
+}
+
+void CollissionSystem::Compare()
+{
+    ENG_TRACE_ZONE("CollissionSystem::Compare");
+
+    std::sort(m_Touching.begin(), m_Touching.end(), IsBefore<Touching>);
+
+    m_Events.clear();
+    const auto emit = [this](const Touching& pair, const CollissionPhase phase) {
+        m_Events.push_back(CollissionContact { .A = pair.A, .B = pair.B, .Phase = phase, .Point = pair.Point });
+    };
+
+    size_t previous = 0;
+    size_t current = 0;
+    while (previous < m_Previous.size() || current < m_Touching.size()) {
+        if (current == m_Touching.size() || (previous < m_Previous.size() && IsBefore(m_Previous[previous], m_Touching[current]))) {
+            emit(m_Previous[previous++], CollissionPhase::Exit);
+        } else if (previous == m_Previous.size() || IsBefore(m_Touching[current], m_Previous[previous])) {
+            emit(m_Touching[current++], CollissionPhase::Enter);
+        } else {
+            emit(m_Touching[current++], CollissionPhase::Stay);
+            previous++;
+        }
+    }
+
+    std::swap(m_Previous, m_Touching);
+}
+
+} // namespace engine
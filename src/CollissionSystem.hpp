@@ -0,0 +1,136 @@
+#ifndef ENG_COLLISSION_SYSTEM_HPP
+#define ENG_COLLISSION_SYSTEM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Components.hpp"
+#include "EntityStore.hpp"
+#include "NarrowPhase.hpp"
+#include "Simd.hpp"
+#include "Vector2.hpp"
+
+namespace engine {
+
+enum class CollissionPhase : uint8_t {
+    // The pair started touching this update.
+    Enter,
+    // It touched during the previous update too.
+    Stay,
+    // It touched during the previous update, but no longer does or one of
+    // the entities is gone.
+    Exit,
+};
+
+struct CollissionContact {
+    // `A` has the lower slot index.
+    EntityId A;
+    EntityId B;
+    CollissionPhase Phase;
+    // The middle of where the shapes' bounds overlap. For exits, where they
+    // did last.
+    Vector2 Point;
+};
+
+struct CollissionStats {
+    size_t Colliders = 0;
+    // Collider and cell pairs, more than colliders for the ones straddling
+    // cells.
+    size_t Cells = 0;
+    // Pairs sharing a cell but not a layer.
+    size_t Pruned = 0;
+    // Pairs whose bounds overlap, tested exactly.
+    size_t Candidates = 0;
+    size_t Contacts = 0;
+};
+
+// Finds the touching pairs among entities with a `Transform` and a
+// `Collission`, every update anew. The broad phase is a spatial hash: every
+// collider is listed under the grid cells its bounds cover, the list is
+// sorted by cell, and only colliders sharing a cell are paired, each pair
+// once, in the cell holding the top left of their overlap. Colliders
+// should mostly be smaller than a cell, as bigger ones are listed under
+// many.
+//
+// The pairs whose bounds overlap are then sorted by shape combination into
+// batches tested by the narrow phase kernels of the given SIMD level.
+//
+// The touching pairs are kept until the next update, which reports each
+// pair as entering, staying or exiting by comparing against them.
+class CollissionSystem final {
+public:
+    static constexpr int DefaultCellSize = 64;
+
+    explicit CollissionSystem(const int cellSize = DefaultCellSize, const simd::Level level = simd::GetLevel());
+    ~CollissionSystem() = default;
+
+    void Update(EntityStore& entities);
+
+    // What the last `Update` found, ordered by pair.
+    inline const std::vector<CollissionContact>& GetEvents() const { return m_Events; }
+    inline const CollissionStats& GetStats() const { return m_Stats; }
+
+private:
+    // A collider placed in the world.
+    struct Proxy {
+        EntityId Id;
+        // Right and bottom exclusive.
+        int Left;
+        int Top;
+        int Right;
+        int Bottom;
+        uint32_t Layers;
+        uint32_t Mask;
+        CollissionType Type;
+        narrow::Shape Shape;
+    };
+
+    struct CellEntry {
+        uint64_t Cell;
+        uint32_t Proxy;
+    };
+
+    struct Candidate {
+        uint32_t A;
+        uint32_t B;
+    };
+
+    // Candidates of one shape combination, by index.
+    struct Batch {
+        narrow::PairBatch Pairs;
+        std::vector<uint32_t> Candidates;
+        std::vector<uint8_t> Touching;
+    };
+
+    struct Touching {
+        EntityId A;
+        EntityId B;
+        Vector2 Point;
+    };
+
+    const int m_CellSize;
+    const narrow::Kernels* m_Kernels;
+    std::vector<Proxy> m_Proxies;
+    std::vector<CellEntry> m_Entries;
+    std::vector<Candidate> m_Candidates;
+    Batch m_Rectangles;
+    Batch m_Circles;
+    // Rectangles first.
+    Batch m_Mixed;
+    // This update's touching pairs and the previous one's, sorted.
+    std::vector<Touching> m_Touching;
+    std::vector<Touching> m_Previous;
+    std::vector<CollissionContact> m_Events;
+    CollissionStats m_Stats;
+
+    void Gather(EntityStore& entities);
+    void FindCandidates();
+    void TestCandidates();
+    void TestBatch(Batch& batch, const narrow::PairTest test);
+    void Compare();
+};
+
+} // namespace engine
+
+#endif // !ENG_COLLISSION_SYSTEM_HPP
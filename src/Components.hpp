@@ -0,0 +1,67 @@
+#ifndef ENG_COMPONENTS_HPP
+#define ENG_COMPONENTS_HPP
+
+#include <cstdint>
+
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+
+#include "StringInterner.hpp"
+#include "Vector2.hpp"
+
+namespace engine {
+
+// Where an entity is in the world, now and at the previous simulation tick,
+// which rendering interpolates from. New entities should start with both
+// the same.
+struct Transform {
+    Vector2 Position;
+    Vector2 PreviousPosition;
+};
+
+// Interned in `StringInterner::Global()`. Entities are indexed by class,
+// so only `EntityStore` changes it.
+struct EntityClass {
+    Symbol Name;
+};
+
+enum class CollissionType {
+    Rectangular,
+    Circular,
+};
+
+struct RectangularCollission {
+    unsigned int Width;
+    unsigned int Height;
+};
+
+struct CircularCollission {
+    unsigned int Radius;
+};
+
+// The shape's top left is `RelativePosition` from the entity's position,
+// a circle's too. Two entities collide only if each one's layers are in
+// the other's mask.
+struct Collission {
+    Vector2 RelativePosition;
+
+    CollissionType Type;
+    union {
+        RectangularCollission Rectangular;
+        CircularCollission Circular;
+    } Data;
+
+    uint32_t Layers = 1;
+    uint32_t Mask = UINT32_MAX;
+};
+
+struct Sprite {
+    SDL_Texture *Texture;
+    // Part of `Texture` to draw, which may be an atlas page. Zero sized
+    // means the whole texture.
+    SDL_Rect Source;
+};
+
+} // namespace engine
+
+#endif // !ENG_COMPONENTS_HPP
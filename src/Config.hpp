@@ -1,10 +1,19 @@
 #ifndef ENG_CONFIG_HPP
 #define ENG_CONFIG_HPP
 
+#include <cstddef>
+
 #include <SDL2/SDL_video.h>
 
 namespace engine {
 
+enum class RenderBackend {
+    // SDL's renderer, usually on the GPU.
+    Sdl,
+    // The engine's own tiled rasterizer, on the task workers.
+    Software,
+};
+
 enum class DefaultKeybind {
     // Movement
     MoveForward,
@@ -70,10 +79,79 @@ struct Config {
     } Window;
 
     struct {
+        // Software rendering keeps a CPU copy of every texture and doesn't
+        // support retained mode, dynamic resolution or the chunk cache.
+        RenderBackend Backend;
         bool Accelerated;
         bool VSync;
+        // Bytes of streamed textures created per frame, 0 for no limit. At
+        // least one texture is created every frame.
+        size_t UploadBudget;
+        // Keeps the frame in a texture and only redraws the parts that
+        // changed, skipping frames where nothing did. Pays off for mostly
+        // static scenes.
+        bool Retained;
+        // Bytes of cached tile layer chunk textures kept around once out of
+        // view, 0 to draw tile layers tile by tile.
+        size_t ChunkCacheBudget;
+        // Renders into an offscreen target scaled between the two bounds,
+        // picked from the recent frame times, and stretches it over the
+        // window. Ignored in retained mode.
+        bool DynamicResolution;
+        float MinResolutionScale;
+        float MaxResolutionScale;
+        // Seconds of work per frame the scaling aims to stay under. Waits
+        // for the frame cap don't count, VSync waits do.
+        double TargetFrameTime;
     } Render;
 
+    struct {
+        // Fixed simulation rate in ticks per second.
+        unsigned int TickRate;
+        // Render frame cap in frames per second, 0 for uncapped.
+        unsigned int MaxFrameRate;
+        // Upper bound on the ticks simulated in a single frame. Time beyond
+        // that is dropped to avoid the spiral of death.
+        unsigned int MaxTicksPerFrame;
+        // Simulates frame N+1 on a worker thread while the main thread
+        // renders frame N. Adds a frame of latency.
+        bool Pipelined;
+    } Loop;
+
+    struct {
+        // Resident resources above this size get evicted, least recently
+        // used first, once nothing references them.
+        size_t MemoryBudget;
+        // Loads the game's metadata and resource table from a cooked binary
+        // manifest when it's up to date, and writes one when it isn't.
+        bool CookedManifest;
+        // Eager sprites are packed into atlas textures of up to this size
+        // squared, 0 to give every sprite its own texture.
+        int AtlasPageSize;
+        // Pixels of each sprite's edge repeated around it in the atlas.
+        int AtlasPadding;
+    } Resources;
+
+    struct {
+        // Number of task worker threads, 0 for the hardware concurrency minus
+        // the main thread.
+        unsigned int WorkerCount;
+    } Tasks;
+
+    struct {
+        // Uses SDL's dummy video driver and a software renderer, skips audio
+        // and steps the simulation with a fixed clock instead of wall time.
+        bool Enabled;
+        // Number of frames to run before exiting, 0 to run until quit.
+        unsigned int FrameCount;
+    } Headless;
+
+    struct {
+        // Only used when built with tracing enabled.
+        bool DumpOnExit;
+        const char *OutputPath;
+    } Trace;
+
     struct {
         ;
     } Controlling;
@@ -88,8 +166,39 @@ struct Config {
                 .Height = 600,
             },
             .Render = {
+                .Backend = RenderBackend::Sdl,
                 .Accelerated = true,
                 .VSync = false,
+                .UploadBudget = 4 * 1024 * 1024,
+                .Retained = false,
+                .ChunkCacheBudget = 64 * 1024 * 1024,
+                .DynamicResolution = false,
+                .MinResolutionScale = 0.5f,
+                .MaxResolutionScale = 1.0f,
+                .TargetFrameTime = 1.0 / 60.0,
+            },
+            .Loop = {
+                .TickRate = 60,
+                .MaxFrameRate = 144,
+                .MaxTicksPerFrame = 5,
+                .Pipelined = false,
+            },
+            .Resources = {
+                .MemoryBudget = 256 * 1024 * 1024,
+                .CookedManifest = true,
+                .AtlasPageSize = 2048,
+                .AtlasPadding = 2,
+            },
+            .Tasks = {
+                .WorkerCount = 0,
+            },
+            .Headless = {
+                .Enabled = false,
+                .FrameCount = 0,
+            },
+            .Trace = {
+                .DumpOnExit = true,
+                .OutputPath = "trace.json",
             },
         };
     }
@@ -0,0 +1,144 @@
+#include "CullingGrid.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <SDL2/SDL_rect.h>
+
+#include "SpatialHash.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+CullingGrid::CullingGrid(const int cellSize)
+    : m_CellSize(cellSize)
+    , m_Cells()
+    , m_Items()
+    , m_Seen()
+    , m_Query(0)
+    , m_Placed(0)
+{
+}
+
+void CullingGrid::Place(const uint32_t id, const SDL_Rect& bounds)
+{
+    if (bounds.w <= 0 || bounds.h <= 0) {
+        Remove(id);
+        return;
+    }
+
+    if (id >= m_Items.size()) {
+        m_Items.resize(id + 1, Item { .Bounds = {}, .Cells = {}, .Placed = false });
+        m_Seen.resize(id + 1, 0);
+    }
+
+    auto& item = m_Items[id];
+    const CellRange cells = GetCells(bounds);
+    item.Bounds = bounds;
+    if (item.Placed && item.Cells == cells)
+        return;
+
+    if (item.Placed)
+        Unlink(id, item.Cells);
+    else
+        m_Placed++;
+    item.Cells = cells;
+    item.Placed = true;
+    Link(id, cells);
+}
+
+void CullingGrid::Remove(const uint32_t id)
+{
+    if (id >= m_Items.size() || !m_Items[id].Placed)
+        return;
+
+    Unlink(id, m_Items[id].Cells);
+    m_Items[id].Placed = false;
+    m_Placed--;
+}
+
+void CullingGrid::Query(const SDL_Rect& view, std::vector<uint32_t>& out)
+{
+    ENG_TRACE_ZONE("CullingGrid::Query");
+
+    out.clear();
+    if (view.w <= 0 || view.h <= 0 || m_Placed == 0)
+        return;
+
+    // Stamps start over rather than wrapping into stale ones.
+    if (++m_Query == 0) {
+        std::fill(m_Seen.begin(), m_Seen.end(), 0);
+        m_Query = 1;
+    }
+
+    const auto visit = [&](const std::vector<uint32_t>& ids) {
+        for (const uint32_t id : ids) {
+            if (m_Seen[id] == m_Query)
+                continue;
+            m_Seen[id] = m_Query;
+            if (SDL_HasIntersection(&m_Items[id].Bounds, &view) == SDL_TRUE)
+                out.push_back(id);
+        }
+    };
+
+    // A view spanning more cells than are occupied, zoomed far out, is
+    // cheaper to answer by going over the occupied ones.
+    const CellRange range = GetCells(view);
+    const uint64_t spanned = static_cast<uint64_t>(range.Right - range.Left + 1) * static_cast<uint64_t>(range.Bottom - range.Top + 1);
+    if (spanned > m_Cells.size()) {
+        for (const auto& [key, ids] : m_Cells)
+            visit(ids);
+    } else {
+        for (int y = range.Top; y <= range.Bottom; y++) {
+            for (int x = range.Left; x <= range.Right; x++) {
+                const auto cell = m_Cells.find(spatialHash::GetCellKey(x, y));
+                if (cell != m_Cells.end())
+                    visit(cell->second);
+            }
+        }
+    }
+
+    // Callers draw in this order, it shouldn't depend on the cell layout.
+    std::sort(out.begin(), out.end());
+}
+
+CullingGrid::CellRange CullingGrid::GetCells(const SDL_Rect& bounds) const
+{
+    return CellRange {
+        .Left = spatialHash::FloorDiv(bounds.x, m_CellSize),
+        .Top = spatialHash::FloorDiv(bounds.y, m_CellSize),
+        .Right = spatialHash::FloorDiv(bounds.x + bounds.w - 1, m_CellSize),
+        .Bottom = spatialHash::FloorDiv(bounds.y + bounds.h - 1, m_CellSize),
+    };
+}
+
+void CullingGrid::Link(const uint32_t id, const CellRange& cells)
+{
+    for (int y = cells.Top; y <= cells.Bottom; y++) {
+        for (int x = cells.Left; x <= cells.Right; x++)
+            m_Cells[spatialHash::GetCellKey(x, y)].push_back(id);
+    }
+}
+
+void CullingGrid::Unlink(const uint32_t id, const CellRange& cells)
+{
+    for (int y = cells.Top; y <= cells.Bottom; y++) {
+        for (int x = cells.Left; x <= cells.Right; x++) {
+            const auto cell = m_Cells.find(spatialHash::GetCellKey(x, y));
+            if (cell == m_Cells.end())
+                continue;
+            auto& ids = cell->second;
+            const auto it = std::find(ids.begin(), ids.end(), id);
+            if (it != ids.end()) {
+                *it = ids.back();
+                ids.pop_back();
+            }
+            if (ids.empty())
+                m_Cells.erase(cell);
+        }
+    }
+}
+
+} // namespace engine
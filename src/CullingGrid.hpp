@@ -0,0 +1,65 @@
+#ifndef ENG_CULLING_GRID_HPP
+#define ENG_CULLING_GRID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL_rect.h>
+
+namespace engine {
+
+// Coarse, sparse grid of rectangles by id, for finding the ones in view
+// without looking at all of them. Only occupied cells are stored, so the
+// cost of a query depends on what's around the view, not on the world size.
+class CullingGrid final {
+public:
+    static constexpr int DefaultCellSize = 256;
+
+    explicit CullingGrid(const int cellSize = DefaultCellSize);
+    ~CullingGrid() = default;
+
+    // Places `id` over `bounds`, moving it if it's placed already. Cheap when
+    // it stays within the same cells. Empty bounds remove it.
+    void Place(const uint32_t id, const SDL_Rect& bounds);
+    void Remove(const uint32_t id);
+
+    // Fills `out` with the ids whose bounds intersect `view`, ascending.
+    void Query(const SDL_Rect& view, std::vector<uint32_t>& out);
+
+    inline size_t GetSize() const { return m_Placed; }
+
+private:
+    // Inclusive range of cell coordinates.
+    struct CellRange {
+        int Left;
+        int Top;
+        int Right;
+        int Bottom;
+
+        bool operator==(const CellRange&) const = default;
+    };
+
+    struct Item {
+        SDL_Rect Bounds;
+        CellRange Cells;
+        bool Placed;
+    };
+
+    const int m_CellSize;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_Cells;
+    std::vector<Item> m_Items;
+    // Per id, the last query that saw it, to skip ids spanning many cells.
+    std::vector<uint32_t> m_Seen;
+    uint32_t m_Query;
+    size_t m_Placed;
+
+    CellRange GetCells(const SDL_Rect& bounds) const;
+    void Link(const uint32_t id, const CellRange& cells);
+    void Unlink(const uint32_t id, const CellRange& cells);
+};
+
+} // namespace engine
+
+#endif // !ENG_CULLING_GRID_HPP
@@ -0,0 +1,95 @@
+#include "DirtyRegion.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <SDL2/SDL_rect.h>
+
+namespace engine {
+
+namespace {
+
+    // Merging is quadratic, past this many rectangles the bounding box is
+    // taken straight away.
+    constexpr size_t MaxMergedRects = 256;
+    // Share of the screen above which the whole of it is redrawn.
+    constexpr double FullRedrawCoverage = 0.6;
+
+    uint64_t GetRectArea(const SDL_Rect& rect)
+    {
+        return static_cast<uint64_t>(rect.w) * static_cast<uint64_t>(rect.h);
+    }
+
+    SDL_Rect GetBoundingBox(const std::span<const SDL_Rect> rects)
+    {
+        SDL_Rect box = rects.front();
+        for (const auto& rect : rects.subspan(1))
+            SDL_UnionRect(&box, &rect, &box);
+        return box;
+    }
+
+} // namespace
+
+void DirtyRegion::Clear()
+{
+    m_Rects.clear();
+    m_Area = 0;
+}
+
+void DirtyRegion::Add(const SDL_Rect& rect)
+{
+    if (rect.w > 0 && rect.h > 0)
+        m_Rects.push_back(rect);
+}
+
+void DirtyRegion::Finish(const SDL_Rect& bounds)
+{
+    size_t kept = 0;
+    for (const auto& rect : m_Rects) {
+        SDL_Rect clipped;
+        if (SDL_IntersectRect(&rect, &bounds, &clipped) == SDL_TRUE)
+            m_Rects[kept++] = clipped;
+    }
+    m_Rects.resize(kept);
+
+    if (m_Rects.empty()) {
+        m_Area = 0;
+        return;
+    }
+
+    if (m_Rects.size() > MaxMergedRects) {
+        m_Rects.front() = GetBoundingBox(m_Rects);
+        m_Rects.resize(1);
+    }
+
+    // Merge until no two rectangles overlap. Merging may make a rectangle
+    // overlap ones already checked, hence the restart.
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < m_Rects.size() && !merged; i++) {
+            for (size_t j = i + 1; j < m_Rects.size(); j++) {
+                if (SDL_HasIntersection(&m_Rects[i], &m_Rects[j]) != SDL_TRUE)
+                    continue;
+                SDL_UnionRect(&m_Rects[i], &m_Rects[j], &m_Rects[i]);
+                m_Rects[j] = m_Rects.back();
+                m_Rects.pop_back();
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    m_Area = 0;
+    for (const auto& rect : m_Rects)
+        m_Area += GetRectArea(rect);
+
+    if (m_Rects.size() > MaxRects || m_Area > GetRectArea(bounds) * FullRedrawCoverage) {
+        const SDL_Rect box = m_Rects.size() > MaxRects ? GetBoundingBox(m_Rects) : bounds;
+        m_Rects.front() = GetRectArea(box) > GetRectArea(bounds) * FullRedrawCoverage ? bounds : box;
+        m_Rects.resize(1);
+        m_Area = GetRectArea(m_Rects.front());
+    }
+}
+
+} // namespace engine
@@ -0,0 +1,43 @@
+#ifndef ENG_DIRTY_REGION_HPP
+#define ENG_DIRTY_REGION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <SDL2/SDL_rect.h>
+
+namespace engine {
+
+// The parts of the screen that changed since the last frame, as a few
+// disjoint rectangles.
+class DirtyRegion final {
+public:
+    // More rectangles than this are redrawn as their bounding box.
+    static constexpr size_t MaxRects = 16;
+
+    DirtyRegion() = default;
+    ~DirtyRegion() = default;
+
+    void Clear();
+    void Add(const SDL_Rect& rect);
+
+    // Clips the rectangles to `bounds` and merges the overlapping ones.
+    // Collapses them into one when there are too many or they cover most of
+    // `bounds` anyway, as redrawing in one go is cheaper then.
+    void Finish(const SDL_Rect& bounds);
+
+    inline bool IsEmpty() const { return m_Rects.empty(); }
+    inline std::span<const SDL_Rect> GetRects() const { return m_Rects; }
+    // Only valid after `Finish`.
+    inline uint64_t GetArea() const { return m_Area; }
+
+private:
+    std::vector<SDL_Rect> m_Rects;
+    uint64_t m_Area = 0;
+};
+
+} // namespace engine
+
+#endif // !ENG_DIRTY_REGION_HPP
@@ -3,13 +3,18 @@
 #include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
 
 #include <spdlog/common.h>
 #include <spdlog/logger.h>
@@ -25,22 +30,112 @@
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "Clock.hpp"
+#include "BinaryBuffer.hpp"
 #include "EngineMetadata.hpp"
 #include "Game.hpp"
+#include "LuaInterop.hpp"
+#include "Manifest.hpp"
+#include "Pack.hpp"
 #include "Platform.hpp"
+#include "ResourceManager.hpp"
 #include "Result.hpp"
 #include "ScriptEngine.hpp"
+#include "Subsystems.hpp"
+#include "Task.hpp"
+#include "Trace.hpp"
 #include "Util.hpp"
 
 #define FORCE_TRACE
 
 namespace engine {
 
+constexpr unsigned int LoadingScreenFrameRate = 60;
+
+namespace {
+
+    std::string_view AsText(const std::span<const std::byte> bytes)
+    {
+        return std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    // One of the game's text sources along with what the cooked manifest
+    // records about it.
+    struct SourceDocument {
+        BinaryBuffer Owner;
+        std::string_view Text;
+        manifest::SourceInfo Info;
+    };
+
+    Result<SourceDocument> ReadSourceDocument(const std::filesystem::path& root, const Pack* pack, const std::string_view name)
+    {
+        SourceDocument document;
+
+        if (pack) {
+            const auto data = pack->Find(name);
+            if (!data)
+                return Error(Error::InvalidGame, "Missing source in the pack");
+            document.Text = AsText(*data);
+            document.Info = manifest::SourceInfo { .Hash = util::Fnv1a(document.Text), .ModifiedTime = 0, .Size = data->size() };
+            return Result(std::move(document));
+        }
+
+        // Stamped before reading, so a concurrent edit makes the stamp stale
+        // rather than the contents.
+        const auto path = root / name;
+        std::error_code errCode;
+        const auto modifiedTime = std::filesystem::last_write_time(path, errCode);
+        if (errCode)
+            return Error(Error::Io, "Couldn't stat a source");
+
+        auto file = BinaryBuffer::FromFile(path);
+        if (file.IsErr())
+            return file.UnwrapErr();
+
+        document.Owner = file.UnwrapMove();
+        document.Text = AsText(document.Owner.GetBytes());
+        document.Info = manifest::SourceInfo {
+            .Hash = util::Fnv1a(document.Text),
+            .ModifiedTime = static_cast<int64_t>(modifiedTime.time_since_epoch().count()),
+            .Size = document.Owner.GetSize(),
+        };
+        return Result(std::move(document));
+    }
+
+    // Checks a cooked source against the current one. Folder sources whose
+    // modification time and size still match aren't read at all.
+    bool IsSourceFresh(const std::filesystem::path& root, const Pack* pack, const std::string_view name, const manifest::SourceInfo& cooked)
+    {
+        if (!pack) {
+            const auto path = root / name;
+            std::error_code errCode;
+            const auto modifiedTime = std::filesystem::last_write_time(path, errCode);
+            const auto size = std::filesystem::file_size(path, errCode);
+            if (errCode)
+                return false;
+            if (static_cast<int64_t>(modifiedTime.time_since_epoch().count()) == cooked.ModifiedTime && size == cooked.Size)
+                return true;
+        }
+
+        // Touched, or in a pack: compare the contents.
+        auto document = ReadSourceDocument(root, pack, name);
+        return document.IsOk() && document.Unwrap().Info.Hash == cooked.Hash && document.Unwrap().Info.Size == cooked.Size;
+    }
+
+} // namespace
+
+GameFormat GetGameFormat(const std::filesystem::path& path)
+{
+    return path.extension() == pack::Extension ? GameFormat::PACK : GameFormat::FOLDER;
+}
+
 Engine::Engine(
     Config&& cfg,
     std::shared_ptr<spdlog::logger> logger,
     std::shared_ptr<ScriptEngine> script, std::shared_ptr<RenderingEngine> rendering,
+    std::shared_ptr<Subsystems> subsystems,
     std::shared_ptr<EventEngine> event,
+    std::shared_ptr<TaskDispatcher> tasks,
     std::shared_ptr<std::atomic<bool>> runningFlag,
     std::shared_ptr<std::atomic<State>> state
 )
@@ -49,31 +144,83 @@ Engine::Engine(
     , m_Logger(logger)
     , m_Script(script)
     , m_Rendering(rendering)
+    , m_Subsystems(subsystems)
     , m_Event(event)
+    , m_Tasks(tasks)
     , m_RunningFlag(runningFlag)
     , m_State(state)
+    , m_Scene()
+    , m_Frames()
+    , m_Camera(Camera {
+          .Position = Vector2(),
+          .Zoom = 1.0f,
+          .Viewport = SDL_Rect { 0, 0, m_Cfg.Window.Width, m_Cfg.Window.Height },
+      })
+    , m_Culling()
+    , m_Unculled()
+    , m_Visible()
+    , m_Changed()
+    , m_Collissions()
+    , m_TickCount(0)
+    , m_Resources()
+    , m_ScriptResources()
+    , m_Streamer()
 {
+    m_Script->SetCamera(&m_Camera);
+    m_Script->SetEntities(&m_Scene.Entities);
+    m_Script->SetTileLayers(&m_Scene.TileLayers);
 }
 
 Engine::~Engine()
 {
     m_Logger->trace("Finalizing Engine");
+    m_Script->SetCamera(nullptr);
+    m_Script->SetEntities(nullptr);
+    m_Script->SetTileLayers(nullptr);
+
+#ifdef ENG_TRACE
+    if (m_Cfg.Trace.DumpOnExit) {
+        m_Logger->info("Writing the trace to {}", m_Cfg.Trace.OutputPath);
+        if (auto res = trace::Dump(m_Cfg.Trace.OutputPath); !res)
+            m_Logger->error("Couldn't write the trace: {}", res.UnwrapErr().ToString());
+    }
+#endif
 }
 
 Result<std::shared_ptr<Engine>> Engine::New(const int argc, const char** argv)
 {
     // TODO: Load a config from a config file and console line args. Also, initialize all dependencies.
 
+    PhaseTimer timer;
+
     auto logger = spdlog::stdout_color_mt("console");
     logger->set_pattern("\033[90m%Y-%m-%d %H:%M:%S t%t %^[%l]%$ %v");
-    if (argc > 1) {
-        if (!strcmp(argv[1], "trace")) {
+
+    Config cfg = Config::Default();
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+
+        if (arg == "trace") {
             logger->set_level(spdlog::level::trace);
             logger->info("Trace log level");
             SDL_LogSetAllPriority(SDL_LOG_PRIORITY_VERBOSE);
-        } else if (!strcmp(argv[1], "debug")) {
+        } else if (arg == "debug") {
             logger->set_level(spdlog::level::debug);
             logger->info("Debug log level");
+        } else if (arg == "--headless") {
+            cfg.Headless.Enabled = true;
+        } else if (arg == "--software") {
+            cfg.Render.Backend = RenderBackend::Software;
+        } else if (arg.starts_with("--frames=")) {
+            const auto value = arg.substr(std::string_view("--frames=").size());
+            auto [_, ec] = std::from_chars(value.data(), value.data() + value.size(), cfg.Headless.FrameCount);
+            if (ec != std::errc()) {
+                logger->error("Invalid frame count: {}", value);
+                return Error(Error::InvalidFormat, "Invalid frame count");
+            }
+        } else {
+            logger->warn("Ignoring unknown argument {}", arg);
         }
     }
 #ifdef FORCE_TRACE
@@ -81,75 +228,413 @@ Result<std::shared_ptr<Engine>> Engine::New(const int argc, const char** argv)
     SDL_LogSetAllPriority(SDL_LOG_PRIORITY_VERBOSE);
 #endif
     logger->trace("Console logger created");
-
-    Config cfg = Config::Default();
+    timer.Lap("Logger and arguments");
 
     auto runningFlag = std::make_shared<std::atomic<bool>>();
     runningFlag->store(true);
 
     auto state = std::shared_ptr<std::atomic<State>>(new std::atomic<State>{State()});
 
-    auto rendering = RenderingEngine::New(logger, cfg);
+    auto tasks = TaskDispatcher::New(logger, cfg.Tasks.WorkerCount);
+    if (tasks.IsErr()) {
+        logger->error("Creation of the task dispatcher failed: {}", tasks.UnwrapErr().ToString());
+        return tasks.UnwrapErr();
+    }
+    timer.Lap("Task dispatcher");
+
+    // The Lua state doesn't touch SDL, so it's set up on a worker while the
+    // main thread brings up the video subsystem.
+    std::optional<Result<std::shared_ptr<ScriptEngine>>> script;
+    auto scriptTask = tasks.Unwrap()->Run([&script, &logger, &runningFlag] {
+        script = ScriptEngine::New(logger, runningFlag);
+    });
+
+    auto rendering = RenderingEngine::New(logger, tasks.Unwrap(), cfg);
+    timer.Lap("Rendering engine");
+    tasks.Unwrap()->Wait(scriptTask);
+    timer.Lap("Script engine (overlapped)");
+
     if (rendering.IsErr()) {
         logger->error("Creation of the rendering engine failed: {}", rendering.UnwrapErr().ToString());
         return rendering.UnwrapErr();
     }
-    auto script = ScriptEngine::New(logger, runningFlag);
-    if (script.IsErr()) {
-        logger->error("Creation of the script engine failed: {}", script.UnwrapErr().ToString());
-        return script.UnwrapErr();
+    if (script->IsErr()) {
+        logger->error("Creation of the script engine failed: {}", script->UnwrapErr().ToString());
+        return script->UnwrapErr();
+    }
+
+    auto subsystems = Subsystems::New(logger, cfg);
+    if (subsystems.IsErr()) {
+        logger->error("Creation of the subsystems failed: {}", subsystems.UnwrapErr().ToString());
+        return subsystems.UnwrapErr();
     }
+
     auto event = EventEngine::New(
         logger,
         runningFlag,
         state,
         *rendering
     );
+    timer.Lap("Event engine");
+
+    timer.Report(*logger, "Engine::New");
 
     return Result(std::make_shared<Engine>(
         std::move(cfg),
         logger,
-        script.Unwrap(),
+        script->Unwrap(),
         rendering.Unwrap(),
+        subsystems.Unwrap(),
         event.Unwrap(),
+        tasks.Unwrap(),
         runningFlag,
         state
     ));
 }
 
-Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat format)
+Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat format, const LoadProgressCallback& onProgress)
 {
+    ENG_TRACE_ZONE("Engine::LoadGame");
+
     if (m_Game.has_value()) {
         m_Logger->error("Can not load a new game as there already is one loaded.");
         return Error(Error::InvalidState, "Game is already loaded");
     }
 
     m_Logger->trace("Loading game {} with format {}", path.string(), (int)format);
+    PhaseTimer timer;
 
     if (!std::filesystem::exists(path)) {
         m_Logger->error("File doesn't exist", path.string());
         return Error(Error::InvalidGame, fmt::format("File doesn't exist: {}", path.string()));
     }
-    if (!std::filesystem::is_directory(path)) {
-        m_Logger->error("A format {} game has to be a folder", (int)format);
-        return Error::InvalidGame;
+
+    // Null for FOLDER games.
+    std::shared_ptr<Pack> pack;
+    switch (format) {
+    case GameFormat::FOLDER:
+        if (!std::filesystem::is_directory(path)) {
+            m_Logger->error("A format {} game has to be a folder", (int)format);
+            return Error::InvalidGame;
+        }
+        if (!std::filesystem::exists(path / "game.toml")) {
+            m_Logger->error("Missing metadata file");
+            return Error::InvalidGame;
+        }
+        if (!std::filesystem::exists(path / "resources.xml")) {
+            m_Logger->error("Missing resource table");
+            return Error::InvalidGame;
+        }
+        break;
+    case GameFormat::PACK: {
+        auto opened = Pack::Open(m_Logger, path);
+        if (opened.IsErr())
+            return opened.UnwrapErr();
+        pack = opened.UnwrapMove();
+        if (!pack->Find("game.toml")) {
+            m_Logger->error("Missing metadata file");
+            return Error::InvalidGame;
+        }
+        if (!pack->Find("resources.xml")) {
+            m_Logger->error("Missing resource table");
+            return Error::InvalidGame;
+        }
+        break;
     }
-    if (!std::filesystem::exists(path / "game.toml")) {
-        m_Logger->error("Missing metadata file");
-        return Error::InvalidGame;
     }
-    if (!std::filesystem::exists(path / "resources.xml")) {
-        m_Logger->error("Missing resource table");
-        return Error::InvalidGame;
+    timer.Lap("Opening");
+
+    // The metadata and the resource table are independent, so they're
+    // parsed in parallel. Once the table is known, the resources are read in
+    // parallel too. Meanwhile the calling (main) thread initializes the
+    // subsystems they need, keeps the window alive and reports progress.
+    std::atomic<LoadStage> stage = LoadStage::Parsing;
+    std::atomic<size_t> completed = 0;
+    std::atomic<size_t> total = 2;
+
+    std::optional<Result<game::Metadata>> metadata;
+    std::optional<Result<game::ResourceTable>> resources;
+    std::vector<BinaryBuffer> resourceData;
+    Result<> resourcesResult;
+    Result<> subsystemsResult;
+
+    // An up to date cooked manifest replaces parsing the text sources.
+    bool fromCooked = false;
+    if (m_Cfg.Resources.CookedManifest) {
+        if (auto cooked = LoadCookedManifest(path, pack.get())) {
+            metadata = Result(std::move(cooked->Meta));
+            resources = Result(std::move(cooked->Resources));
+            completed += 2;
+            fromCooked = true;
+        }
+        timer.Lap("Cooked manifest");
     }
 
-    std::ifstream metadataFile(path / "game.toml");
-    if (!metadataFile) {
-        m_Logger->error("Couldn't open metadata file: errno {}: '{}'", errno, std::strerror(errno));
-        return Error::Io;
+    manifest::SourceInfo metadataSource {};
+    manifest::SourceInfo resourceTableSource {};
+
+    auto metadataTask = m_Tasks->Run([&] {
+        if (fromCooked)
+            return;
+        if (auto document = ReadSourceDocument(path, pack.get(), "game.toml"); document.IsErr()) {
+            m_Logger->error("Couldn't read the metadata file: {}", document.UnwrapErr().ToString());
+            metadata = document.UnwrapErr();
+        } else {
+            metadataSource = document.Unwrap().Info;
+            metadata = LoadMetadata(document.Unwrap().Text);
+        }
+        completed++;
+    });
+    auto resourceTableTask = m_Tasks->Run([&] {
+        if (fromCooked)
+            return;
+        if (auto document = ReadSourceDocument(path, pack.get(), "resources.xml"); document.IsErr()) {
+            m_Logger->error("Couldn't read the resource table: {}", document.UnwrapErr().ToString());
+            resources = document.UnwrapErr();
+        } else {
+            resourceTableSource = document.Unwrap().Info;
+            resources = LoadResourceTable(document.Unwrap().Text);
+        }
+        completed++;
+    });
+    auto resourcesTask = m_Tasks->Then(resourceTableTask, [&] {
+        if (resources->IsErr())
+            return;
+
+        const auto& entries = resources->Unwrap().Entries;
+        resourceData.resize(entries.size());
+        total += entries.size();
+        stage = LoadStage::Resources;
+
+        std::atomic<bool> failed = false;
+        m_Tasks->ParallelFor(0, entries.size(), 1, [&](const size_t from, const size_t to) {
+            for (size_t i = from; i < to && !failed; i++) {
+                auto data = LoadResource(path, pack.get(), entries[i]);
+                if (data.IsErr()) {
+                    // Only the first failure is reported.
+                    if (!failed.exchange(true))
+                        resourcesResult = data.UnwrapErr();
+                    return;
+                }
+                resourceData[i] = data.UnwrapMove();
+                completed++;
+            }
+        });
+    });
+    auto done = m_Tasks->Run([] {}, { metadataTask, resourcesTask });
+
+    FramePacer pacer(LoadingScreenFrameRate);
+    LoadProgress lastReported { .Stage = LoadStage::Parsing, .Completed = 0, .Total = 0 };
+    bool subsystemsInitialized = false;
+    for (;;) {
+        // Subsystem init has to stay on the main thread, so it overlaps with
+        // the resource reads from here.
+        if (!subsystemsInitialized && resourceTableTask.IsDone()) {
+            subsystemsInitialized = true;
+            if (resources->IsOk())
+                subsystemsResult = m_Subsystems->Initialize(SubsystemNeeds::FromResourceTable(resources->Unwrap()));
+        }
+
+        const bool finished = done.IsDone();
+
+        const LoadProgress progress {
+            .Stage = finished ? LoadStage::Done : stage.load(),
+            .Completed = completed.load(),
+            .Total = total.load(),
+        };
+        if (progress.Stage != lastReported.Stage || progress.Completed != lastReported.Completed || progress.Total != lastReported.Total) {
+            m_Logger->debug("Loading: {}/{}", progress.Completed, progress.Total);
+            if (onProgress)
+                onProgress(progress);
+            if (auto res = m_Event->RaiseLoadProgress(luaInterop::LoadProgressEvent(progress.Completed, progress.Total)); !res) {
+                m_Tasks->Wait(done);
+                return res;
+            }
+            lastReported = progress;
+        }
+
+        if (finished)
+            break;
+
+        ENG_TRACE_ZONE("Loading screen");
+        m_Event->Poll();
+        if (auto res = m_Event->Dispatch(); !res) {
+            m_Tasks->Wait(done);
+            return res;
+        }
+        if (auto res = m_Rendering->Update(m_Frames.GetFront()); !res) {
+            m_Tasks->Wait(done);
+            return res;
+        }
+        pacer.Wait();
+    }
+    timer.Lap("Parsing and reading");
+
+    if (metadata->IsErr())
+        return metadata->UnwrapErr();
+    if (resources->IsErr())
+        return resources->UnwrapErr();
+    if (resourcesResult.IsErr())
+        return resourcesResult;
+    if (subsystemsResult.IsErr())
+        return subsystemsResult;
+
+    game::Game game;
+    game.Meta = metadata->UnwrapMove();
+    game.Resources = resources->UnwrapMove();
+
+    // Packs are read-only; a manifest cooked before packing gets packed too.
+    if (m_Cfg.Resources.CookedManifest && !fromCooked && !pack) {
+        WriteCookedManifest(path, manifest::Cooked {
+            .Game = game,
+            .Metadata = metadataSource,
+            .ResourceTable = resourceTableSource,
+        });
+        timer.Lap("Cooking the manifest");
+    }
+
+    auto resourceManager = ResourceManager::New(
+        m_Logger,
+        m_Rendering->GetRenderer(),
+        path,
+        pack,
+        m_Tasks,
+        m_Rendering->GetUploadQueue(),
+        game.Resources,
+        m_Cfg
+    );
+    if (resourceManager.IsErr())
+        return resourceManager.UnwrapErr();
+    if (auto res = resourceManager.Unwrap()->LoadEager(std::move(resourceData)); !res)
+        return res;
+    timer.Lap("Decoding resources");
+
+    // Handles release into the resource manager that issued them, so they
+    // and everything pointing at its textures and fonts are dropped before
+    // m_Resources is replaced.
+    m_ScriptResources.clear();
+    m_Streamer.Clear();
+    m_Script->SetSprites(SpriteTable());
+    m_Script->SetLazySprites(SpriteKeySet());
+    m_Script->SetFonts(FontTable());
+    m_Rendering->GetTextRenderer().Clear();
+
+    m_Game = std::move(game);
+    m_Resources = resourceManager.Unwrap();
+
+    // Scripts draw from the simulation, which may run off the main thread
+    // and so can't load anything. They get the eager sprites and fonts, held
+    // resident while the game is loaded. Lazy sprites are requested by the
+    // main thread when first drawn, and handed over once streamed in.
+    SpriteTable sprites;
+    SpriteKeySet lazySprites;
+    FontTable fonts;
+    for (const auto& res : m_Game->Resources.Entries) {
+        if (res.Lazy && res.Type == game::ResourceType::Sprite)
+            lazySprites.insert(res.Key);
+        if (res.Lazy || (res.Type != game::ResourceType::Sprite && res.Type != game::ResourceType::Font))
+            continue;
+        auto handle = m_Resources->Get(res.Key);
+        if (handle.IsErr())
+            return handle.UnwrapErr();
+        if (res.Type == game::ResourceType::Font) {
+            fonts.emplace(res.Key, handle.Unwrap().GetFont());
+        } else {
+            sprites.emplace(res.Key, Sprite {
+                .Texture = handle.Unwrap().GetTexture(),
+                .Source = handle.Unwrap().GetSourceRect(),
+            });
+        }
+        m_ScriptResources.push_back(handle.UnwrapMove());
     }
+    m_Script->SetSprites(std::move(sprites));
+    m_Script->SetLazySprites(std::move(lazySprites));
+    m_Script->SetFonts(std::move(fonts));
+
+    m_Logger->info("Loaded {} with {} resources", m_Game->Meta.Title, m_Game->Resources.Entries.size());
+    timer.Report(*m_Logger, "Engine::LoadGame");
+
+    return Result();
+}
 
-    auto metadataToml = toml::parse_file((path / "game.toml").string());
+std::optional<game::Game> Engine::LoadCookedManifest(const std::filesystem::path& path, const Pack* pack) const
+{
+    ENG_TRACE_ZONE("Engine::LoadCookedManifest");
+
+    BinaryBuffer file;
+    std::span<const std::byte> bytes;
+    if (pack) {
+        const auto data = pack->Find(manifest::FileName);
+        if (!data)
+            return std::nullopt;
+        bytes = *data;
+    } else {
+        auto read = BinaryBuffer::FromFile(path / manifest::FileName);
+        if (read.IsErr())
+            return std::nullopt;
+        file = read.UnwrapMove();
+        bytes = file.GetBytes();
+    }
+
+    auto cooked = manifest::Read(bytes);
+    if (cooked.IsErr()) {
+        m_Logger->warn("Ignoring the cooked manifest: {}", cooked.UnwrapErr().ToString());
+        return std::nullopt;
+    }
+
+    if (!IsSourceFresh(path, pack, "game.toml", cooked.Unwrap().Metadata)
+        || !IsSourceFresh(path, pack, "resources.xml", cooked.Unwrap().ResourceTable)) {
+        m_Logger->debug("The cooked manifest is stale");
+        return std::nullopt;
+    }
+
+    m_Logger->debug("Using the cooked manifest");
+    return cooked.UnwrapMove().Game;
+}
+
+void Engine::WriteCookedManifest(const std::filesystem::path& path, const manifest::Cooked& cooked) const
+{
+    ENG_TRACE_ZONE("Engine::WriteCookedManifest");
+
+    const auto buffer = manifest::Cook(cooked);
+    const auto& bytes = buffer.GetBytes();
+
+    // Written aside and renamed over, so another instance never sees half
+    // a manifest.
+    const auto target = path / manifest::FileName;
+    auto temporary = target;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+            m_Logger->warn("Couldn't write the cooked manifest to {}", temporary.string());
+            return;
+        }
+    }
+
+    std::error_code errCode;
+    std::filesystem::rename(temporary, target, errCode);
+    if (errCode) {
+        m_Logger->warn("Couldn't write the cooked manifest to {}: {}", target.string(), errCode.message());
+        std::filesystem::remove(temporary, errCode);
+        return;
+    }
+
+    m_Logger->debug("Cooked the manifest into {} ({} bytes)", target.string(), bytes.size());
+}
+
+Result<game::Metadata> Engine::LoadMetadata(const std::string_view document) const
+{
+    ENG_TRACE_ZONE("Engine::LoadMetadata");
+
+    toml::table metadataToml;
+    try {
+        metadataToml = toml::parse(document, "game.toml");
+    } catch (const toml::parse_error& err) {
+        m_Logger->error("Couldn't parse the metadata file: {}", err.description());
+        return Error(Error::InvalidGame, "Couldn't parse the metadata file");
+    }
 
     if (!metadataToml["meta"]["name"].is_string()) {
         m_Logger->error("Required field `name` is missing");
@@ -204,15 +689,15 @@ Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat fo
         return Error::InvalidGame;
     }
 
-    game::Game game;
+    game::Metadata meta;
 
-    game.Meta.Name = metadataToml["meta"]["name"].as_string()->get();
-    game.Meta.Title = metadataToml["meta"]["title"].as_string()->get();
-    game.Meta.Description = metadataToml["meta"]["description"].as_string()->get();
-    game.Meta.Author = metadataToml["meta"]["author"].as_string()->get();
-    game.Meta.License = metadataToml["meta"]["license"].as_string()->get();
-    game.Meta.Version = util::Version::FromString(metadataToml["meta"]["version"].as_string()->get()).UnwrapOrDefault(util::Version::Max());
-    if (game.Meta.Version == util::Version::Max()) {
+    meta.Name = metadataToml["meta"]["name"].as_string()->get();
+    meta.Title = metadataToml["meta"]["title"].as_string()->get();
+    meta.Description = metadataToml["meta"]["description"].as_string()->get();
+    meta.Author = metadataToml["meta"]["author"].as_string()->get();
+    meta.License = metadataToml["meta"]["license"].as_string()->get();
+    meta.Version = util::Version::FromString(metadataToml["meta"]["version"].as_string()->get()).UnwrapOrDefault(util::Version::Max());
+    if (meta.Version == util::Version::Max()) {
         m_Logger->error("Invalid version format");
         return Error::InvalidGame;
     }
@@ -225,11 +710,11 @@ Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat fo
 
         auto platform = platformNode.as_string()->get();
         if (platform == "Linux") {
-            game.Meta.Target.Platforms.emplace_back(game::Platform::Linux);
+            meta.Target.Platforms.emplace_back(game::Platform::Linux);
         } else if (platform == "MacOS") {
-            game.Meta.Target.Platforms.emplace_back(game::Platform::Darwin);
+            meta.Target.Platforms.emplace_back(game::Platform::Darwin);
         } else if (platform == "Windows") {
-            game.Meta.Target.Platforms.emplace_back(game::Platform::Windows);
+            meta.Target.Platforms.emplace_back(game::Platform::Windows);
         } else {
             m_Logger->error("Unknown platform: {}", platform);
             return Error::InvalidGame;
@@ -238,38 +723,45 @@ Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat fo
 
     std::string luaTarget = metadataToml["target"]["lua"].as_string()->get();
     if (luaTarget == "5.4") {
-        game.Meta.Target.Lua = game::LuaTarget::Lua54;
+        meta.Target.Lua = game::LuaTarget::Lua54;
     } else if (luaTarget == "5.1") {
-        game.Meta.Target.Lua = game::LuaTarget::Lua51;
+        meta.Target.Lua = game::LuaTarget::Lua51;
     } else if (luaTarget == "JIT") {
-        game.Meta.Target.Lua = game::LuaTarget::LuaJit;
+        meta.Target.Lua = game::LuaTarget::LuaJit;
     } else {
         m_Logger->error("Unknown lua target: {}", luaTarget);
         return Error::InvalidGame;
     }
 
-    game.Meta.Game.EntryScene = metadataToml["game"]["entry_scene"].as_string()->get();
+    meta.Game.EntryScene = metadataToml["game"]["entry_scene"].as_string()->get();
 
     auto resolutionArray = *metadataToml["graphics"]["resolution"].as_array();
     if (!resolutionArray[0].is_integer() || !resolutionArray[1].is_integer()) {
         m_Logger->error("Invalid resolution");
         return Error::InvalidGame;
     }
-    game.Meta.Graphics.WindowResolution.Width = resolutionArray[0].as_integer()->get();
-    game.Meta.Graphics.WindowResolution.Height = resolutionArray[1].as_integer()->get();
+    meta.Graphics.WindowResolution.Width = resolutionArray[0].as_integer()->get();
+    meta.Graphics.WindowResolution.Height = resolutionArray[1].as_integer()->get();
 
-    game.Meta.Graphics.WindowFullscreen = metadataToml["graphics"]["fullscreen"].as_boolean()->get();
-    game.Meta.Graphics.WindowResizing = metadataToml["graphics"]["allow_resizing"].as_boolean()->get();
+    meta.Graphics.WindowFullscreen = metadataToml["graphics"]["fullscreen"].as_boolean()->get();
+    meta.Graphics.WindowResizing = metadataToml["graphics"]["allow_resizing"].as_boolean()->get();
 
-    game.Meta.Audio.Volume = metadataToml["audio"]["volume"].as_floating_point()->get();
+    meta.Audio.Volume = metadataToml["audio"]["volume"].as_floating_point()->get();
 
-    if (game.Meta.Audio.Volume > 1 || game.Meta.Audio.Volume < 0) {
+    if (meta.Audio.Volume > 1 || meta.Audio.Volume < 0) {
         m_Logger->error("The audio volue must be in the range 0-1");
         return Error::InvalidGame;
     }
 
+    return Result(std::move(meta));
+}
+
+Result<game::ResourceTable> Engine::LoadResourceTable(const std::string_view document) const
+{
+    ENG_TRACE_ZONE("Engine::LoadResourceTable");
+
     tinyxml2::XMLDocument resourceTableXml;
-    auto xmlError = resourceTableXml.LoadFile((path / "resources.xml").c_str());
+    auto xmlError = resourceTableXml.Parse(document.data(), document.size());
     if (xmlError != tinyxml2::XML_SUCCESS) {
         m_Logger->error("Error loading the resource table: {}", resourceTableXml.ErrorStr());
         return Error::Io;
@@ -285,6 +777,7 @@ Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat fo
         return Error(Error::InvalidGame, "The root element isn't a resourceTable");
     }
 
+    game::ResourceTable table;
     for (auto element = rootElem->FirstChildElement("Resource"); element != nullptr; element = element->NextSiblingElement("Resource")) {
         auto type = element->Attribute("type");
         auto key = element->Attribute("key");
@@ -295,7 +788,6 @@ Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat fo
             return Error::InvalidGame;
         }
 
-
         game::ResourceDef res;
         if (std::string_view(type) == "Text") {
             res.Type = game::ResourceType::Text;
@@ -315,21 +807,186 @@ Result<> Engine::LoadGame(const std::filesystem::path& path, const GameFormat fo
         }
         res.Key = key;
         res.Source = source;
+        res.Lazy = element->BoolAttribute("lazy", false);
+        table.Entries.push_back(std::move(res));
     }
 
-    m_Game = game;
+    return Result(std::move(table));
+}
 
-    return Result();
+Result<BinaryBuffer> Engine::LoadResource(const std::filesystem::path& root, const Pack* pack, const game::ResourceDef& res) const
+{
+    ENG_TRACE_ZONE("Engine::LoadResource");
+
+    // Lazy resources are read by the resource manager on first use.
+    if (res.Lazy)
+        return Result(BinaryBuffer());
+
+    // Packed resources are decoded straight from the mapping.
+    if (pack) {
+        const auto data = pack->Find(res.Source);
+        if (!data) {
+            m_Logger->error("Resource {} ({}) is missing from the pack", res.Key, res.Source);
+            return Error(Error::InvalidGame, "A resource is missing from the pack");
+        }
+        pack->Prefetch(*data);
+        return Result(BinaryBuffer());
+    }
+
+    const auto sourcePath = root / res.Source;
+    auto data = BinaryBuffer::FromFile(sourcePath);
+    if (data.IsErr())
+        m_Logger->error("Couldn't read resource {} ({}): {}", res.Key, sourcePath.string(), data.UnwrapErr().ToString());
+
+    return data;
 }
 
-Result<> Engine::Update()
+Result<> Engine::Simulate(const unsigned int ticks, const double deltaTime, const double alpha)
 {
-    if (auto res = m_Event->Update(); !res)
+    ENG_TRACE_ZONE("Engine::Simulate");
+
+    if (auto res = m_Event->Dispatch(); !res)
         return res;
 
-    // m_Script->Update();
+    for (unsigned int i = 0; i < ticks; i++) {
+        if (auto res = Tick(deltaTime); !res)
+            return res;
+    }
+
+    UpdateCulling();
 
-    return m_Rendering->Update();
+    auto& frame = m_Frames.GetBack();
+    BuildFrameData(frame, alpha);
+
+    return m_Script->Draw(frame);
+}
+
+Result<> Engine::Tick(const double deltaTime)
+{
+    ENG_TRACE_ZONE("Engine::Tick");
+
+    m_Scene.Entities.Each<Transform>([](const EntityId, Transform& transform) {
+        transform.PreviousPosition = transform.Position;
+    });
+
+    m_TickCount++;
+
+    if (auto res = m_Script->Update(deltaTime); !res)
+        return res;
+
+    // After the scripts moved things, which hear about it within the tick.
+    m_Collissions.Update(m_Scene.Entities);
+    return m_Script->Collide(m_Collissions.GetEvents());
+}
+
+void Engine::UpdateCulling()
+{
+    ENG_TRACE_ZONE("Engine::UpdateCulling");
+
+    // Entities that stood still keep their bounds, which still cover them:
+    // ticks only ever move the previous position onto the current one.
+    m_Scene.Entities.TakeChanged(m_Changed);
+    for (const uint32_t index : m_Changed) {
+        const EntityId id = m_Scene.Entities.GetEntity(index);
+        const auto* transform = m_Scene.Entities.Find<Transform>(id);
+        const auto* sprite = m_Scene.Entities.Find<Sprite>(id);
+
+        // The size of whole-texture sprites is only known to the renderer.
+        const bool sized = sprite && sprite->Source.w != 0 && sprite->Source.h != 0;
+        const auto unculled = std::lower_bound(m_Unculled.begin(), m_Unculled.end(), index);
+        const bool listed = unculled != m_Unculled.end() && *unculled == index;
+        if (transform && sprite && !sized) {
+            m_Culling.Remove(index);
+            if (!listed)
+                m_Unculled.insert(unculled, index);
+            continue;
+        }
+        if (listed)
+            m_Unculled.erase(unculled);
+        if (!transform || !sprite) {
+            m_Culling.Remove(index);
+            continue;
+        }
+
+        // Covers the interpolated positions as well.
+        const Vector2& previous = transform->PreviousPosition;
+        const Vector2& position = transform->Position;
+        const int left = static_cast<int>(std::min(previous.X, position.X));
+        const int top = static_cast<int>(std::min(previous.Y, position.Y));
+        const int right = static_cast<int>(std::max(previous.X, position.X)) + sprite->Source.w;
+        const int bottom = static_cast<int>(std::max(previous.Y, position.Y)) + sprite->Source.h;
+        m_Culling.Place(index, SDL_Rect { left, top, right - left, bottom - top });
+    }
+}
+
+void Engine::BuildFrameData(FrameData& frame, const double alpha)
+{
+    ENG_TRACE_ZONE("Engine::BuildFrameData");
+
+    frame.Tick = m_TickCount;
+    frame.Alpha = alpha;
+    frame.View = m_Camera;
+    frame.Sprites.clear();
+    frame.Chunks.clear();
+    frame.Commands.Clear();
+    frame.Texts.clear();
+    frame.SpriteRequests.clear();
+
+    const SDL_FRect worldView = m_Camera.GetView();
+    const int left = static_cast<int>(std::floor(worldView.x));
+    const int top = static_cast<int>(std::floor(worldView.y));
+    const SDL_Rect view {
+        left,
+        top,
+        static_cast<int>(std::ceil(worldView.x + worldView.w)) - left,
+        static_cast<int>(std::ceil(worldView.y + worldView.h)) - top,
+    };
+
+    for (const auto& layer : m_Scene.TileLayers)
+        layer.GetChunks(view, frame.Chunks);
+
+    m_Culling.Query(view, m_Visible);
+    if (!m_Unculled.empty()) {
+        m_Visible.insert(m_Visible.end(), m_Unculled.begin(), m_Unculled.end());
+        std::sort(m_Visible.begin(), m_Visible.end());
+    }
+    frame.Culled = m_Culling.GetSize() + m_Unculled.size() - m_Visible.size();
+
+    for (const uint32_t index : m_Visible) {
+        const EntityId id = m_Scene.Entities.GetEntity(index);
+        const auto* transform = m_Scene.Entities.Find<Transform>(id);
+        const auto* sprite = m_Scene.Entities.Find<Sprite>(id);
+        frame.Sprites.push_back(SpriteInstance {
+            .Texture = sprite->Texture,
+            .Source = sprite->Source,
+            .PreviousPosition = transform->PreviousPosition,
+            .Position = transform->Position,
+        });
+    }
+}
+
+Result<> Engine::Update(const FrameData& frame)
+{
+    ENG_TRACE_ZONE("Engine::Update");
+
+    // Decoded on the task workers, uploaded by the rendering engine.
+    if (m_Resources)
+        m_Streamer.Request(*m_Resources, frame.SpriteRequests);
+    return m_Rendering->Update(frame);
+}
+
+void Engine::HandOverSprites()
+{
+    m_Streamer.Collect([this](const std::string& key, const Sprite& sprite) {
+        m_Script->AddSprite(key, sprite);
+    });
+}
+
+void Engine::FitCamera()
+{
+    const SDL_Point size = m_Rendering->GetOutputSize();
+    if (size.x > 0 && size.y > 0)
+        m_Camera.Viewport = SDL_Rect { 0, 0, size.x, size.y };
 }
 
 Result<> Engine::Start() {
@@ -360,15 +1017,129 @@ Result<> Engine::Start() {
 
     m_Rendering->SetWindowTitle(fmt::format("{} - {}", m_Game->Meta.Title, Metadata.Title));
 
+    if (m_Cfg.Loop.TickRate == 0 || m_Cfg.Loop.MaxTicksPerFrame == 0) {
+        m_Logger->error("The tick rate and the tick limit per frame must be positive");
+        return Error(Error::InvalidState, "Invalid loop configuration");
+    }
+
+    if (m_Cfg.Headless.Enabled) {
+        m_Logger->info(
+            "Running headless with a simulated clock for {} frames",
+            m_Cfg.Headless.FrameCount == 0 ? std::string("unlimited") : std::to_string(m_Cfg.Headless.FrameCount)
+        );
+    }
+
+    m_Logger->info(
+        "Simulating at {} ticks/s (at most {} per frame), rendering at {}{}",
+        m_Cfg.Loop.TickRate,
+        m_Cfg.Loop.MaxTicksPerFrame,
+        m_Cfg.Loop.MaxFrameRate == 0 ? std::string("an uncapped frame rate") : fmt::format("up to {} fps", m_Cfg.Loop.MaxFrameRate),
+        m_Cfg.Render.VSync ? " with VSync" : ""
+    );
+    if (m_Cfg.Loop.Pipelined)
+        m_Logger->info("Pipelining simulation and rendering, adding {} frame of latency", GetLatencyFrames());
+
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(Seconds(1.0 / m_Cfg.Loop.TickRate));
+    const auto maxFrameTime = tickDuration * m_Cfg.Loop.MaxTicksPerFrame;
+    const double tickSeconds = Seconds(tickDuration).count();
+
+    // Headless runs advance the clock by exactly one tick per frame and never
+    // wait, so every run simulates and renders the same frames.
+    FramePacer pacer(m_Cfg.Headless.Enabled ? 0 : m_Cfg.Loop.MaxFrameRate);
+    Clock::duration accumulator = Clock::duration::zero();
+    const auto startTime = Clock::now();
+    auto previousFrame = startTime;
+    unsigned int frame = 0;
+
     m_Logger->trace("Entering the main loop");
+    ENG_TRACE_THREAD_NAME("Main");
 
     Result<> res;
+    // Only used in pipelined mode: the simulation of the next frame, running
+    // while the current one renders.
+    TaskHandle simulation;
+    Result<> simulationResult;
     while (m_RunningFlag->load()) {
-        res = Update();
+        if (m_Cfg.Headless.FrameCount != 0 && frame >= m_Cfg.Headless.FrameCount)
+            break;
+        frame++;
+
+        ENG_TRACE_FRAME();
+
+        const auto now = Clock::now();
+        auto frameTime = m_Cfg.Headless.Enabled ? tickDuration : now - previousFrame;
+        previousFrame = now;
+
+        if (frameTime > maxFrameTime) {
+            m_Logger->debug(
+                "Frame took {:.2f}ms, dropping simulation time",
+                Seconds(frameTime).count() * 1000.0
+            );
+            frameTime = maxFrameTime;
+        }
+        accumulator += frameTime;
+
+        unsigned int ticks = 0;
+        while (accumulator >= tickDuration) {
+            accumulator -= tickDuration;
+            ticks++;
+        }
+        ENG_TRACE_COUNTER("Ticks per frame", ticks);
+        const double alpha = Seconds(accumulator).count() / tickSeconds;
+
+        if (m_Cfg.Loop.Pipelined) {
+            // The previous simulation produced the frame we're about to show
+            // and is the only other user of the event queue and the scene.
+            {
+                ENG_TRACE_ZONE("Wait for simulation");
+                m_Tasks->Wait(simulation);
+            }
+            if (simulationResult.IsErr()) {
+                res = simulationResult;
+                break;
+            }
+            m_Frames.Swap();
+
+            m_Event->Poll();
+            HandOverSprites();
+            FitCamera();
+            simulation = m_Tasks->Run([this, ticks, tickSeconds, alpha, &simulationResult] {
+                ENG_TRACE_ZONE("Simulation");
+                simulationResult = Simulate(ticks, tickSeconds, alpha);
+            });
+        } else {
+            m_Event->Poll();
+            HandOverSprites();
+            FitCamera();
+            res = Simulate(ticks, tickSeconds, alpha);
+            if (res.IsErr())
+                break;
+            m_Frames.Swap();
+        }
+
+        res = Update(m_Frames.GetFront());
         if (res.IsErr())
-            return res;
+            break;
+        m_Rendering->AddFrameTime(Seconds(Clock::now() - now).count());
+
+        {
+            ENG_TRACE_ZONE("Frame pacing");
+            pacer.Wait();
+        }
     }
 
+    m_Tasks->Wait(simulation);
+    if (res.IsOk() && simulationResult.IsErr())
+        res = simulationResult;
+    if (res.IsErr())
+        return res;
+
+    const auto elapsed = Seconds(Clock::now() - startTime).count();
+    m_Logger->info(
+        "Ran {} frames in {:.3f}s ({:.3f}ms per frame)",
+        frame, elapsed, frame == 0 ? 0.0 : elapsed * 1000.0 / frame
+    );
+
     return Result();
 }
 
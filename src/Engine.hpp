@@ -2,27 +2,67 @@
 #define ENG_ENGINE_HPP
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 
 #include <spdlog/logger.h>
 #include <string_view>
 #include <toml++/toml.hpp>
+#include <vector>
 
+#include "BinaryBuffer.hpp"
+#include "Camera.hpp"
+#include "CollissionSystem.hpp"
 #include "Config.hpp"
+#include "CullingGrid.hpp"
+#include "FrameData.hpp"
 #include "Game.hpp"
+#include "Manifest.hpp"
+#include "Pack.hpp"
 #include "RenderingEngine.hpp"
+#include "ResourceManager.hpp"
 #include "Result.hpp"
+#include "Scene.hpp"
 #include "ScriptEngine.hpp"
+#include "SpriteStreamer.hpp"
 #include "State.hpp"
+#include "Subsystems.hpp"
+#include "Task.hpp"
 
 namespace engine {
 
 enum class GameFormat {
+    // A folder with `game.toml`, `resources.xml` and the assets.
     FOLDER,
+    // The same packed into a single memory mapped file, see `Pack`.
+    PACK,
 };
 
+// Guesses the format of the game at `path` from its extension.
+GameFormat GetGameFormat(const std::filesystem::path& path);
+
+enum class LoadStage {
+    // Parsing the metadata and the resource table.
+    Parsing,
+    // Loading the resources listed in the resource table.
+    Resources,
+    Done,
+};
+
+struct LoadProgress {
+    LoadStage Stage;
+    // Finished and known work items. `Total` grows once the resource table
+    // has been parsed.
+    size_t Completed;
+    size_t Total;
+};
+
+using LoadProgressCallback = std::function<void(const LoadProgress&)>;
+
 class Engine final {
 public:
     Engine(
@@ -30,7 +70,9 @@ public:
         std::shared_ptr<spdlog::logger> logger,
         std::shared_ptr<ScriptEngine> script,
         std::shared_ptr<RenderingEngine> rendering,
+        std::shared_ptr<Subsystems> subsystems,
         std::shared_ptr<EventEngine> event,
+        std::shared_ptr<TaskDispatcher> tasks,
         std::shared_ptr<std::atomic<bool>> runningFlag,
         std::shared_ptr<std::atomic<State>> state
     );
@@ -38,22 +80,83 @@ public:
 
     static Result<std::shared_ptr<Engine>> New(const int argc, const char* argv[]);
 
-    Result<> LoadGame(const std::filesystem::path& path, const GameFormat gameFormat);
+    // Reads the game on the task workers. The calling (main) thread
+    // initializes the subsystems its resources need, keeps polling events
+    // and rendering meanwhile, and reports progress to `onProgress` and to
+    // the Lua `LoadProgress` event.
+    Result<> LoadGame(const std::filesystem::path& path, const GameFormat gameFormat, const LoadProgressCallback& onProgress = nullptr);
     Result<> Start();
 
     void Shutdown();
 
+    // Null until a game is loaded.
+    inline std::shared_ptr<ResourceManager> GetResources() const { return m_Resources; }
+
+    // How many frames behind the simulation the rendered image is.
+    inline unsigned int GetLatencyFrames() const { return m_Cfg.Loop.Pipelined ? 1 : 0; }
+
 private:
     Config m_Cfg;
     std::optional<game::Game> m_Game;
     const std::shared_ptr<spdlog::logger> m_Logger;
     std::shared_ptr<ScriptEngine> m_Script;
     std::shared_ptr<RenderingEngine> m_Rendering;
+    // Declared after the rendering engine, which shuts SDL down, and before
+    // the resource manager, whose resources need the subsystems.
+    std::shared_ptr<Subsystems> m_Subsystems;
     std::shared_ptr<EventEngine> m_Event;
+    std::shared_ptr<TaskDispatcher> m_Tasks;
     std::shared_ptr<std::atomic<bool>> m_RunningFlag;
     std::shared_ptr<std::atomic<State>> m_State;
+    Scene m_Scene;
+    FrameDataBuffer m_Frames;
+    // Moved by scripts, and the sprites it shows found through the culling
+    // grid, by entity slot. Sprites without a size aren't in the grid and
+    // are always drawn, they're kept sorted. The viewport follows the
+    // renderer's output size.
+    Camera m_Camera;
+    CullingGrid m_Culling;
+    std::vector<uint32_t> m_Unculled;
+    std::vector<uint32_t> m_Visible;
+    // Slots the scene journaled since the last culling update.
+    std::vector<uint32_t> m_Changed;
+    CollissionSystem m_Collissions;
+    uint64_t m_TickCount;
+    // Declared after the rendering engine so it's destroyed first.
+    std::shared_ptr<ResourceManager> m_Resources;
+    // Keeps the sprites and fonts scripts can draw with resident. Released
+    // before the resource manager goes away.
+    std::vector<ResourceHandle> m_ScriptResources;
+    // The lazy sprites scripts drew, the same way.
+    SpriteStreamer m_Streamer;
+
+    // Returns the game from its cooked manifest if there's one matching the
+    // current sources.
+    std::optional<game::Game> LoadCookedManifest(const std::filesystem::path& path, const Pack* pack) const;
+    void WriteCookedManifest(const std::filesystem::path& path, const manifest::Cooked& cooked) const;
+
+    Result<game::Metadata> LoadMetadata(const std::string_view document) const;
+    Result<game::ResourceTable> LoadResourceTable(const std::string_view document) const;
+    // Reads a resource from the game folder. With a pack, only checks that
+    // it's there and starts paging it in.
+    Result<BinaryBuffer> LoadResource(const std::filesystem::path& root, const Pack* pack, const game::ResourceDef& res) const;
 
-    Result<> Update();
+    // Dispatches events, runs `ticks` simulation ticks and fills the back
+    // frame buffer. Doesn't touch SDL, so it can run off the main thread.
+    Result<> Simulate(const unsigned int ticks, const double deltaTime, const double alpha);
+    Result<> Tick(const double deltaTime);
+    // Moves the sprite entities that changed since the last update in the
+    // culling grid over everywhere they appear between the last two ticks,
+    // and drops the ones that are gone or lost their sprite.
+    void UpdateCulling();
+    void BuildFrameData(FrameData& frame, const double alpha);
+    Result<> Update(const FrameData& frame);
+    // Gives the scripts the lazy sprites streamed in so far. Only while no
+    // simulation runs.
+    void HandOverSprites();
+    // Resizes the camera's viewport to the renderer's output, e.g. after the
+    // window was resized. Only while no simulation runs.
+    void FitCamera();
 };
 }
 
@@ -0,0 +1,252 @@
+#include "EntityStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+namespace {
+
+    template <typename T>
+    void SwapRemove(std::vector<T>& column, const size_t row)
+    {
+        if (row + 1 != column.size())
+            column[row] = std::move(column.back());
+        column.pop_back();
+    }
+
+    template <size_t... Indices>
+    void MoveColumns(component::Columns& from, component::Columns& to, const ComponentMask mask, const size_t row, std::index_sequence<Indices...>)
+    {
+        ((mask & (ComponentMask(1) << Indices) ? std::get<Indices>(to).push_back(std::move(std::get<Indices>(from)[row])) : void()), ...);
+    }
+
+    template <size_t... Indices>
+    void EraseColumns(component::Columns& columns, const ComponentMask mask, const size_t row, std::index_sequence<Indices...>)
+    {
+        ((mask & (ComponentMask(1) << Indices) ? SwapRemove(std::get<Indices>(columns), row) : void()), ...);
+    }
+
+    template <size_t... Indices>
+    void ClearColumns(component::Columns& columns, std::index_sequence<Indices...>)
+    {
+        (std::get<Indices>(columns).clear(), ...);
+    }
+
+} // namespace
+
+EntityStore::EntityStore()
+    : m_Archetypes()
+    , m_ArchetypeIndices()
+    , m_Slots()
+    , m_FreeSlot(NoSlot)
+    , m_Size(0)
+    , m_Classes()
+    , m_Changed()
+{
+    GetArchetype(0);
+}
+
+void EntityStore::Reserve(const size_t count)
+{
+    m_Slots.reserve(count);
+}
+
+EntityId EntityStore::Create()
+{
+    return Allocate(0);
+}
+
+void EntityStore::Destroy(const EntityId id)
+{
+    if (!IsAlive(id))
+        return;
+
+    Journal(id.Index);
+    if (Has<EntityClass>(id))
+        UnlinkClass(id);
+    const auto& slot = m_Slots[id.Index];
+    EraseRow(slot.Archetype, slot.Row);
+    Release(id.Index);
+    m_Size--;
+}
+
+void EntityStore::Clear()
+{
+    for (auto& archetype : m_Archetypes) {
+        archetype.Ids.clear();
+        ClearColumns(archetype.Columns, std::make_index_sequence<component::Count>());
+    }
+    for (auto& [name, ids] : m_Classes)
+        ids.clear();
+    for (size_t index = 0; index < m_Slots.size(); index++) {
+        if (m_Slots[index].Archetype == NoArchetype)
+            continue;
+        Journal(static_cast<uint32_t>(index));
+        Release(static_cast<uint32_t>(index));
+    }
+    m_Size = 0;
+}
+
+bool EntityStore::IsAlive(const EntityId id) const
+{
+    return id.Index < m_Slots.size()
+        && m_Slots[id.Index].Archetype != NoArchetype
+        && m_Slots[id.Index].Generation == id.Generation;
+}
+
+EntityId EntityStore::GetEntity(const uint32_t index) const
+{
+    if (index >= m_Slots.size() || m_Slots[index].Archetype == NoArchetype)
+        return InvalidEntity;
+    return EntityId { .Index = index, .Generation = m_Slots[index].Generation };
+}
+
+std::span<const EntityId> EntityStore::GetClass(const Symbol name) const
+{
+    const auto it = m_Classes.find(name);
+    if (it == m_Classes.end())
+        return {};
+    return it->second;
+}
+
+void EntityStore::MarkChanged(const EntityId id)
+{
+    if (IsAlive(id))
+        Journal(id.Index);
+}
+
+void EntityStore::TakeChanged(std::vector<uint32_t>& out)
+{
+    // Swapped, so neither side allocates once both have grown.
+    out.clear();
+    std::swap(out, m_Changed);
+    for (const uint32_t index : out)
+        m_Slots[index].Changed = false;
+}
+
+void EntityStore::Release(const uint32_t index)
+{
+    auto& slot = m_Slots[index];
+    slot.Archetype = NoArchetype;
+    slot.Generation = (slot.Generation + 1) & EntityId::GenerationMask;
+    if (slot.Generation == 0) {
+        slot.Generation = Retired;
+        return;
+    }
+    slot.Row = m_FreeSlot;
+    m_FreeSlot = index;
+}
+
+uint32_t EntityStore::GetArchetype(const ComponentMask mask)
+{
+    if (const auto it = m_ArchetypeIndices.find(mask); it != m_ArchetypeIndices.end())
+        return it->second;
+
+    Archetype archetype {
+        .Mask = mask,
+        .Ids = {},
+        .Columns = {},
+        .Added = {},
+        .Removed = {},
+    };
+    archetype.Added.fill(NoArchetype);
+    archetype.Removed.fill(NoArchetype);
+
+    const auto index = static_cast<uint32_t>(m_Archetypes.size());
+    m_Archetypes.push_back(std::move(archetype));
+    m_ArchetypeIndices.emplace(mask, index);
+    return index;
+}
+
+uint32_t EntityStore::GetNeighbour(const uint32_t archetype, const size_t component, const bool added)
+{
+    const uint32_t cached = added ? m_Archetypes[archetype].Added[component] : m_Archetypes[archetype].Removed[component];
+    if (cached != NoArchetype)
+        return cached;
+
+    const ComponentMask bit = ComponentMask(1) << component;
+    const ComponentMask mask = m_Archetypes[archetype].Mask;
+    // May grow the archetypes, so the edge is written afterwards.
+    const uint32_t neighbour = GetArchetype(added ? mask | bit : mask & ~bit);
+    (added ? m_Archetypes[archetype].Added : m_Archetypes[archetype].Removed)[component] = neighbour;
+    return neighbour;
+}
+
+EntityId EntityStore::Allocate(const uint32_t archetype)
+{
+    uint32_t index = m_FreeSlot;
+    if (index != NoSlot) {
+        m_FreeSlot = m_Slots[index].Row;
+    } else {
+        index = static_cast<uint32_t>(m_Slots.size());
+        m_Slots.push_back(Slot { .Archetype = NoArchetype, .Row = 0, .Generation = 0, .ClassRow = 0, .Changed = false });
+    }
+
+    auto& slot = m_Slots[index];
+    auto& ids = m_Archetypes[archetype].Ids;
+    const EntityId id { .Index = index, .Generation = slot.Generation };
+    ids.push_back(id);
+    slot.Archetype = archetype;
+    slot.Row = static_cast<uint32_t>(ids.size() - 1);
+    m_Size++;
+    Journal(index);
+    return id;
+}
+
+void EntityStore::Move(const EntityId id, const uint32_t archetype)
+{
+    const Slot from = m_Slots[id.Index];
+    auto& source = m_Archetypes[from.Archetype];
+    auto& destination = m_Archetypes[archetype];
+
+    MoveColumns(source.Columns, destination.Columns, source.Mask & destination.Mask, from.Row, std::make_index_sequence<component::Count>());
+    destination.Ids.push_back(id);
+    const auto row = static_cast<uint32_t>(destination.Ids.size() - 1);
+
+    EraseRow(from.Archetype, from.Row);
+    m_Slots[id.Index].Archetype = archetype;
+    m_Slots[id.Index].Row = row;
+}
+
+void EntityStore::EraseRow(const uint32_t archetype, const uint32_t row)
+{
+    auto& entry = m_Archetypes[archetype];
+    EraseColumns(entry.Columns, entry.Mask, row, std::make_index_sequence<component::Count>());
+
+    const EntityId moved = entry.Ids.back();
+    SwapRemove(entry.Ids, row);
+    if (row < entry.Ids.size())
+        m_Slots[moved.Index].Row = row;
+}
+
+void EntityStore::LinkClass(const EntityId id)
+{
+    auto& ids = m_Classes[Get<EntityClass>(id)->Name];
+    m_Slots[id.Index].ClassRow = static_cast<uint32_t>(ids.size());
+    ids.push_back(id);
+}
+
+void EntityStore::UnlinkClass(const EntityId id)
+{
+    auto& ids = m_Classes[Get<EntityClass>(id)->Name];
+    const uint32_t row = m_Slots[id.Index].ClassRow;
+    const EntityId moved = ids.back();
+    SwapRemove(ids, row);
+    if (row < ids.size())
+        m_Slots[moved.Index].ClassRow = row;
+}
+
+void EntityStore::Journal(const uint32_t index)
+{
+    if (m_Slots[index].Changed)
+        return;
+    m_Slots[index].Changed = true;
+    m_Changed.push_back(index);
+}
+
+} // namespace engine
@@ -0,0 +1,299 @@
+#ifndef ENG_ENTITY_STORE_HPP
+#define ENG_ENTITY_STORE_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Components.hpp"
+#include "StringInterner.hpp"
+
+namespace engine {
+
+// Generational handle to an entity: the slot it lives in and how many
+// entities lived there before it. Slots are reused, generations aren't, so a
+// handle kept past its entity's end never finds another one.
+struct EntityId {
+    uint32_t Index;
+    uint32_t Generation;
+
+    bool operator==(const EntityId&) const = default;
+
+    // Generations take 20 bits, so packed handles fit the 53 bits a Lua
+    // number holds exactly.
+    static constexpr int GenerationBits = 20;
+    static constexpr uint32_t GenerationMask = (1u << GenerationBits) - 1;
+
+    inline uint64_t Pack() const { return static_cast<uint64_t>(Generation) << 32 | Index; }
+    static inline EntityId Unpack(const uint64_t packed)
+    {
+        return EntityId {
+            .Index = static_cast<uint32_t>(packed),
+            .Generation = static_cast<uint32_t>(packed >> 32),
+        };
+    }
+};
+
+constexpr EntityId InvalidEntity { .Index = std::numeric_limits<uint32_t>::max(), .Generation = 0 };
+
+using ComponentMask = uint32_t;
+
+namespace component {
+
+    // Every component type, each given the bit of `ComponentMask` at its
+    // index. Adding a component means adding it here.
+    using List = std::tuple<Transform, EntityClass, Collission, Sprite>;
+    constexpr size_t Count = std::tuple_size_v<List>;
+    static_assert(Count <= sizeof(ComponentMask) * 8);
+
+    template <typename T, typename Tuple>
+    struct IndexOf;
+    template <typename T, typename... Ts>
+    struct IndexOf<T, std::tuple<T, Ts...>> : std::integral_constant<size_t, 0> { };
+    template <typename T, typename U, typename... Ts>
+    struct IndexOf<T, std::tuple<U, Ts...>> : std::integral_constant<size_t, 1 + IndexOf<T, std::tuple<Ts...>>::value> { };
+
+    template <typename T>
+    constexpr size_t Index = IndexOf<T, List>::value;
+    template <typename... Ts>
+    constexpr ComponentMask Mask = (ComponentMask(0) | ... | (ComponentMask(1) << Index<Ts>));
+
+    template <typename Tuple>
+    struct ColumnsOf;
+    template <typename... Ts>
+    struct ColumnsOf<std::tuple<Ts...>> {
+        using Type = std::tuple<std::vector<Ts>...>;
+    };
+
+    // A vector per component type, of which an archetype only uses the ones
+    // in its mask.
+    using Columns = ColumnsOf<List>::Type;
+
+} // namespace component
+
+// Entities grouped into archetypes by the set of components they have.
+// Each archetype keeps every component in its own contiguous column, rows
+// lining up, so a system going over one or two components of many entities
+// reads only those, linearly. Adding or removing a component moves the
+// entity's row to the neighbouring archetype, found through a cached edge.
+//
+// Ids index a slot map: a slot per entity pointing at its row, the free
+// ones linked through themselves. Creating, destroying and looking up an
+// entity are constant time and, once the slots and columns have grown to
+// the largest population seen, don't allocate.
+//
+// Entities with an `EntityClass` are also listed by class, so finding those
+// of one costs as much as there are of them. That's why the class can only
+// be changed through `Add`.
+//
+// Entities created, destroyed, given or stripped of a component, or marked
+// through `MarkChanged` are journaled by slot, so a system indexing them on
+// its own, like the culling grid, only revisits those.
+class EntityStore final {
+public:
+    // How components are handed out: classes are indexed, so only const.
+    template <typename T>
+    using Access = std::conditional_t<std::is_same_v<T, EntityClass>, const T, T>;
+
+    EntityStore();
+    ~EntityStore() = default;
+
+    // Makes room for `count` entities' slots.
+    void Reserve(const size_t count);
+
+    // An entity without components.
+    EntityId Create();
+    template <typename... Ts>
+    EntityId Create(Ts&&... components)
+    {
+        constexpr ComponentMask mask = component::Mask<std::decay_t<Ts>...>;
+        static_assert(std::popcount(mask) == sizeof...(Ts), "Components must be of distinct types");
+
+        const uint32_t archetype = GetArchetype(mask);
+        auto& columns = m_Archetypes[archetype].Columns;
+        (std::get<std::vector<std::decay_t<Ts>>>(columns).push_back(std::forward<Ts>(components)), ...);
+        const EntityId id = Allocate(archetype);
+        if constexpr ((mask & component::Mask<EntityClass>) != 0)
+            LinkClass(id);
+        return id;
+    }
+    // Does nothing for a stale id.
+    void Destroy(const EntityId id);
+    // Destroys every entity, staling every id handed out. Archetypes are
+    // kept, with their memory.
+    void Clear();
+
+    bool IsAlive(const EntityId id) const;
+    // The live entity in slot `index`, or `InvalidEntity`.
+    EntityId GetEntity(const uint32_t index) const;
+
+    template <typename T>
+    bool Has(const EntityId id) const
+    {
+        return IsAlive(id) && (m_Archetypes[m_Slots[id.Index].Archetype].Mask & component::Mask<T>) != 0;
+    }
+
+    // Null if the entity is dead or doesn't have a `T`. Valid until the next
+    // structural change. Writes through it aren't journaled, see
+    // `MarkChanged`.
+    template <typename T>
+    Access<T>* Find(const EntityId id)
+    {
+        return Get<T>(id);
+    }
+    template <typename T>
+    const T* Find(const EntityId id) const
+    {
+        return const_cast<EntityStore*>(this)->Get<T>(id);
+    }
+
+    // Gives a live entity `component`, replacing the one it has.
+    template <typename T>
+    Access<T>& Add(const EntityId id, T component)
+    {
+        Journal(id.Index);
+        if (T* existing = Get<T>(id)) {
+            if constexpr (std::is_same_v<T, EntityClass>) {
+                if (existing->Name != component.Name) {
+                    UnlinkClass(id);
+                    *existing = std::move(component);
+                    LinkClass(id);
+                }
+            } else {
+                *existing = std::move(component);
+            }
+            return *existing;
+        }
+
+        const uint32_t archetype = GetNeighbour(m_Slots[id.Index].Archetype, component::Index<T>, true);
+        auto& column = std::get<std::vector<T>>(m_Archetypes[archetype].Columns);
+        column.push_back(std::move(component));
+        Move(id, archetype);
+        if constexpr (std::is_same_v<T, EntityClass>)
+            LinkClass(id);
+        return column.back();
+    }
+
+    template <typename T>
+    void Remove(const EntityId id)
+    {
+        if (!Has<T>(id))
+            return;
+        Journal(id.Index);
+        if constexpr (std::is_same_v<T, EntityClass>)
+            UnlinkClass(id);
+        Move(id, GetNeighbour(m_Slots[id.Index].Archetype, component::Index<T>, false));
+    }
+
+    // Calls `body(id, components&...)` for every entity with at least the
+    // components `Ts`, archetype by archetype. Entities mustn't be created,
+    // destroyed or change components meanwhile. Classes are passed const.
+    template <typename... Ts, typename F>
+    void Each(F&& body)
+    {
+        constexpr ComponentMask mask = component::Mask<Ts...>;
+        for (auto& archetype : m_Archetypes) {
+            if ((archetype.Mask & mask) != mask || archetype.Ids.empty())
+                continue;
+
+            const EntityId* ids = archetype.Ids.data();
+            const size_t count = archetype.Ids.size();
+            [&](Access<Ts>*... columns) {
+                for (size_t row = 0; row < count; row++)
+                    body(ids[row], columns[row]...);
+            }(std::get<std::vector<Ts>>(archetype.Columns).data()...);
+        }
+    }
+
+    // The live entities of class `name`, in no particular order. Valid until
+    // the next structural change.
+    std::span<const EntityId> GetClass(const Symbol name) const;
+
+    // Journals a live entity whose components were written in place.
+    void MarkChanged(const EntityId id);
+    // Replaces `out` with the slots journaled since the last call, each
+    // once. Their entities may be gone, or another may live there now.
+    void TakeChanged(std::vector<uint32_t>& out);
+
+    inline size_t GetSize() const { return m_Size; }
+    // One past the largest slot index handed out so far.
+    inline size_t GetSlotCount() const { return m_Slots.size(); }
+    inline size_t GetArchetypeCount() const { return m_Archetypes.size(); }
+
+private:
+    static constexpr uint32_t NoArchetype = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NoSlot = std::numeric_limits<uint32_t>::max();
+    // The generation of slots that went through every generation. They're
+    // never reused, rather than hand out ids matching stale ones.
+    static constexpr uint32_t Retired = std::numeric_limits<uint32_t>::max();
+
+    struct Archetype {
+        ComponentMask Mask;
+        std::vector<EntityId> Ids;
+        component::Columns Columns;
+        // Archetypes with a component added or removed, by component index,
+        // looked up on first use.
+        std::array<uint32_t, component::Count> Added;
+        std::array<uint32_t, component::Count> Removed;
+    };
+
+    // Where a live entity's row is. Free slots have no archetype and keep
+    // the next free slot in `Row`.
+    struct Slot {
+        uint32_t Archetype;
+        uint32_t Row;
+        uint32_t Generation;
+        // Where the entity is in its class's list, if it has a class.
+        uint32_t ClassRow;
+        // In `m_Changed`.
+        bool Changed;
+    };
+
+    std::vector<Archetype> m_Archetypes;
+    std::unordered_map<ComponentMask, uint32_t> m_ArchetypeIndices;
+    std::vector<Slot> m_Slots;
+    uint32_t m_FreeSlot;
+    size_t m_Size;
+    // Lists are kept when they empty out, as the classes tend to come back.
+    std::unordered_map<Symbol, std::vector<EntityId>> m_Classes;
+    std::vector<uint32_t> m_Changed;
+
+    template <typename T>
+    T* Get(const EntityId id)
+    {
+        if (!Has<T>(id))
+            return nullptr;
+        const auto& slot = m_Slots[id.Index];
+        return &std::get<std::vector<T>>(m_Archetypes[slot.Archetype].Columns)[slot.Row];
+    }
+
+    // Frees a slot, now or once it's been through every generation.
+    void Release(const uint32_t index);
+
+    uint32_t GetArchetype(const ComponentMask mask);
+    uint32_t GetNeighbour(const uint32_t archetype, const size_t component, const bool added);
+    // Gives the row just pushed to `archetype`'s columns an id.
+    EntityId Allocate(const uint32_t archetype);
+    // Moves the components `id` shares with `archetype` there. The ones only
+    // `archetype` has must already be pushed, the ones only the entity's
+    // current archetype has are dropped.
+    void Move(const EntityId id, const uint32_t archetype);
+    // Swaps the last row of `archetype` into `row`.
+    void EraseRow(const uint32_t archetype, const uint32_t row);
+    // Adds a live entity with a class to its class's list, or takes it out.
+    void LinkClass(const EntityId id);
+    void UnlinkClass(const EntityId id);
+    void Journal(const uint32_t index);
+};
+
+} // namespace engine
+
+#endif // !ENG_ENTITY_STORE_HPP
@@ -7,6 +7,7 @@
 #include <SDL2/SDL_events.h>
 
 #include "LuaInterop.hpp"
+#include "Trace.hpp"
 
 namespace engine {
 
@@ -16,7 +17,7 @@ EventEngine::EventEngine(
     std::shared_ptr<std::atomic<State>> state,
     std::shared_ptr<RenderingEngine> rendering
 )
-    : m_Event()
+    : m_Pending()
     , m_Logger(logger)
     , m_RunningFlag(runningflag)
     , m_State(state)
@@ -42,10 +43,34 @@ Result<std::shared_ptr<EventEngine>> EventEngine::New(
 
 Result<> EventEngine::Update()
 {
+    Poll();
+    return Dispatch();
+}
+
+void EventEngine::Poll()
+{
+    ENG_TRACE_ZONE("EventEngine::Poll");
+
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+        m_Pending.push_back(event);
+
+    ENG_TRACE_COUNTER("SDL events", m_Pending.size());
+}
+
+Result<> EventEngine::Dispatch()
+{
+    ENG_TRACE_ZONE("EventEngine::Dispatch");
+
     State state = m_State->load();
 
-    while (SDL_PollEvent(&m_Event)) {
-        const SDL_Event& e = m_Event;
+    // Cleared even if a handler fails half way through.
+    struct ClearOnExit {
+        std::vector<SDL_Event>& Events;
+        ~ClearOnExit() { Events.clear(); }
+    } clearOnExit { m_Pending };
+
+    for (const SDL_Event& e : m_Pending) {
 
         switch (e.type) {
         case SDL_QUIT: {
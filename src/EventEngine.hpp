@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <spdlog/logger.h>
 #include <SDL2/SDL_events.h>
@@ -45,6 +46,7 @@ enum class LuaEvent : size_t {
     MouseScroll,
     TextInput,
     TextEditing,
+    LoadProgress,
     _EnumeratorCount,
 };
 
@@ -66,16 +68,28 @@ public:
         std::shared_ptr<RenderingEngine> rendering
     );
 
+    // Polls and dispatches in one go.
     Result<> Update();
 
+    // Drains the SDL event queue. Must be called on the main thread.
+    void Poll();
+    // Handles the events collected by `Poll`, including the Lua handlers.
+    // May run on any thread, as long as it doesn't overlap with `Poll`.
+    Result<> Dispatch();
+
     inline void EnableTextInput() { return SDL_StartTextInput(); }
 
     inline void DisableTextInput() { return SDL_StopTextInput(); }
 
+    inline Result<> RaiseLoadProgress(const luaInterop::LoadProgressEvent& event)
+    {
+        return RaiseLuaEvent(LuaEvent::LoadProgress, event);
+    }
+
     void SetLuaEventHandler(const LuaEvent event, std::shared_ptr<sol::function> handler);
 
 private:
-    SDL_Event m_Event;
+    std::vector<SDL_Event> m_Pending;
     std::shared_ptr<spdlog::logger> m_Logger;
     std::shared_ptr<std::atomic<bool>> m_RunningFlag;
     std::shared_ptr<std::atomic<State>> m_State;
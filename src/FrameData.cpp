@@ -0,0 +1,16 @@
+#include "FrameData.hpp"
+
+namespace engine {
+
+FrameDataBuffer::FrameDataBuffer()
+    : m_Frames()
+    , m_Front(0)
+{
+}
+
+void FrameDataBuffer::Swap()
+{
+    m_Front ^= 1;
+}
+
+} // namespace engine
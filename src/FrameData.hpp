@@ -0,0 +1,74 @@
+#ifndef ENG_FRAME_DATA_HPP
+#define ENG_FRAME_DATA_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL_render.h>
+
+#include "Camera.hpp"
+#include "RenderQueue.hpp"
+#include "TextRenderer.hpp"
+#include "Tilemap.hpp"
+#include "Vector2.hpp"
+
+namespace engine {
+
+struct SpriteInstance {
+    SDL_Texture *Texture;
+    // Zero sized means the whole texture.
+    SDL_Rect Source;
+    SDL_Color Color { 255, 255, 255, 255 };
+    // Degrees clockwise around the sprite's center.
+    float Rotation = 0.0f;
+    // World positions at the last two simulation ticks, rendering
+    // interpolates between them.
+    Vector2 PreviousPosition;
+    Vector2 Position;
+};
+
+// Everything the renderer needs to draw one frame. Filled in by the
+// simulation and treated as immutable once handed to the renderer.
+struct FrameData {
+    uint64_t Tick = 0;
+    double Alpha = 0.0;
+    // Only the sprites in the camera's view.
+    std::vector<SpriteInstance> Sprites;
+    Camera View;
+    // Tile layer chunks in the camera's view.
+    std::vector<TileChunkInstance> Chunks;
+    // Sprite entities left out of `Sprites` for being out of view.
+    size_t Culled = 0;
+    // Drawn along with the sprites, which go to `renderKey::DefaultLayer`.
+    RenderQueue Commands;
+    // Laid out and drawn by the renderer, as only it may rasterize glyphs.
+    std::vector<TextCommand> Texts;
+    // Lazy sprites the scripts drew before they were streamed in, for the
+    // main thread to request.
+    std::vector<std::string> SpriteRequests;
+};
+
+// Double buffer of FrameData: the simulation fills the back slot while the
+// renderer reads the front one. The caller has to make sure the writer is
+// done before calling `Swap`.
+class FrameDataBuffer final {
+public:
+    FrameDataBuffer();
+    ~FrameDataBuffer() = default;
+
+    inline FrameData& GetBack() { return m_Frames[m_Front ^ 1]; }
+    inline const FrameData& GetFront() const { return m_Frames[m_Front]; }
+
+    void Swap();
+
+private:
+    std::array<FrameData, 2> m_Frames;
+    size_t m_Front;
+};
+
+} // namespace engine
+
+#endif // !ENG_FRAME_DATA_HPP
@@ -91,7 +91,8 @@ namespace game {
         ResourceType Type;
         std::string Key;
         std::string Source;
-        bool Lazy;
+        // Loaded on first use instead of with the game.
+        bool Lazy = false;
     };
 
     struct ResourceTable {
@@ -171,6 +171,13 @@ Result<> Register(sol::state_view lua)
             "Middle", MouseButton::Middle
         );
 
+        lua.new_enum(
+            "CollissionPhase",
+            "Enter", CollissionPhase::Enter,
+            "Stay", CollissionPhase::Stay,
+            "Exit", CollissionPhase::Exit
+        );
+
         lua.new_usertype<Event>(
             "Event"
         );
@@ -275,9 +282,18 @@ Result<> Register(sol::state_view lua)
             "MouseScrollEvent",
             sol::base_classes, sol::bases<Event>()
         );
+        lua.new_usertype<LoadProgressEvent>(
+            "LoadProgressEvent",
+            sol::base_classes, sol::bases<Event>(),
+            "completed", &LoadProgressEvent::Completed,
+            "total", &LoadProgressEvent::Total
+        );
         lua.new_usertype<CollissionEvent>(
             "CollissionEvent",
-            sol::base_classes, sol::bases<Event, PositionedEvent>()
+            sol::base_classes, sol::bases<Event, PositionedEvent>(),
+            "phase", &CollissionEvent::Phase,
+            "a", &CollissionEvent::A,
+            "b", &CollissionEvent::B
         );
     } catch (const std::exception& ex) {
         return Error(Error::LuaInit, ex.what());
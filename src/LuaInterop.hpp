@@ -1,11 +1,13 @@
 #ifndef ENG_LUA_INTEROP_HPP
 #define ENG_LUA_INTEROP_HPP
 
+#include <cstddef>
 #include <cstdint>
 
 #include <sol/state_view.hpp>
 #include <SDL2/SDL_keycode.h>
 
+#include "CollissionSystem.hpp"
 #include "Result.hpp"
 #include "SDL_mouse.h"
 
@@ -241,9 +243,32 @@ struct MouseScrollEvent : Event {
     int32_t Y;
 };
 
+// Loading events
+struct LoadProgressEvent : Event {
+    inline LoadProgressEvent(size_t completed, size_t total)
+        : Completed(completed)
+        , Total(total)
+    {
+    }
+
+    size_t Completed;
+    size_t Total;
+};
+
 // Collider events
 struct CollissionEvent : PositionedEvent {
-    // Entity Other;
+    inline CollissionEvent(unsigned int x, unsigned int y, CollissionPhase phase, double a, double b)
+        : PositionedEvent(x, y)
+        , Phase(phase)
+        , A(a)
+        , B(b)
+    {
+    }
+
+    CollissionPhase Phase;
+    // The entities, as the ids scripts get from `spawn_entity`.
+    double A;
+    double B;
 };
 
 Result<> Register(sol::state_view lua);
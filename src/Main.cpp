@@ -8,6 +8,7 @@
 int main(const int argc, const char **argv)
 {
     auto e = engine::Engine::New(argc, argv).Unwrap();
-    e->LoadGame(std::filesystem::path("/home/ducktectivecz/.duckengine/games/test/"), engine::GameFormat::FOLDER).Unwrap();
+    const std::filesystem::path game("/home/ducktectivecz/.duckengine/games/test/");
+    e->LoadGame(game, engine::GetGameFormat(game)).Unwrap();
     e->Start().Unwrap();
 }
@@ -0,0 +1,235 @@
+#include "Manifest.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "BinaryBuffer.hpp"
+#include "Game.hpp"
+#include "Result.hpp"
+#include "Trace.hpp"
+#include "Util.hpp"
+
+namespace engine {
+namespace manifest {
+
+    namespace {
+
+        // Integers are written in native byte order; a manifest is a cache
+        // for the machine that cooked it, not an interchange format.
+        class Writer final {
+        public:
+            explicit Writer(std::vector<std::byte>& out)
+                : m_Out(out)
+            {
+            }
+
+            template <typename T>
+            void Write(const T value)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+                m_Out.insert(m_Out.end(), bytes, bytes + sizeof(T));
+            }
+
+            void WriteString(const std::string_view str)
+            {
+                Write(static_cast<uint32_t>(str.size()));
+                const auto* bytes = reinterpret_cast<const std::byte*>(str.data());
+                m_Out.insert(m_Out.end(), bytes, bytes + str.size());
+            }
+
+            void WriteSource(const SourceInfo& source)
+            {
+                Write(source.Hash);
+                Write(source.ModifiedTime);
+                Write(source.Size);
+            }
+
+        private:
+            std::vector<std::byte>& m_Out;
+        };
+
+        // Every read is bounds checked. Once one fails, the reader stays
+        // failed and returns zeroes.
+        class Reader final {
+        public:
+            explicit Reader(const std::span<const std::byte> bytes)
+                : m_Bytes(bytes)
+            {
+            }
+
+            template <typename T>
+            T Read()
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                T value {};
+                if (!Take(sizeof(T)))
+                    return value;
+                std::memcpy(&value, m_Bytes.data() + m_Position - sizeof(T), sizeof(T));
+                return value;
+            }
+
+            std::string ReadString()
+            {
+                const auto size = Read<uint32_t>();
+                if (!Take(size))
+                    return std::string();
+                return std::string(reinterpret_cast<const char*>(m_Bytes.data() + m_Position - size), size);
+            }
+
+            SourceInfo ReadSource()
+            {
+                SourceInfo source;
+                source.Hash = Read<uint64_t>();
+                source.ModifiedTime = Read<int64_t>();
+                source.Size = Read<uint64_t>();
+                return source;
+            }
+
+            inline bool IsOk() const { return m_Ok; }
+            inline bool IsAtEnd() const { return m_Position == m_Bytes.size(); }
+
+        private:
+            std::span<const std::byte> m_Bytes;
+            size_t m_Position = 0;
+            bool m_Ok = true;
+
+            bool Take(const size_t size)
+            {
+                if (!m_Ok || size > m_Bytes.size() - m_Position) {
+                    m_Ok = false;
+                    return false;
+                }
+                m_Position += size;
+                return true;
+            }
+        };
+
+    } // namespace
+
+    BinaryBuffer Cook(const Cooked& cooked)
+    {
+        ENG_TRACE_ZONE("manifest::Cook");
+
+        BinaryBuffer buffer(1024);
+        Writer writer(buffer.GetBytes());
+
+        for (const char c : Magic)
+            writer.Write(c);
+        writer.Write(Version);
+        writer.WriteSource(cooked.Metadata);
+        writer.WriteSource(cooked.ResourceTable);
+
+        const auto& meta = cooked.Game.Meta;
+        writer.WriteString(meta.Name);
+        writer.WriteString(meta.Title);
+        writer.WriteString(meta.Author);
+        writer.WriteString(meta.License);
+        writer.Write(static_cast<uint8_t>(meta.Description.has_value()));
+        writer.WriteString(meta.Description.value_or(std::string()));
+        writer.Write(static_cast<uint32_t>(meta.Version.Major));
+        writer.Write(static_cast<uint32_t>(meta.Version.Minor));
+        writer.Write(static_cast<uint32_t>(meta.Version.Patch));
+
+        writer.WriteString(meta.Game.EntryScene);
+        writer.Write(static_cast<uint32_t>(meta.Graphics.WindowResolution.Width));
+        writer.Write(static_cast<uint32_t>(meta.Graphics.WindowResolution.Height));
+        writer.Write(static_cast<uint8_t>(meta.Graphics.WindowFullscreen));
+        writer.Write(static_cast<uint8_t>(meta.Graphics.WindowResizing));
+        writer.Write(meta.Audio.Volume);
+
+        writer.Write(static_cast<uint32_t>(meta.Target.Platforms.size()));
+        for (const auto platform : meta.Target.Platforms)
+            writer.Write(static_cast<uint8_t>(platform));
+        writer.Write(static_cast<uint8_t>(meta.Target.Lua));
+
+        const auto& entries = cooked.Game.Resources.Entries;
+        writer.Write(static_cast<uint32_t>(entries.size()));
+        for (const auto& res : entries) {
+            writer.Write(static_cast<uint8_t>(res.Type));
+            writer.WriteString(res.Key);
+            writer.WriteString(res.Source);
+            writer.Write(static_cast<uint8_t>(res.Lazy));
+        }
+
+        return buffer;
+    }
+
+    Result<Cooked> Read(const std::span<const std::byte> bytes)
+    {
+        ENG_TRACE_ZONE("manifest::Read");
+
+        Reader reader(bytes);
+
+        char magic[sizeof(Magic)];
+        for (char& c : magic)
+            c = reader.Read<char>();
+        if (!reader.IsOk() || std::memcmp(magic, Magic, sizeof(Magic)) != 0)
+            return Error(Error::InvalidFormat, "Bad cooked manifest magic");
+        if (reader.Read<uint32_t>() != Version)
+            return Error(Error::InvalidFormat, "Cooked manifest of another version");
+
+        Cooked cooked;
+        cooked.Metadata = reader.ReadSource();
+        cooked.ResourceTable = reader.ReadSource();
+
+        auto& meta = cooked.Game.Meta;
+        meta.Name = reader.ReadString();
+        meta.Title = reader.ReadString();
+        meta.Author = reader.ReadString();
+        meta.License = reader.ReadString();
+        const bool hasDescription = reader.Read<uint8_t>() != 0;
+        auto description = reader.ReadString();
+        meta.Description = hasDescription ? std::optional(std::move(description)) : std::nullopt;
+        meta.Version.Major = reader.Read<uint32_t>();
+        meta.Version.Minor = reader.Read<uint32_t>();
+        meta.Version.Patch = reader.Read<uint32_t>();
+
+        meta.Game.EntryScene = reader.ReadString();
+        meta.Graphics.WindowResolution.Width = reader.Read<uint32_t>();
+        meta.Graphics.WindowResolution.Height = reader.Read<uint32_t>();
+        meta.Graphics.WindowFullscreen = reader.Read<uint8_t>() != 0;
+        meta.Graphics.WindowResizing = reader.Read<uint8_t>() != 0;
+        meta.Audio.Volume = reader.Read<float>();
+
+        const auto platformCount = reader.Read<uint32_t>();
+        for (uint32_t i = 0; i < platformCount && reader.IsOk(); i++) {
+            const auto platform = reader.Read<uint8_t>();
+            if (platform > static_cast<uint8_t>(game::Platform::Windows))
+                return Error(Error::InvalidFormat, "Unknown platform in the cooked manifest");
+            meta.Target.Platforms.push_back(static_cast<game::Platform>(platform));
+        }
+        const auto lua = reader.Read<uint8_t>();
+        if (lua > static_cast<uint8_t>(game::LuaTarget::LuaJit))
+            return Error(Error::InvalidFormat, "Unknown Lua target in the cooked manifest");
+        meta.Target.Lua = static_cast<game::LuaTarget>(lua);
+
+        const auto entryCount = reader.Read<uint32_t>();
+        auto& entries = cooked.Game.Resources.Entries;
+        for (uint32_t i = 0; i < entryCount && reader.IsOk(); i++) {
+            game::ResourceDef res;
+            const auto type = reader.Read<uint8_t>();
+            if (type > static_cast<uint8_t>(game::ResourceType::Animation))
+                return Error(Error::InvalidFormat, "Unknown resource type in the cooked manifest");
+            res.Type = static_cast<game::ResourceType>(type);
+            res.Key = reader.ReadString();
+            res.Source = reader.ReadString();
+            res.Lazy = reader.Read<uint8_t>() != 0;
+            entries.push_back(std::move(res));
+        }
+
+        if (!reader.IsOk() || !reader.IsAtEnd())
+            return Error(Error::InvalidFormat, "Truncated or oversized cooked manifest");
+
+        return Result(std::move(cooked));
+    }
+
+} // namespace manifest
+} // namespace engine
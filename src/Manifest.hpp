@@ -0,0 +1,49 @@
+#ifndef ENG_MANIFEST_HPP
+#define ENG_MANIFEST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "BinaryBuffer.hpp"
+#include "Game.hpp"
+#include "Result.hpp"
+
+namespace engine {
+
+// A cooked manifest is `game::Game` (the parsed `game.toml` and
+// `resources.xml`) serialized into a compact binary form, so later starts
+// can skip the TOML and XML parsers. It records what its sources looked like
+// when it was cooked and is only used while they still match.
+namespace manifest {
+
+    constexpr std::string_view FileName = "game.cooked";
+
+    constexpr char Magic[4] = { 'D', 'C', 'M', 'F' };
+    // Bump whenever `game::Game` or the encoding changes.
+    constexpr uint32_t Version = 1;
+
+    struct SourceInfo {
+        // `util::Fnv1a` of the contents.
+        uint64_t Hash;
+        // Zero for sources inside a pack, which can't change under us.
+        int64_t ModifiedTime;
+        uint64_t Size;
+
+        bool operator==(const SourceInfo& other) const = default;
+    };
+
+    struct Cooked {
+        game::Game Game;
+        SourceInfo Metadata;
+        SourceInfo ResourceTable;
+    };
+
+    BinaryBuffer Cook(const Cooked& cooked);
+    Result<Cooked> Read(const std::span<const std::byte> bytes);
+
+} // namespace manifest
+} // namespace engine
+
+#endif // !ENG_MANIFEST_HPP
@@ -0,0 +1,253 @@
+#include "NarrowPhase.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "Simd.hpp"
+
+#ifdef ENG_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace engine {
+namespace narrow {
+
+void PairBatch::Clear()
+{
+    AX.clear();
+    AY.clear();
+    AHalfWidth.clear();
+    AHalfHeight.clear();
+    BX.clear();
+    BY.clear();
+    BHalfWidth.clear();
+    BHalfHeight.clear();
+}
+
+void PairBatch::Push(const Shape& a, const Shape& b)
+{
+    AX.push_back(a.X);
+    AY.push_back(a.Y);
+    AHalfWidth.push_back(a.HalfWidth);
+    AHalfHeight.push_back(a.HalfHeight);
+    BX.push_back(b.X);
+    BY.push_back(b.Y);
+    BHalfWidth.push_back(b.HalfWidth);
+    BHalfHeight.push_back(b.HalfHeight);
+}
+
+namespace {
+
+    // Per pair, also finishing the vector kernels' last few pairs. The
+    // vector kernels do the same operations in the same order, and the
+    // build doesn't fuse multiplies and adds, so they round the same.
+
+    inline bool RectanglesAt(const PairBatch& pairs, const size_t i)
+    {
+        const float dx = std::fabs(pairs.AX[i] - pairs.BX[i]);
+        const float dy = std::fabs(pairs.AY[i] - pairs.BY[i]);
+        return dx < pairs.AHalfWidth[i] + pairs.BHalfWidth[i] && dy < pairs.AHalfHeight[i] + pairs.BHalfHeight[i];
+    }
+
+    inline bool CirclesAt(const PairBatch& pairs, const size_t i)
+    {
+        const float dx = std::fabs(pairs.AX[i] - pairs.BX[i]);
+        const float dy = std::fabs(pairs.AY[i] - pairs.BY[i]);
+        const float radius = pairs.AHalfWidth[i] + pairs.BHalfWidth[i];
+        return dx * dx + dy * dy < radius * radius;
+    }
+
+    // The distance from the circle's centre to the rectangle, against the
+    // radius.
+    inline bool RectangleCircleAt(const PairBatch& pairs, const size_t i)
+    {
+        const float dx = std::fabs(pairs.AX[i] - pairs.BX[i]);
+        const float dy = std::fabs(pairs.AY[i] - pairs.BY[i]);
+        const float qx = std::max(dx - pairs.AHalfWidth[i], 0.0f);
+        const float qy = std::max(dy - pairs.AHalfHeight[i], 0.0f);
+        return qx * qx + qy * qy < pairs.BHalfWidth[i] * pairs.BHalfWidth[i];
+    }
+
+    template <bool (*Test)(const PairBatch&, const size_t)>
+    void Finish(const PairBatch& pairs, const size_t begin, uint8_t* touching)
+    {
+        for (size_t i = begin; i < pairs.GetSize(); i++)
+            touching[i] = Test(pairs, i) ? 1 : 0;
+    }
+
+    void RectanglesScalar(const PairBatch& pairs, uint8_t* touching)
+    {
+        Finish<RectanglesAt>(pairs, 0, touching);
+    }
+
+    void CirclesScalar(const PairBatch& pairs, uint8_t* touching)
+    {
+        Finish<CirclesAt>(pairs, 0, touching);
+    }
+
+    void RectangleCircleScalar(const PairBatch& pairs, uint8_t* touching)
+    {
+        Finish<RectangleCircleAt>(pairs, 0, touching);
+    }
+
+    constexpr Kernels ScalarKernels {
+        .Level = simd::Level::Scalar,
+        .Rectangles = RectanglesScalar,
+        .Circles = CirclesScalar,
+        .RectangleCircle = RectangleCircleScalar,
+    };
+
+#ifdef ENG_SIMD_X86
+
+    // SSE2: four pairs per register.
+
+    inline void StoreSse2(const __m128 mask, uint8_t* touching)
+    {
+        const int bits = _mm_movemask_ps(mask);
+        for (int lane = 0; lane < 4; lane++)
+            touching[lane] = static_cast<uint8_t>((bits >> lane) & 1);
+    }
+
+    // |a - b| of four pairs.
+    inline __m128 DistanceSse2(const float* a, const float* b)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+    }
+
+    void RectanglesSse2(const PairBatch& pairs, uint8_t* touching)
+    {
+        size_t i = 0;
+        for (; i + 4 <= pairs.GetSize(); i += 4) {
+            const __m128 dx = DistanceSse2(&pairs.AX[i], &pairs.BX[i]);
+            const __m128 dy = DistanceSse2(&pairs.AY[i], &pairs.BY[i]);
+            const __m128 width = _mm_add_ps(_mm_loadu_ps(&pairs.AHalfWidth[i]), _mm_loadu_ps(&pairs.BHalfWidth[i]));
+            const __m128 height = _mm_add_ps(_mm_loadu_ps(&pairs.AHalfHeight[i]), _mm_loadu_ps(&pairs.BHalfHeight[i]));
+            StoreSse2(_mm_and_ps(_mm_cmplt_ps(dx, width), _mm_cmplt_ps(dy, height)), &touching[i]);
+        }
+        Finish<RectanglesAt>(pairs, i, touching);
+    }
+
+    void CirclesSse2(const PairBatch& pairs, uint8_t* touching)
+    {
+        size_t i = 0;
+        for (; i + 4 <= pairs.GetSize(); i += 4) {
+            const __m128 dx = DistanceSse2(&pairs.AX[i], &pairs.BX[i]);
+            const __m128 dy = DistanceSse2(&pairs.AY[i], &pairs.BY[i]);
+            const __m128 radius = _mm_add_ps(_mm_loadu_ps(&pairs.AHalfWidth[i]), _mm_loadu_ps(&pairs.BHalfWidth[i]));
+            const __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            StoreSse2(_mm_cmplt_ps(distance, _mm_mul_ps(radius, radius)), &touching[i]);
+        }
+        Finish<CirclesAt>(pairs, i, touching);
+    }
+
+    void RectangleCircleSse2(const PairBatch& pairs, uint8_t* touching)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 4 <= pairs.GetSize(); i += 4) {
+            const __m128 dx = DistanceSse2(&pairs.AX[i], &pairs.BX[i]);
+            const __m128 dy = DistanceSse2(&pairs.AY[i], &pairs.BY[i]);
+            const __m128 qx = _mm_max_ps(_mm_sub_ps(dx, _mm_loadu_ps(&pairs.AHalfWidth[i])), zero);
+            const __m128 qy = _mm_max_ps(_mm_sub_ps(dy, _mm_loadu_ps(&pairs.AHalfHeight[i])), zero);
+            const __m128 radius = _mm_loadu_ps(&pairs.BHalfWidth[i]);
+            const __m128 distance = _mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy));
+            StoreSse2(_mm_cmplt_ps(distance, _mm_mul_ps(radius, radius)), &touching[i]);
+        }
+        Finish<RectangleCircleAt>(pairs, i, touching);
+    }
+
+    constexpr Kernels Sse2Kernels {
+        .Level = simd::Level::Sse2,
+        .Rectangles = RectanglesSse2,
+        .Circles = CirclesSse2,
+        .RectangleCircle = RectangleCircleSse2,
+    };
+
+    // AVX2: eight pairs per register.
+
+    ENG_TARGET_AVX2 inline void StoreAvx2(const __m256 mask, uint8_t* touching)
+    {
+        const int bits = _mm256_movemask_ps(mask);
+        for (int lane = 0; lane < 8; lane++)
+            touching[lane] = static_cast<uint8_t>((bits >> lane) & 1);
+    }
+
+    ENG_TARGET_AVX2 inline __m256 DistanceAvx2(const float* a, const float* b)
+    {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_sub_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b)));
+    }
+
+    ENG_TARGET_AVX2 void RectanglesAvx2(const PairBatch& pairs, uint8_t* touching)
+    {
+        size_t i = 0;
+        for (; i + 8 <= pairs.GetSize(); i += 8) {
+            const __m256 dx = DistanceAvx2(&pairs.AX[i], &pairs.BX[i]);
+            const __m256 dy = DistanceAvx2(&pairs.AY[i], &pairs.BY[i]);
+            const __m256 width = _mm256_add_ps(_mm256_loadu_ps(&pairs.AHalfWidth[i]), _mm256_loadu_ps(&pairs.BHalfWidth[i]));
+            const __m256 height = _mm256_add_ps(_mm256_loadu_ps(&pairs.AHalfHeight[i]), _mm256_loadu_ps(&pairs.BHalfHeight[i]));
+            StoreAvx2(_mm256_and_ps(_mm256_cmp_ps(dx, width, _CMP_LT_OQ), _mm256_cmp_ps(dy, height, _CMP_LT_OQ)), &touching[i]);
+        }
+        Finish<RectanglesAt>(pairs, i, touching);
+    }
+
+    ENG_TARGET_AVX2 void CirclesAvx2(const PairBatch& pairs, uint8_t* touching)
+    {
+        size_t i = 0;
+        for (; i + 8 <= pairs.GetSize(); i += 8) {
+            const __m256 dx = DistanceAvx2(&pairs.AX[i], &pairs.BX[i]);
+            const __m256 dy = DistanceAvx2(&pairs.AY[i], &pairs.BY[i]);
+            const __m256 radius = _mm256_add_ps(_mm256_loadu_ps(&pairs.AHalfWidth[i]), _mm256_loadu_ps(&pairs.BHalfWidth[i]));
+            const __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            StoreAvx2(_mm256_cmp_ps(distance, _mm256_mul_ps(radius, radius), _CMP_LT_OQ), &touching[i]);
+        }
+        Finish<CirclesAt>(pairs, i, touching);
+    }
+
+    ENG_TARGET_AVX2 void RectangleCircleAvx2(const PairBatch& pairs, uint8_t* touching)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= pairs.GetSize(); i += 8) {
+            const __m256 dx = DistanceAvx2(&pairs.AX[i], &pairs.BX[i]);
+            const __m256 dy = DistanceAvx2(&pairs.AY[i], &pairs.BY[i]);
+            const __m256 qx = _mm256_max_ps(_mm256_sub_ps(dx, _mm256_loadu_ps(&pairs.AHalfWidth[i])), zero);
+            const __m256 qy = _mm256_max_ps(_mm256_sub_ps(dy, _mm256_loadu_ps(&pairs.AHalfHeight[i])), zero);
+            const __m256 radius = _mm256_loadu_ps(&pairs.BHalfWidth[i]);
+            const __m256 distance = _mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy));
+            StoreAvx2(_mm256_cmp_ps(distance, _mm256_mul_ps(radius, radius), _CMP_LT_OQ), &touching[i]);
+        }
+        Finish<RectangleCircleAt>(pairs, i, touching);
+    }
+
+    constexpr Kernels Avx2Kernels {
+        .Level = simd::Level::Avx2,
+        .Rectangles = RectanglesAvx2,
+        .Circles = CirclesAvx2,
+        .RectangleCircle = RectangleCircleAvx2,
+    };
+
+#endif
+
+} // namespace
+
+const Kernels& GetKernels(const simd::Level level)
+{
+#ifdef ENG_SIMD_X86
+    switch (level) {
+    case simd::Level::Avx2:
+        return Avx2Kernels;
+    case simd::Level::Sse2:
+        return Sse2Kernels;
+    case simd::Level::Scalar:
+        break;
+    }
+#else
+    (void)level;
+#endif
+    return ScalarKernels;
+}
+
+} // namespace narrow
+} // namespace engine
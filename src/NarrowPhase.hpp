@@ -0,0 +1,58 @@
+#ifndef ENG_NARROW_PHASE_HPP
+#define ENG_NARROW_PHASE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Simd.hpp"
+
+namespace engine {
+namespace narrow {
+
+    // A rectangle by its centre and half its size, or a circle by its centre
+    // and its radius, given as both halves.
+    struct Shape {
+        float X;
+        float Y;
+        float HalfWidth;
+        float HalfHeight;
+    };
+
+    // Pairs of shapes to test, every field in its own array so the kernels
+    // load a lane per pair.
+    struct PairBatch {
+        std::vector<float> AX;
+        std::vector<float> AY;
+        std::vector<float> AHalfWidth;
+        std::vector<float> AHalfHeight;
+        std::vector<float> BX;
+        std::vector<float> BY;
+        std::vector<float> BHalfWidth;
+        std::vector<float> BHalfHeight;
+
+        void Clear();
+        void Push(const Shape& a, const Shape& b);
+        inline size_t GetSize() const { return AX.size(); }
+    };
+
+    // Sets `touching[i]` to 1 if the shapes of pair `i` overlap, 0 if they
+    // don't or only share an edge. Every level produces the same bits as
+    // the scalar kernels.
+    using PairTest = void (*)(const PairBatch& pairs, uint8_t* touching);
+
+    struct Kernels {
+        simd::Level Level;
+        PairTest Rectangles;
+        PairTest Circles;
+        // A rectangles, B circles.
+        PairTest RectangleCircle;
+    };
+
+    // The kernels for `level`, or the best below it this build has.
+    const Kernels& GetKernels(const simd::Level level);
+
+} // namespace narrow
+} // namespace engine
+
+#endif // !ENG_NARROW_PHASE_HPP
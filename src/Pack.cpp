@@ -0,0 +1,374 @@
+#include "Pack.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/logger.h>
+
+#include "BinaryBuffer.hpp"
+#include "Result.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+namespace pack {
+
+    std::string NormalizeName(const std::string_view path)
+    {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    Result<> Write(const std::filesystem::path& folder, const std::filesystem::path& output, const std::shared_ptr<spdlog::logger> logger)
+    {
+        ENG_TRACE_ZONE("pack::Write");
+
+        struct PendingEntry {
+            std::string Name;
+            std::filesystem::path Path;
+            TocEntry Toc;
+        };
+
+        std::error_code errCode;
+        if (!std::filesystem::is_directory(folder, errCode)) {
+            logger->error("{} isn't a folder", folder.string());
+            return Error(Error::InvalidGame, "The game to pack isn't a folder");
+        }
+        if (!std::filesystem::exists(folder / "game.toml") || !std::filesystem::exists(folder / "resources.xml")) {
+            logger->error("{} is missing the metadata file or the resource table", folder.string());
+            return Error(Error::InvalidGame, "Missing metadata file or resource table");
+        }
+
+        std::vector<PendingEntry> entries;
+        // Iterated by hand, as the range-for increment throws on errors.
+        const std::filesystem::recursive_directory_iterator end;
+        for (auto file = std::filesystem::recursive_directory_iterator(folder, errCode); !errCode && file != end; file.increment(errCode)) {
+            // Packs lying around in the folder, including the one being
+            // written, aren't part of the game.
+            const bool regular = file->is_regular_file(errCode);
+            if (errCode)
+                break;
+            if (!regular || file->path().extension() == Extension)
+                continue;
+
+            const auto relative = std::filesystem::relative(file->path(), folder, errCode);
+            if (errCode)
+                break;
+            const uintmax_t size = file->file_size(errCode);
+            if (errCode) {
+                logger->error("Couldn't get the size of {}: {}", file->path().string(), errCode.message());
+                return Error(Error::Io, "Couldn't read a game file");
+            }
+
+            auto name = NormalizeName(relative.generic_string());
+            entries.push_back(PendingEntry {
+                .Name = name,
+                .Path = file->path(),
+                .Toc = TocEntry {
+                    .Hash = HashName(name),
+                    .Offset = 0,
+                    .Size = size,
+                    .NameOffset = 0,
+                    .NameSize = static_cast<uint32_t>(name.size()),
+                },
+            });
+        }
+        if (errCode) {
+            logger->error("Couldn't list {}: {}", folder.string(), errCode.message());
+            return Error(Error::Io, "Couldn't list the game folder");
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const PendingEntry& a, const PendingEntry& b) {
+            return a.Toc.Hash != b.Toc.Hash ? a.Toc.Hash < b.Toc.Hash : a.Name < b.Name;
+        });
+
+        const auto align = [](const uint64_t offset) {
+            return (offset + BlobAlignment - 1) / BlobAlignment * BlobAlignment;
+        };
+
+        std::string names;
+        for (auto& entry : entries) {
+            entry.Toc.NameOffset = static_cast<uint32_t>(names.size());
+            names += entry.Name;
+        }
+
+        const uint64_t namesOffset = sizeof(Header) + entries.size() * sizeof(TocEntry);
+        uint64_t offset = align(namesOffset + names.size());
+        for (auto& entry : entries) {
+            entry.Toc.Offset = offset;
+            offset = align(offset + entry.Toc.Size);
+        }
+
+        Header header {};
+        std::memcpy(header.Magic, Magic, sizeof(Magic));
+        header.Version = Version;
+        header.EntryCount = static_cast<uint32_t>(entries.size());
+        header.NamesOffset = namesOffset;
+        header.NamesSize = names.size();
+
+        std::ofstream file(output, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            logger->error("Couldn't create {}", output.string());
+            return Error(Error::Io, "Couldn't create the pack file");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& entry : entries)
+            file.write(reinterpret_cast<const char*>(&entry.Toc), sizeof(entry.Toc));
+        file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        const auto padTo = [&file](const uint64_t target) {
+            static constexpr char zeros[BlobAlignment] = {};
+            const auto position = static_cast<uint64_t>(file.tellp());
+            if (target > position)
+                file.write(zeros, static_cast<std::streamsize>(target - position));
+        };
+
+        for (const auto& entry : entries) {
+            padTo(entry.Toc.Offset);
+
+            auto data = BinaryBuffer::FromFile(entry.Path);
+            if (data.IsErr()) {
+                logger->error("Couldn't read {}: {}", entry.Path.string(), data.UnwrapErr().ToString());
+                return data.UnwrapErr();
+            }
+            const auto& bytes = data.Unwrap().GetBytes();
+            if (bytes.size() != entry.Toc.Size) {
+                logger->error("{} changed while packing", entry.Path.string());
+                return Error(Error::Io, "A file changed while packing");
+            }
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+        padTo(offset);
+
+        if (!file.flush()) {
+            logger->error("Couldn't write {}", output.string());
+            return Error(Error::Io, "Couldn't write the pack file");
+        }
+
+        logger->info("Packed {} files ({} bytes) into {}", entries.size(), offset, output.string());
+
+        return Result();
+    }
+
+} // namespace pack
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_Data(std::exchange(other.m_Data, nullptr))
+    , m_Size(std::exchange(other.m_Size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        Close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+    }
+    return *this;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+Result<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return Error(Error::Io, "Couldn't open the file");
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return Error(Error::Io, "Couldn't map an empty file");
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return Error(Error::Io, "Couldn't map the file");
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data)
+        return Error(Error::Io, "Couldn't map the file");
+
+    MappedFile mapped;
+    mapped.m_Data = static_cast<const std::byte*>(data);
+    mapped.m_Size = static_cast<size_t>(size.QuadPart);
+    return Result(std::move(mapped));
+}
+
+void MappedFile::Prefetch(const std::span<const std::byte> range) const
+{
+    WIN32_MEMORY_RANGE_ENTRY entry { const_cast<std::byte*>(range.data()), range.size() };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+#else
+
+Result<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return Error(Error::Io, "Couldn't open the file");
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return Error(Error::Io, "Couldn't map an empty file");
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced.
+    close(fd);
+    if (data == MAP_FAILED)
+        return Error(Error::Io, "Couldn't map the file");
+
+    MappedFile mapped;
+    mapped.m_Data = static_cast<const std::byte*>(data);
+    mapped.m_Size = static_cast<size_t>(info.st_size);
+    return Result(std::move(mapped));
+}
+
+void MappedFile::Prefetch(const std::span<const std::byte> range) const
+{
+    if (range.empty())
+        return;
+
+    // madvise wants a page aligned start.
+    const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<uintptr_t>(range.data()) & ~(pageSize - 1);
+    const auto end = reinterpret_cast<uintptr_t>(range.data()) + range.size();
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+        munmap(const_cast<std::byte*>(m_Data), m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+#endif
+
+Pack::Pack(const std::shared_ptr<spdlog::logger> logger, MappedFile&& file)
+    : m_Logger(logger)
+    , m_File(std::move(file))
+    , m_Toc()
+    , m_Names()
+{
+}
+
+Result<std::shared_ptr<Pack>> Pack::Open(const std::shared_ptr<spdlog::logger> logger, const std::filesystem::path& path)
+{
+    ENG_TRACE_ZONE("Pack::Open");
+
+    auto file = MappedFile::Open(path);
+    if (file.IsErr()) {
+        logger->error("Couldn't map the pack {}: {}", path.string(), file.UnwrapErr().ToString());
+        return file.UnwrapErr();
+    }
+
+    auto self = std::make_shared<Pack>(logger, file.UnwrapMove());
+    if (auto res = self->Validate(); !res) {
+        logger->error("{} isn't a valid pack: {}", path.string(), res.UnwrapErr().ToString());
+        return res.UnwrapErr();
+    }
+
+    logger->debug("Opened pack {} with {} entries", path.string(), self->GetEntryCount());
+
+    return Result(self);
+}
+
+std::optional<std::span<const std::byte>> Pack::Find(const std::string_view name) const
+{
+    const auto normalized = pack::NormalizeName(name);
+    const auto hash = pack::HashName(normalized);
+
+    auto it = std::lower_bound(m_Toc.begin(), m_Toc.end(), hash, [](const pack::TocEntry& entry, const uint64_t hash) {
+        return entry.Hash < hash;
+    });
+    for (; it != m_Toc.end() && it->Hash == hash; ++it) {
+        if (m_Names.substr(it->NameOffset, it->NameSize) == normalized)
+            return m_File.GetBytes().subspan(it->Offset, it->Size);
+    }
+
+    return std::nullopt;
+}
+
+Result<> Pack::Validate()
+{
+    const auto bytes = m_File.GetBytes();
+
+    if (bytes.size() < sizeof(pack::Header))
+        return Error(Error::InvalidFormat, "The pack is too small");
+
+    pack::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    if (std::memcmp(header.Magic, pack::Magic, sizeof(pack::Magic)) != 0)
+        return Error(Error::InvalidFormat, "Bad pack magic");
+    if (header.Version != pack::Version)
+        return Error(Error::InvalidFormat, "Unsupported pack version");
+
+    const uint64_t tocSize = static_cast<uint64_t>(header.EntryCount) * sizeof(pack::TocEntry);
+    if (header.NamesOffset != sizeof(pack::Header) + tocSize
+        || header.NamesSize > bytes.size()
+        || header.NamesOffset > bytes.size() - header.NamesSize)
+        return Error(Error::InvalidFormat, "The table of contents is out of bounds");
+
+    // The mapping is page aligned, so the table right after the header is
+    // suitably aligned for `TocEntry`.
+    m_Toc = std::span(reinterpret_cast<const pack::TocEntry*>(bytes.data() + sizeof(pack::Header)), header.EntryCount);
+    m_Names = std::string_view(reinterpret_cast<const char*>(bytes.data() + header.NamesOffset), header.NamesSize);
+
+    for (size_t i = 0; i < m_Toc.size(); i++) {
+        const auto& entry = m_Toc[i];
+        if (entry.Size > bytes.size() || entry.Offset > bytes.size() - entry.Size)
+            return Error(Error::InvalidFormat, "An entry is out of bounds");
+        if (entry.NameSize > m_Names.size() || entry.NameOffset > m_Names.size() - entry.NameSize)
+            return Error(Error::InvalidFormat, "An entry name is out of bounds");
+        if (i > 0 && m_Toc[i - 1].Hash > entry.Hash)
+            return Error(Error::InvalidFormat, "The table of contents isn't sorted");
+    }
+
+    return Result();
+}
+
+} // namespace engine
@@ -0,0 +1,128 @@
+#ifndef ENG_PACK_HPP
+#define ENG_PACK_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <spdlog/logger.h>
+
+#include "Result.hpp"
+#include "Util.hpp"
+
+namespace engine {
+
+namespace pack {
+
+    // Layout of a pack file, integers are stored in native (little endian)
+    // byte order:
+    //
+    //   Header
+    //   TocEntry[Header::EntryCount], sorted by hash and then by name
+    //   Names, not null-terminated
+    //   Blobs, each aligned to `BlobAlignment`
+    //
+    // Entry names are the asset paths relative to the game folder, with
+    // forward slashes, e.g. `game.toml` or `sprites/duck.png`.
+    static_assert(std::endian::native == std::endian::little, "Packs are only supported on little endian hosts");
+
+    constexpr char Magic[4] = { 'D', 'P', 'A', 'K' };
+    constexpr uint32_t Version = 1;
+    constexpr size_t BlobAlignment = 64;
+    constexpr std::string_view Extension = ".dpak";
+
+    struct Header {
+        char Magic[4];
+        uint32_t Version;
+        uint32_t EntryCount;
+        uint32_t Reserved;
+        uint64_t NamesOffset;
+        uint64_t NamesSize;
+    };
+    static_assert(sizeof(Header) == 32);
+
+    struct TocEntry {
+        uint64_t Hash;
+        uint64_t Offset;
+        uint64_t Size;
+        uint32_t NameOffset;
+        uint32_t NameSize;
+    };
+    static_assert(sizeof(TocEntry) == 32);
+
+    constexpr uint64_t HashName(const std::string_view name)
+    {
+        return util::Fnv1a(name);
+    }
+
+    // Turns a relative asset path into an entry name.
+    std::string NormalizeName(const std::string_view path);
+
+    // Packs every file under `folder` into a pack at `output`.
+    Result<> Write(const std::filesystem::path& folder, const std::filesystem::path& output, const std::shared_ptr<spdlog::logger> logger);
+
+} // namespace pack
+
+// A read-only memory mapping of a whole file.
+class MappedFile final {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    static Result<MappedFile> Open(const std::filesystem::path& path);
+
+    inline std::span<const std::byte> GetBytes() const { return { m_Data, m_Size }; }
+
+    // Hints the OS to start paging `range` in.
+    void Prefetch(const std::span<const std::byte> range) const;
+
+private:
+    const std::byte* m_Data = nullptr;
+    size_t m_Size = 0;
+
+    void Close();
+};
+
+// A game packed into a single memory mapped file. Assets are handed out as
+// views into the mapping, so they aren't copied and only get paged in once
+// touched. Lookups are thread safe.
+class Pack final {
+public:
+    Pack(const std::shared_ptr<spdlog::logger> logger, MappedFile&& file);
+    ~Pack() = default;
+
+    Pack(const Pack&) = delete;
+    Pack& operator=(const Pack&) = delete;
+
+    static Result<std::shared_ptr<Pack>> Open(const std::shared_ptr<spdlog::logger> logger, const std::filesystem::path& path);
+
+    // The view stays valid as long as the pack does.
+    std::optional<std::span<const std::byte>> Find(const std::string_view name) const;
+
+    inline void Prefetch(const std::span<const std::byte> range) const { m_File.Prefetch(range); }
+
+    inline size_t GetEntryCount() const { return m_Toc.size(); }
+
+private:
+    const std::shared_ptr<spdlog::logger> m_Logger;
+    MappedFile m_File;
+    std::span<const pack::TocEntry> m_Toc;
+    std::string_view m_Names;
+
+    Result<> Validate();
+};
+
+} // namespace engine
+
+#endif // !ENG_PACK_HPP
@@ -0,0 +1,202 @@
+// eng-pack: turns a game folder into a pack and compares start-up I/O of the
+// two formats.
+//
+//   eng-pack <game folder> <output.dpak>
+//   eng-pack --bench <game folder> <pack.dpak> [iterations]
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include "BinaryBuffer.hpp"
+#include "Clock.hpp"
+#include "Pack.hpp"
+#include "Result.hpp"
+
+namespace {
+
+using namespace engine;
+
+// Drops the file's pages from the page cache so the next read hits the disk.
+// Only possible on Linux; elsewhere every run is warm.
+bool Evict(const std::filesystem::path& path)
+{
+#if defined(__linux__)
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    fdatasync(fd);
+    const bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return evicted;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// Sums every byte so the whole asset has to be paged in.
+uint64_t Touch(const std::span<const std::byte> bytes)
+{
+    uint64_t sum = 0;
+    for (const auto byte : bytes)
+        sum += static_cast<uint8_t>(byte);
+    return sum;
+}
+
+// What a FOLDER start does: check and read every file separately.
+Result<uint64_t> StartFolder(const std::vector<std::filesystem::path>& files)
+{
+    uint64_t sum = 0;
+    for (const auto& file : files) {
+        if (!std::filesystem::exists(file))
+            return Error(Error::Io, "A file disappeared");
+        auto data = BinaryBuffer::FromFile(file);
+        if (data.IsErr())
+            return data.UnwrapErr();
+        sum += Touch(data.Unwrap().GetBytes());
+    }
+    return Result(sum);
+}
+
+// What a PACK start does: map the pack once and look everything up in it.
+Result<uint64_t> StartPack(const std::shared_ptr<spdlog::logger> logger, const std::filesystem::path& packPath, const std::vector<std::string>& names)
+{
+    auto pack = Pack::Open(logger, packPath);
+    if (pack.IsErr())
+        return pack.UnwrapErr();
+
+    uint64_t sum = 0;
+    for (const auto& name : names) {
+        const auto data = pack.Unwrap()->Find(name);
+        if (!data)
+            return Error(Error::InvalidGame, "The pack is missing a file");
+        sum += Touch(*data);
+    }
+    return Result(sum);
+}
+
+struct Timings {
+    std::vector<double> Cold;
+    std::vector<double> Warm;
+};
+
+void Report(const std::shared_ptr<spdlog::logger> logger, const std::string_view format, std::vector<double>& samples, const std::string_view kind)
+{
+    if (samples.empty())
+        return;
+
+    std::sort(samples.begin(), samples.end());
+    logger->info(
+        "{:6} {}: min {:.3f} ms, median {:.3f} ms, max {:.3f} ms over {} runs",
+        format, kind, samples.front(), samples[samples.size() / 2], samples.back(), samples.size()
+    );
+}
+
+int Bench(const std::shared_ptr<spdlog::logger> logger, const std::filesystem::path& folder, const std::filesystem::path& packPath, const unsigned int iterations)
+{
+    std::vector<std::filesystem::path> files;
+    std::vector<std::string> names;
+    for (const auto& file : std::filesystem::recursive_directory_iterator(folder)) {
+        if (!file.is_regular_file() || file.path().extension() == pack::Extension)
+            continue;
+        files.push_back(file.path());
+        names.push_back(pack::NormalizeName(std::filesystem::relative(file.path(), folder).generic_string()));
+    }
+
+    logger->info("Benchmarking {} files, {} iterations", files.size(), iterations);
+
+    const auto measure = [&logger](const std::function<Result<uint64_t>()>& start, std::vector<double>& samples) {
+        const auto begin = Clock::now();
+        auto res = start();
+        const auto end = Clock::now();
+        if (res.IsErr()) {
+            logger->error("Start failed: {}", res.UnwrapErr().ToString());
+            return false;
+        }
+        samples.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+        return true;
+    };
+
+    Timings folderTimings;
+    Timings packTimings;
+    const auto startFolder = [&files] { return StartFolder(files); };
+    const auto startPack = [&logger, &packPath, &names] { return StartPack(logger, packPath, names); };
+
+    for (unsigned int i = 0; i < iterations; i++) {
+        bool evicted = true;
+        for (const auto& file : files)
+            evicted = Evict(file) && evicted;
+        if (evicted && !measure(startFolder, folderTimings.Cold))
+            return 1;
+        if (!measure(startFolder, folderTimings.Warm))
+            return 1;
+
+        if (Evict(packPath) && !measure(startPack, packTimings.Cold))
+            return 1;
+        if (!measure(startPack, packTimings.Warm))
+            return 1;
+    }
+
+    if (folderTimings.Cold.empty())
+        logger->warn("Couldn't drop the page cache, only warm starts were measured");
+
+    Report(logger, "FOLDER", folderTimings.Cold, "cold");
+    Report(logger, "FOLDER", folderTimings.Warm, "warm");
+    Report(logger, "PACK", packTimings.Cold, "cold");
+    Report(logger, "PACK", packTimings.Warm, "warm");
+
+    return 0;
+}
+
+} // namespace
+
+int main(const int argc, const char** argv)
+{
+    auto logger = spdlog::stdout_color_mt("console");
+    logger->set_pattern("\033[90m%Y-%m-%d %H:%M:%S t%t %^[%l]%$ %v");
+
+    const std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    if (args.size() >= 3 && args[0] == "--bench") {
+        unsigned int iterations = 5;
+        if (args.size() >= 4) {
+            auto [_, ec] = std::from_chars(args[3].data(), args[3].data() + args[3].size(), iterations);
+            if (ec != std::errc() || iterations == 0) {
+                logger->error("Invalid iteration count: {}", args[3]);
+                return 1;
+            }
+        }
+        return Bench(logger, args[1], args[2], iterations);
+    }
+
+    if (args.size() == 2) {
+        if (auto res = pack::Write(args[0], args[1], logger); !res) {
+            logger->error("Packing failed: {}", res.UnwrapErr().ToString());
+            return 1;
+        }
+        return 0;
+    }
+
+    logger->error("Usage: eng-pack <game folder> <output{}> | eng-pack --bench <game folder> <pack{}> [iterations]", pack::Extension, pack::Extension);
+    return 1;
+}
@@ -0,0 +1,373 @@
+#include "RasterKernels.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Simd.hpp"
+
+#ifdef ENG_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace engine {
+namespace raster {
+
+namespace {
+
+    constexpr uint32_t OpaqueMask = 0xff000000u;
+
+    // Rounded division by 255 of a product of two bytes, exact over
+    // [0, 255 * 255]. The vector kernels use the same formula.
+    inline uint32_t Div255(const uint32_t value)
+    {
+        const uint32_t t = value + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    inline uint32_t Channel(const uint32_t pixel, const int shift)
+    {
+        return (pixel >> shift) & 0xff;
+    }
+
+    inline uint32_t Tint(const uint32_t pixel, const uint32_t tint)
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+            result |= Div255(Channel(pixel, shift) * Channel(tint, shift)) << shift;
+        return result;
+    }
+
+    void BlendScalar(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t s = Tint(source[i], tint);
+            const uint32_t d = destination[i];
+            const uint32_t alpha = s >> 24;
+            uint32_t result = OpaqueMask;
+            for (int shift = 0; shift < 24; shift += 8)
+                result |= Div255(Channel(s, shift) * alpha + Channel(d, shift) * (255 - alpha)) << shift;
+            destination[i] = result;
+        }
+    }
+
+    void AddScalar(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t s = Tint(source[i], tint);
+            const uint32_t d = destination[i];
+            const uint32_t alpha = s >> 24;
+            uint32_t result = OpaqueMask;
+            for (int shift = 0; shift < 24; shift += 8)
+                result |= std::min<uint32_t>(Channel(d, shift) + Div255(Channel(s, shift) * alpha), 255) << shift;
+            destination[i] = result;
+        }
+    }
+
+    void ModulateScalar(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t s = Tint(source[i], tint);
+            const uint32_t d = destination[i];
+            uint32_t result = OpaqueMask;
+            for (int shift = 0; shift < 24; shift += 8)
+                result |= Div255(Channel(s, shift) * Channel(d, shift)) << shift;
+            destination[i] = result;
+        }
+    }
+
+    void CopyScalar(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        for (size_t i = 0; i < count; i++)
+            destination[i] = Tint(source[i], tint) | OpaqueMask;
+    }
+
+    void FillScalar(uint32_t* destination, const size_t count, const uint32_t color)
+    {
+        std::fill(destination, destination + count, color | OpaqueMask);
+    }
+
+    constexpr Kernels ScalarKernels {
+        .Level = simd::Level::Scalar,
+        .Blend = BlendScalar,
+        .Add = AddScalar,
+        .Modulate = ModulateScalar,
+        .Copy = CopyScalar,
+        .Fill = FillScalar,
+    };
+
+#ifdef ENG_SIMD_X86
+
+    // SSE2: two pixels per register once widened to 16-bit channels.
+
+    inline __m128i Div255Sse2(const __m128i value)
+    {
+        const __m128i t = _mm_add_epi16(value, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    inline __m128i AlphaSse2(const __m128i wide)
+    {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(wide, 0xff), 0xff);
+    }
+
+    // Widens four pixels into two registers and tints them.
+    inline void LoadTintedSse2(const uint32_t* source, const __m128i tint, __m128i& low, __m128i& high)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        low = Div255Sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), tint));
+        high = Div255Sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), tint));
+    }
+
+    inline __m128i WideTintSse2(const uint32_t tint)
+    {
+        return _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(tint)), _mm_setzero_si128());
+    }
+
+    void BlendSse2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wideTint = WideTintSse2(tint);
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i opaque = _mm_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i sLow, sHigh;
+            LoadTintedSse2(source + i, wideTint, sLow, sHigh);
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i));
+            const __m128i aLow = AlphaSse2(sLow);
+            const __m128i aHigh = AlphaSse2(sHigh);
+            const __m128i low = Div255Sse2(_mm_add_epi16(
+                _mm_mullo_epi16(sLow, aLow),
+                _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, aLow))
+            ));
+            const __m128i high = Div255Sse2(_mm_add_epi16(
+                _mm_mullo_epi16(sHigh, aHigh),
+                _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, aHigh))
+            ));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+        }
+        BlendScalar(destination + i, source + i, count - i, tint);
+    }
+
+    void AddSse2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m128i wideTint = WideTintSse2(tint);
+        const __m128i opaque = _mm_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i sLow, sHigh;
+            LoadTintedSse2(source + i, wideTint, sLow, sHigh);
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i));
+            const __m128i low = Div255Sse2(_mm_mullo_epi16(sLow, AlphaSse2(sLow)));
+            const __m128i high = Div255Sse2(_mm_mullo_epi16(sHigh, AlphaSse2(sHigh)));
+            const __m128i sum = _mm_adds_epu8(d, _mm_packus_epi16(low, high));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_or_si128(sum, opaque));
+        }
+        AddScalar(destination + i, source + i, count - i, tint);
+    }
+
+    void ModulateSse2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wideTint = WideTintSse2(tint);
+        const __m128i opaque = _mm_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i sLow, sHigh;
+            LoadTintedSse2(source + i, wideTint, sLow, sHigh);
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i));
+            const __m128i low = Div255Sse2(_mm_mullo_epi16(sLow, _mm_unpacklo_epi8(d, zero)));
+            const __m128i high = Div255Sse2(_mm_mullo_epi16(sHigh, _mm_unpackhi_epi8(d, zero)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+        }
+        ModulateScalar(destination + i, source + i, count - i, tint);
+    }
+
+    void CopySse2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m128i opaque = _mm_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        if (tint == 0xffffffffu) {
+            for (; i + 4 <= count; i += 4) {
+                const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_or_si128(s, opaque));
+            }
+        } else {
+            const __m128i wideTint = WideTintSse2(tint);
+            for (; i + 4 <= count; i += 4) {
+                __m128i sLow, sHigh;
+                LoadTintedSse2(source + i, wideTint, sLow, sHigh);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_or_si128(_mm_packus_epi16(sLow, sHigh), opaque));
+            }
+        }
+        CopyScalar(destination + i, source + i, count - i, tint);
+    }
+
+    void FillSse2(uint32_t* destination, const size_t count, const uint32_t color)
+    {
+        const __m128i value = _mm_set1_epi32(static_cast<int>(color | OpaqueMask));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), value);
+        FillScalar(destination + i, count - i, color);
+    }
+
+    constexpr Kernels Sse2Kernels {
+        .Level = simd::Level::Sse2,
+        .Blend = BlendSse2,
+        .Add = AddSse2,
+        .Modulate = ModulateSse2,
+        .Copy = CopySse2,
+        .Fill = FillSse2,
+    };
+
+    // AVX2: the same, eight pixels at a time. Unpacking and packing work
+    // within 128-bit lanes, so pixels keep their order.
+
+    ENG_TARGET_AVX2 inline __m256i Div255Avx2(const __m256i value)
+    {
+        const __m256i t = _mm256_add_epi16(value, _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    }
+
+    ENG_TARGET_AVX2 inline __m256i AlphaAvx2(const __m256i wide)
+    {
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(wide, 0xff), 0xff);
+    }
+
+    ENG_TARGET_AVX2 inline void LoadTintedAvx2(const uint32_t* source, const __m256i tint, __m256i& low, __m256i& high)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+        low = Div255Avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), tint));
+        high = Div255Avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), tint));
+    }
+
+    ENG_TARGET_AVX2 inline __m256i WideTintAvx2(const uint32_t tint)
+    {
+        return _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(tint)), _mm256_setzero_si256());
+    }
+
+    ENG_TARGET_AVX2 void BlendAvx2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i wideTint = WideTintAvx2(tint);
+        const __m256i full = _mm256_set1_epi16(255);
+        const __m256i opaque = _mm256_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i sLow, sHigh;
+            LoadTintedAvx2(source + i, wideTint, sLow, sHigh);
+            const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + i));
+            const __m256i aLow = AlphaAvx2(sLow);
+            const __m256i aHigh = AlphaAvx2(sHigh);
+            const __m256i low = Div255Avx2(_mm256_add_epi16(
+                _mm256_mullo_epi16(sLow, aLow),
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, aLow))
+            ));
+            const __m256i high = Div255Avx2(_mm256_add_epi16(
+                _mm256_mullo_epi16(sHigh, aHigh),
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, aHigh))
+            ));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_or_si256(_mm256_packus_epi16(low, high), opaque));
+        }
+        BlendSse2(destination + i, source + i, count - i, tint);
+    }
+
+    ENG_TARGET_AVX2 void AddAvx2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m256i wideTint = WideTintAvx2(tint);
+        const __m256i opaque = _mm256_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i sLow, sHigh;
+            LoadTintedAvx2(source + i, wideTint, sLow, sHigh);
+            const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + i));
+            const __m256i low = Div255Avx2(_mm256_mullo_epi16(sLow, AlphaAvx2(sLow)));
+            const __m256i high = Div255Avx2(_mm256_mullo_epi16(sHigh, AlphaAvx2(sHigh)));
+            const __m256i sum = _mm256_adds_epu8(d, _mm256_packus_epi16(low, high));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_or_si256(sum, opaque));
+        }
+        AddSse2(destination + i, source + i, count - i, tint);
+    }
+
+    ENG_TARGET_AVX2 void ModulateAvx2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i wideTint = WideTintAvx2(tint);
+        const __m256i opaque = _mm256_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i sLow, sHigh;
+            LoadTintedAvx2(source + i, wideTint, sLow, sHigh);
+            const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + i));
+            const __m256i low = Div255Avx2(_mm256_mullo_epi16(sLow, _mm256_unpacklo_epi8(d, zero)));
+            const __m256i high = Div255Avx2(_mm256_mullo_epi16(sHigh, _mm256_unpackhi_epi8(d, zero)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_or_si256(_mm256_packus_epi16(low, high), opaque));
+        }
+        ModulateSse2(destination + i, source + i, count - i, tint);
+    }
+
+    ENG_TARGET_AVX2 void CopyAvx2(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint)
+    {
+        const __m256i opaque = _mm256_set1_epi32(static_cast<int>(OpaqueMask));
+        size_t i = 0;
+        if (tint == 0xffffffffu) {
+            for (; i + 8 <= count; i += 8) {
+                const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_or_si256(s, opaque));
+            }
+        } else {
+            const __m256i wideTint = WideTintAvx2(tint);
+            for (; i + 8 <= count; i += 8) {
+                __m256i sLow, sHigh;
+                LoadTintedAvx2(source + i, wideTint, sLow, sHigh);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_or_si256(_mm256_packus_epi16(sLow, sHigh), opaque));
+            }
+        }
+        CopySse2(destination + i, source + i, count - i, tint);
+    }
+
+    ENG_TARGET_AVX2 void FillAvx2(uint32_t* destination, const size_t count, const uint32_t color)
+    {
+        const __m256i value = _mm256_set1_epi32(static_cast<int>(color | OpaqueMask));
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), value);
+        FillSse2(destination + i, count - i, color);
+    }
+
+    constexpr Kernels Avx2Kernels {
+        .Level = simd::Level::Avx2,
+        .Blend = BlendAvx2,
+        .Add = AddAvx2,
+        .Modulate = ModulateAvx2,
+        .Copy = CopyAvx2,
+        .Fill = FillAvx2,
+    };
+
+#endif
+
+} // namespace
+
+const Kernels& GetKernels(const simd::Level level)
+{
+#ifdef ENG_SIMD_X86
+    switch (level) {
+    case simd::Level::Avx2:
+        return Avx2Kernels;
+    case simd::Level::Sse2:
+        return Sse2Kernels;
+    case simd::Level::Scalar:
+        break;
+    }
+#else
+    (void)level;
+#endif
+    return ScalarKernels;
+}
+
+} // namespace raster
+} // namespace engine
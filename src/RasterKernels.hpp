@@ -0,0 +1,36 @@
+#ifndef ENG_RASTER_KERNELS_HPP
+#define ENG_RASTER_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Simd.hpp"
+
+namespace engine {
+namespace raster {
+
+    // Row kernels of the software rasterizer. Pixels are ARGB8888 words,
+    // sources in straight alpha and tinted by `tint` (ARGB, opaque white
+    // for none) first. The destination is opaque and stays so. Every level
+    // produces the same bits as the scalar kernels.
+    using BlendRow = void (*)(uint32_t* destination, const uint32_t* source, const size_t count, const uint32_t tint);
+
+    struct Kernels {
+        simd::Level Level;
+        // SDL's blend modes: `Blend` is source over, `Add` adds the source
+        // times its alpha, `Modulate` multiplies the colors and `Copy`
+        // replaces the destination.
+        BlendRow Blend;
+        BlendRow Add;
+        BlendRow Modulate;
+        BlendRow Copy;
+        void (*Fill)(uint32_t* destination, const size_t count, const uint32_t color);
+    };
+
+    // The kernels for `level`, or the best below it this build has.
+    const Kernels& GetKernels(const simd::Level level);
+
+} // namespace raster
+} // namespace engine
+
+#endif // !ENG_RASTER_KERNELS_HPP
@@ -0,0 +1,150 @@
+#include "RenderQueue.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <utility>
+
+#include <SDL2/SDL_blendmode.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+
+#include "Trace.hpp"
+
+namespace engine {
+
+SDL_BlendMode ToSdlBlendMode(const BlendMode mode)
+{
+    switch (mode) {
+    case BlendMode::Blend:
+        return SDL_BLENDMODE_BLEND;
+    case BlendMode::Add:
+        return SDL_BLENDMODE_ADD;
+    case BlendMode::Modulate:
+        return SDL_BLENDMODE_MOD;
+    case BlendMode::None:
+        return SDL_BLENDMODE_NONE;
+    }
+    return SDL_BLENDMODE_BLEND;
+}
+
+SDL_Rect GetBounds(const DrawCommand& command)
+{
+    const auto& dest = command.Destination;
+    float left = dest.x;
+    float top = dest.y;
+    float right = dest.x + dest.w;
+    float bottom = dest.y + dest.h;
+
+    if (command.Rotation != 0.0f) {
+        // Rotating around the center, the box grows by the rotated
+        // extents of the half size.
+        const float radians = command.Rotation * std::numbers::pi_v<float> / 180.0f;
+        const float cos = std::abs(std::cos(radians));
+        const float sin = std::abs(std::sin(radians));
+        const float halfWidth = (dest.w * cos + dest.h * sin) * 0.5f;
+        const float halfHeight = (dest.w * sin + dest.h * cos) * 0.5f;
+        const float centerX = dest.x + dest.w * 0.5f;
+        const float centerY = dest.y + dest.h * 0.5f;
+        left = centerX - halfWidth;
+        right = centerX + halfWidth;
+        top = centerY - halfHeight;
+        bottom = centerY + halfHeight;
+    }
+
+    // A pixel of margin for linear filtering bleeding past the edges.
+    const int x = static_cast<int>(std::floor(left)) - 1;
+    const int y = static_cast<int>(std::floor(top)) - 1;
+    return SDL_Rect {
+        x,
+        y,
+        static_cast<int>(std::ceil(right)) + 1 - x,
+        static_cast<int>(std::ceil(bottom)) + 1 - y,
+    };
+}
+
+RenderQueue::RenderQueue()
+    : m_Commands()
+    , m_Entries()
+    , m_Scratch()
+    , m_SortedInScratch(false)
+    , m_Histograms()
+{
+}
+
+void RenderQueue::Submit(
+    const uint8_t layer,
+    const uint32_t depth,
+    SDL_Texture* texture,
+    const SDL_Rect& source,
+    const SDL_FRect& destination,
+    const SDL_Color color,
+    const float rotation,
+    const BlendMode blend
+)
+{
+    m_Commands.push_back(DrawCommand {
+        .Key = renderKey::Make(layer, depth, texture, blend),
+        .Texture = texture,
+        .Source = source,
+        .Destination = destination,
+        .Color = color,
+        .Rotation = rotation,
+        .Blend = blend,
+    });
+}
+
+void RenderQueue::Append(const RenderQueue& other)
+{
+    m_Commands.insert(m_Commands.end(), other.m_Commands.begin(), other.m_Commands.end());
+}
+
+void RenderQueue::Clear()
+{
+    m_Commands.clear();
+}
+
+void RenderQueue::Sort()
+{
+    ENG_TRACE_ZONE("RenderQueue::Sort");
+
+    const size_t count = m_Commands.size();
+    m_Entries.resize(count);
+    m_Scratch.resize(count);
+
+    // All eight digit histograms in a single pass over the keys.
+    for (auto& histogram : m_Histograms)
+        histogram.fill(0);
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t key = m_Commands[i].Key;
+        m_Entries[i] = SortEntry { .Key = key, .Index = static_cast<uint32_t>(i) };
+        for (size_t digit = 0; digit < m_Histograms.size(); digit++)
+            m_Histograms[digit][(key >> (digit * 8)) & 0xff]++;
+    }
+
+    std::vector<SortEntry>* source = &m_Entries;
+    std::vector<SortEntry>* destination = &m_Scratch;
+    for (size_t digit = 0; digit < m_Histograms.size(); digit++) {
+        auto& histogram = m_Histograms[digit];
+        const size_t shift = digit * 8;
+
+        // A digit every key shares doesn't reorder anything. Usually true of
+        // most of the layer and depth bits.
+        if (count == 0 || histogram[((*source)[0].Key >> shift) & 0xff] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (auto& bucket : histogram)
+            offset += std::exchange(bucket, offset);
+
+        for (const auto& entry : *source)
+            (*destination)[histogram[(entry.Key >> shift) & 0xff]++] = entry;
+        std::swap(source, destination);
+    }
+
+    m_SortedInScratch = source == &m_Scratch;
+}
+
+} // namespace engine
@@ -0,0 +1,133 @@
+#ifndef ENG_RENDER_QUEUE_HPP
+#define ENG_RENDER_QUEUE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+
+namespace engine {
+
+enum class BlendMode : uint8_t {
+    Blend,
+    Add,
+    Modulate,
+    None,
+};
+
+SDL_BlendMode ToSdlBlendMode(const BlendMode mode);
+
+// Commands are executed in the order of their 64-bit key, which packs, from
+// the most significant bits:
+//
+//   layer (8) | depth (24) | texture (24) | blend mode (8)
+//
+// so layers are drawn bottom up, each back to front by depth, and commands
+// at the same depth are grouped by texture and blend mode to save state
+// changes.
+namespace renderKey {
+
+    constexpr int LayerShift = 56;
+    constexpr int DepthShift = 32;
+    constexpr int TextureShift = 8;
+
+    constexpr uint32_t MaxDepth = (1u << 24) - 1;
+    // Where entity sprites go, leaving layers below and above for the game.
+    constexpr uint8_t DefaultLayer = 128;
+
+    // 24 bits identifying the texture. Different textures may collide, which
+    // only costs a state change, never correctness.
+    inline uint32_t HashTexture(const SDL_Texture* texture)
+    {
+        return static_cast<uint32_t>((reinterpret_cast<uintptr_t>(texture) * 0x9e3779b97f4a7c15) >> 40);
+    }
+
+    // Clamps `depth` to what fits the key, e.g. a y coordinate for y-sorting.
+    constexpr uint32_t ClampDepth(const double depth)
+    {
+        if (depth <= 0.0)
+            return 0;
+        if (depth >= MaxDepth)
+            return MaxDepth;
+        return static_cast<uint32_t>(depth);
+    }
+
+    inline uint64_t Make(const uint8_t layer, const uint32_t depth, const SDL_Texture* texture, const BlendMode blend)
+    {
+        return static_cast<uint64_t>(layer) << LayerShift
+            | static_cast<uint64_t>(depth & MaxDepth) << DepthShift
+            | static_cast<uint64_t>(HashTexture(texture)) << TextureShift
+            | static_cast<uint64_t>(blend);
+    }
+
+} // namespace renderKey
+
+struct DrawCommand {
+    uint64_t Key;
+    SDL_Texture* Texture;
+    // Zero sized means the whole texture.
+    SDL_Rect Source;
+    SDL_FRect Destination;
+    SDL_Color Color;
+    // Degrees clockwise around the destination's center.
+    float Rotation;
+    BlendMode Blend;
+};
+
+// The pixels `command` may touch, rotation and filtering included.
+SDL_Rect GetBounds(const DrawCommand& command);
+
+// Draw commands collected during a frame, to be sorted by key and executed
+// by `RenderingEngine`. Keeps its buffers between frames, so once it has
+// seen its largest frame, submitting and sorting don't allocate.
+class RenderQueue final {
+public:
+    RenderQueue();
+    ~RenderQueue() = default;
+
+    void Submit(
+        const uint8_t layer,
+        const uint32_t depth,
+        SDL_Texture* texture,
+        const SDL_Rect& source,
+        const SDL_FRect& destination,
+        const SDL_Color color = SDL_Color { 255, 255, 255, 255 },
+        const float rotation = 0.0f,
+        const BlendMode blend = BlendMode::Blend
+    );
+    // Copies the commands of `other` after the ones already queued.
+    void Append(const RenderQueue& other);
+    void Clear();
+
+    // Sorts the commands by key. Stable, so commands with equal keys keep
+    // their submission order.
+    void Sort();
+
+    inline size_t GetSize() const { return m_Commands.size(); }
+    // The `index`th command in key order. Only valid after `Sort`.
+    inline const DrawCommand& GetSorted(const size_t index) const
+    {
+        return m_Commands[(m_SortedInScratch ? m_Scratch : m_Entries)[index].Index];
+    }
+
+private:
+    struct SortEntry {
+        uint64_t Key;
+        uint32_t Index;
+    };
+
+    std::vector<DrawCommand> m_Commands;
+    // Least significant digit radix sort ping-pongs between the two.
+    std::vector<SortEntry> m_Entries;
+    std::vector<SortEntry> m_Scratch;
+    bool m_SortedInScratch;
+    std::array<std::array<uint32_t, 256>, 8> m_Histograms;
+};
+
+} // namespace engine
+
+#endif // !ENG_RENDER_QUEUE_HPP
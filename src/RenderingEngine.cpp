@@ -1,15 +1,18 @@
 #include "RenderingEngine.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <csignal>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <string_view>
 
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
-#include <SDL2/SDL_mixer.h>
-#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_blendmode.h>
 #include <SDL2/SDL_error.h>
+#include <SDL2/SDL_rect.h>
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_stdinc.h>
 #include <SDL2/SDL_version.h>
@@ -18,60 +21,115 @@
 #include <spdlog/spdlog.h>
 
 #include "EngineMetadata.hpp"
+#include "RenderQueue.hpp"
 #include "Result.hpp"
+#include "Simd.hpp"
+#include "Trace.hpp"
 
 namespace engine {
 
-RenderingEngine::RenderingEngine(const std::shared_ptr<spdlog::logger> logger, SDL_Window* window, SDL_Renderer* renderer)
+namespace {
+
+    bool IsSameDrawing(const DrawCommand& a, const DrawCommand& b)
+    {
+        return a.Texture == b.Texture
+            && a.Source.x == b.Source.x && a.Source.y == b.Source.y && a.Source.w == b.Source.w && a.Source.h == b.Source.h
+            && a.Destination.x == b.Destination.x && a.Destination.y == b.Destination.y
+            && a.Destination.w == b.Destination.w && a.Destination.h == b.Destination.h
+            && a.Color.r == b.Color.r && a.Color.g == b.Color.g && a.Color.b == b.Color.b && a.Color.a == b.Color.a
+            && a.Rotation == b.Rotation
+            && a.Blend == b.Blend;
+    }
+
+} // namespace
+
+RenderingEngine::RenderingEngine(
+    const std::shared_ptr<spdlog::logger> logger,
+    SDL_Window* window,
+    SDL_Renderer* renderer,
+    const size_t uploadBudget,
+    const bool retained,
+    const size_t chunkBudget,
+    const std::optional<ResolutionScaler>& scaler,
+    const std::shared_ptr<TaskDispatcher> tasks,
+    const bool software
+)
     : m_Window(window)
     , m_Renderer(renderer)
+    , m_InterpolationAlpha(0.0)
+    , m_Tasks(tasks)
+    , m_Mirror(software ? std::make_unique<TextureMirror>() : nullptr)
+    , m_Batch(renderer)
+    , m_Queue()
+    , m_Uploads(renderer, uploadBudget)
+    , m_Chunks(renderer, m_Batch, chunkBudget)
+    , m_Text(renderer, m_Mirror.get())
+    , m_FrameStats()
+    , m_BlendChanges(0)
+    , m_Retained(retained)
+    , m_Target(nullptr)
+    , m_TargetWidth(0)
+    , m_TargetHeight(0)
+    , m_Drawn()
+    , m_Dirty()
+    , m_RedrawnChunks()
+    , m_Invalidated(true)
+    , m_ChunksLost(false)
+    , m_Scaler(scaler)
+    , m_Scaled(nullptr)
+    , m_ScaledWidth(0)
+    , m_ScaledHeight(0)
+    , m_Software(software ? std::make_unique<SoftwareRasterizer>(*m_Mirror, simd::GetLevel()) : nullptr)
+    , m_SoftwareFrame(nullptr)
     , m_Logger(logger)
 {
+    m_Uploads.SetMirror(m_Mirror.get());
+    SDL_AddEventWatch(WatchEvents, this);
 }
 
 RenderingEngine::~RenderingEngine()
 {
     m_Logger->trace("Finalizing RenderingEngine");
+    SDL_DelEventWatch(WatchEvents, this);
+    if (m_Target)
+        SDL_DestroyTexture(m_Target);
+    if (m_Scaled)
+        SDL_DestroyTexture(m_Scaled);
+    if (m_SoftwareFrame)
+        SDL_DestroyTexture(m_SoftwareFrame);
+    // Their textures go away with the renderer.
+    m_Chunks.Clear();
+    m_Text.Clear();
     SDL_DestroyWindow(m_Window);
     m_Window = nullptr;
     SDL_DestroyRenderer(m_Renderer);
     m_Renderer = nullptr;
 
-    TTF_Quit();
-    Mix_Quit();
-    IMG_Quit();
     SDL_Quit();
 }
 
-Result<std::shared_ptr<RenderingEngine>>
-RenderingEngine::New(const std::shared_ptr<spdlog::logger> logger, const Config& cfg)
+Result<std::shared_ptr<RenderingEngine>> RenderingEngine::New(
+    const std::shared_ptr<spdlog::logger> logger,
+    const std::shared_ptr<TaskDispatcher> tasks,
+    const Config& cfg
+)
 {
     if (SDL_WasInit(0)) {
         return Error(Error::Sdl, "SDL was already initialized");
     }
 
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
-        logger->critical("SDL init failed");
-        return Error::Sdl;
-    }
-    constexpr Uint32 imgFlags = IMG_INIT_JPG | IMG_INIT_PNG;
-    if ((IMG_Init(imgFlags) & imgFlags) != imgFlags) {
-        logger->critical("SDL Image init failed");
-        SDL_Quit();
-        return Error::Sdl;
-    }
-    constexpr Uint32 mixFlags = MIX_INIT_MP3 | MIX_INIT_OGG;
-    if ((Mix_Init(mixFlags) & mixFlags) != mixFlags) {
-        logger->critical("SDL Mixer init failed");
-        SDL_Quit();
-        IMG_Quit();
-        return Error::Sdl;
+    ENG_TRACE_ZONE("RenderingEngine::New");
+
+    // Only what the window needs, everything else is brought up by
+    // `Subsystems` once the game asks for it.
+    constexpr Uint32 sdlFlags = SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER;
+    if (cfg.Headless.Enabled) {
+        // Must be set before the video subsystem is initialized.
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
     }
-    if (TTF_Init() != 0) {
-        logger->critical("SDL TTF init failed");
-        SDL_Quit();
-        IMG_Quit();
-        TTF_Quit();
+
+    if (SDL_Init(sdlFlags) != 0) {
+        logger->critical("SDL init failed");
         return Error::Sdl;
     }
 
@@ -91,17 +149,19 @@ RenderingEngine::New(const std::shared_ptr<spdlog::logger> logger, const Config&
         auto error = SDL_GetError();
         logger->error("Couldn't create window: {}", error);
         SDL_Quit();
-        IMG_Quit();
-        TTF_Quit();
         return Error(Error::Sdl, error);
     }
 
     Uint32 rendererFlags = 0;
-    if (cfg.Render.Accelerated) {
-        rendererFlags |= SDL_RENDERER_ACCELERATED;
-    }
-    if (cfg.Render.VSync) {
-        rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+    if (cfg.Headless.Enabled) {
+        rendererFlags |= SDL_RENDERER_SOFTWARE;
+    } else {
+        if (cfg.Render.Accelerated) {
+            rendererFlags |= SDL_RENDERER_ACCELERATED;
+        }
+        if (cfg.Render.VSync) {
+            rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+        }
     }
 
     auto renderer = SDL_CreateRenderer(window, -1, rendererFlags);
@@ -109,10 +169,8 @@ RenderingEngine::New(const std::shared_ptr<spdlog::logger> logger, const Config&
     if (!renderer) {
         auto error = SDL_GetError();
         logger->error("Couldn't create renderer from window: {}", error);
-        SDL_Quit();
-        IMG_Quit();
-        TTF_Quit();
         SDL_DestroyWindow(window);
+        SDL_Quit();
         return Error(Error::Sdl, error);
     }
 
@@ -128,7 +186,56 @@ RenderingEngine::New(const std::shared_ptr<spdlog::logger> logger, const Config&
         logger->info("Using SDL v{}.{}.{} with {} as a rendering backend on {}", SDL_MAJOR_VERSION, SDL_MINOR_VERSION, SDL_PATCHLEVEL, rendererInfo.name, videoDriver);
     }
 
-    return Result(std::make_shared<RenderingEngine>(logger, window, renderer));
+    const bool software = cfg.Render.Backend == RenderBackend::Software;
+    if (software) {
+        logger->info(
+            "Rasterizing in software on {} threads with {} kernels",
+            tasks->GetWorkerCount() + 1,
+            simd::ToString(simd::GetLevel())
+        );
+    }
+
+    bool retained = cfg.Render.Retained;
+    if (retained && software) {
+        logger->warn("Retained mode doesn't apply to software rendering");
+        retained = false;
+    } else if (retained && SDL_RenderTargetSupported(renderer) != SDL_TRUE) {
+        logger->warn("Render targets aren't supported, redrawing every frame");
+        retained = false;
+    }
+
+    std::optional<ResolutionScaler> scaler;
+    if (cfg.Render.DynamicResolution) {
+        if (retained) {
+            logger->warn("Dynamic resolution doesn't apply in retained mode");
+        } else if (software) {
+            logger->warn("Dynamic resolution doesn't apply to software rendering");
+        } else if (SDL_RenderTargetSupported(renderer) != SDL_TRUE) {
+            logger->warn("Render targets aren't supported, rendering at the native resolution");
+        } else {
+            scaler.emplace(cfg.Render.MinResolutionScale, cfg.Render.MaxResolutionScale, cfg.Render.TargetFrameTime);
+            logger->info(
+                "Scaling the resolution between {:.2f} and {:.2f} to stay under {:.2f}ms a frame",
+                cfg.Render.MinResolutionScale,
+                cfg.Render.MaxResolutionScale,
+                cfg.Render.TargetFrameTime * 1000.0
+            );
+        }
+    }
+
+    // Chunk textures are render targets the rasterizer can't read.
+    const size_t chunkBudget = software ? 0 : cfg.Render.ChunkCacheBudget;
+    return Result(std::make_shared<RenderingEngine>(
+        logger,
+        window,
+        renderer,
+        cfg.Render.UploadBudget,
+        retained,
+        chunkBudget,
+        scaler,
+        tasks,
+        software
+    ));
 }
 
 void RenderingEngine::SetWindowTitle(const std::string_view title)
@@ -137,14 +244,410 @@ void RenderingEngine::SetWindowTitle(const std::string_view title)
     SDL_SetWindowTitle(m_Window, title.data());
 }
 
-Result<> RenderingEngine::Update()
+SDL_Point RenderingEngine::GetOutputSize() const
+{
+    SDL_Point size { 0, 0 };
+    SDL_GetRendererOutputSize(m_Renderer, &size.x, &size.y);
+    return size;
+}
+
+Result<> RenderingEngine::Update(const FrameData& frame)
+{
+    ENG_TRACE_ZONE("RenderingEngine::Update");
+
+    m_InterpolationAlpha = frame.Alpha;
+
+    m_Uploads.Process();
+    BuildQueue(frame);
+
+    m_Batch.ResetStats();
+    m_BlendChanges = 0;
+    bool present = true;
+    const float scale = m_Scaler ? m_Scaler->GetScale() : 1.0f;
+    if (m_Software) {
+        DrawSoftware();
+    } else if (m_Retained) {
+        present = DrawRetained();
+    } else if (scale >= 1.0f || !DrawScaled(scale)) {
+        SDL_SetRenderDrawColor(m_Renderer, 0, 0, 0, 255);
+        SDL_RenderClear(m_Renderer);
+        Execute(m_Queue, nullptr);
+    }
+
+    const auto& batchStats = m_Batch.GetStats();
+    const auto& uploadStats = m_Uploads.GetStats();
+    m_FrameStats = RenderStats {
+        .Visible = frame.Sprites.size(),
+        .Culled = frame.Culled,
+        .Commands = m_Queue.GetSize(),
+        .BlendChanges = m_BlendChanges,
+        .Sprites = batchStats.Sprites,
+        .Vertices = batchStats.Vertices,
+        .DrawCalls = batchStats.DrawCalls,
+        .Uploads = uploadStats.Uploads,
+        .UploadedBytes = uploadStats.Bytes,
+        .PendingUploads = uploadStats.Pending,
+        .DirtyRects = m_Retained ? m_Dirty.GetRects().size() : 0,
+        .DirtyPixels = m_Retained ? m_Dirty.GetArea() : 0,
+        .Presented = present,
+        .Chunks = frame.Chunks.size(),
+        .ChunkRenders = m_Chunks.GetStats().Renders,
+        .ChunkEvictions = m_Chunks.GetStats().Evictions,
+        .ChunkBytes = m_Chunks.GetStats().Bytes,
+        .GlyphMisses = m_Text.GetStats().GlyphMisses,
+        .TextLayoutHits = m_Text.GetStats().LayoutHits,
+        .TextLayoutMisses = m_Text.GetStats().LayoutMisses,
+        .GlyphPages = m_Text.GetStats().Pages,
+        .GlyphOccupancy = m_Text.GetStats().Occupancy,
+        .ResolutionScale = scale,
+        .AverageFrameTime = m_Scaler ? m_Scaler->GetAverageFrameTime() : 0.0,
+        .TargetFrameTime = m_Scaler ? m_Scaler->GetTargetFrameTime() : 0.0,
+        .RasterTiles = m_Software ? m_Software->GetStats().Tiles : 0,
+        .RasterCommands = m_Software ? m_Software->GetStats().Binned : 0,
+        .RasterMissing = m_Software ? m_Software->GetStats().Missing : 0,
+    };
+
+    ENG_TRACE_COUNTER("Visible sprites", m_FrameStats.Visible);
+    ENG_TRACE_COUNTER("Culled sprites", m_FrameStats.Culled);
+    ENG_TRACE_COUNTER("Draw calls", m_FrameStats.DrawCalls);
+    ENG_TRACE_COUNTER("Uploaded bytes", m_FrameStats.UploadedBytes);
+    ENG_TRACE_COUNTER("Vertices", m_FrameStats.Vertices);
+    ENG_TRACE_COUNTER("Chunk renders", m_FrameStats.ChunkRenders);
+    ENG_TRACE_COUNTER("Glyph misses", m_FrameStats.GlyphMisses);
+    if (m_Scaler)
+        ENG_TRACE_COUNTER("Resolution scale", m_FrameStats.ResolutionScale);
+    ENG_TRACE_COUNTER("Glyph atlas occupancy", m_FrameStats.GlyphOccupancy);
+    if (m_Retained)
+        ENG_TRACE_COUNTER("Dirty pixels", m_FrameStats.DirtyPixels);
+    if (m_Software)
+        ENG_TRACE_COUNTER("Rasterized tiles", m_FrameStats.RasterTiles);
+
+    if (present) {
+        ENG_TRACE_ZONE("SDL_RenderPresent");
+        SDL_RenderPresent(m_Renderer);
+    }
+
+    return Result();
+}
+
+void RenderingEngine::BuildQueue(const FrameData& frame)
+{
+    ENG_TRACE_ZONE("RenderingEngine::BuildQueue");
+
+    const double alpha = frame.Alpha;
+
+    m_Queue.Clear();
+    m_Queue.Append(frame.Commands);
+    SubmitChunks(frame);
+
+    m_Text.BeginFrame();
+    for (const auto& text : frame.Texts)
+        m_Text.Submit(m_Queue, text);
+    for (const auto& sprite : frame.Sprites) {
+        SDL_Rect source = sprite.Source;
+        if (source.w == 0 || source.h == 0) {
+            source.x = source.y = 0;
+            if (SDL_QueryTexture(sprite.Texture, nullptr, nullptr, &source.w, &source.h) != 0)
+                continue;
+        }
+
+        const double x = sprite.PreviousPosition.X + (static_cast<double>(sprite.Position.X) - sprite.PreviousPosition.X) * alpha;
+        const double y = sprite.PreviousPosition.Y + (static_cast<double>(sprite.Position.Y) - sprite.PreviousPosition.Y) * alpha;
+
+        const SDL_FRect world {
+            static_cast<float>(x),
+            static_cast<float>(y),
+            static_cast<float>(source.w),
+            static_cast<float>(source.h),
+        };
+        // Snapped to whole pixels on screen.
+        SDL_FRect dest = frame.View.ToScreen(world);
+        dest.x = std::floor(dest.x);
+        dest.y = std::floor(dest.y);
+        // Y-sorted by the sprite's bottom edge in the world, so that moving
+        // the camera doesn't reorder anything.
+        const uint32_t depth = renderKey::ClampDepth(world.y + world.h);
+        m_Queue.Submit(renderKey::DefaultLayer, depth, sprite.Texture, source, dest, sprite.Color, sprite.Rotation);
+    }
+
+    m_Queue.Sort();
+}
+
+void RenderingEngine::SubmitChunks(const FrameData& frame)
 {
+    ENG_TRACE_ZONE("RenderingEngine::SubmitChunks");
+
+    m_Chunks.BeginFrame();
+    m_RedrawnChunks.clear();
+    if (m_ChunksLost.exchange(false, std::memory_order_relaxed))
+        m_Chunks.Clear();
+
+    for (const auto& chunk : frame.Chunks) {
+        // Both edges snapped, so neighbouring chunks meet without a seam at
+        // any zoom.
+        const SDL_FRect world {
+            static_cast<float>(chunk.Bounds.x),
+            static_cast<float>(chunk.Bounds.y),
+            static_cast<float>(chunk.Bounds.w),
+            static_cast<float>(chunk.Bounds.h),
+        };
+        const SDL_FRect screen = frame.View.ToScreen(world);
+        const float left = std::floor(screen.x);
+        const float top = std::floor(screen.y);
+        const SDL_FRect dest { left, top, std::floor(screen.x + screen.w) - left, std::floor(screen.y + screen.h) - top };
+
+        const size_t renders = m_Chunks.GetStats().Renders;
+        if (SDL_Texture* texture = m_Chunks.Get(chunk)) {
+            const SDL_Rect source { 0, 0, chunk.Bounds.w, chunk.Bounds.h };
+            m_Queue.Submit(chunk.Layer, 0, texture, source, dest);
+            if (m_Retained && m_Chunks.GetStats().Renders != renders)
+                m_RedrawnChunks.push_back(SDL_Rect {
+                    static_cast<int>(left) - 1,
+                    static_cast<int>(top) - 1,
+                    static_cast<int>(dest.w) + 2,
+                    static_cast<int>(dest.h) + 2,
+                });
+            continue;
+        }
+
+        // Without render targets, or out of texture memory, the tiles are
+        // drawn one by one.
+        const auto& set = chunk.Set;
+        const float scaleX = dest.w / chunk.Bounds.w;
+        const float scaleY = dest.h / chunk.Bounds.h;
+        for (int y = 0; y < TileChunk::Size; y++) {
+            for (int x = 0; x < TileChunk::Size; x++) {
+                const TileId tile = chunk.Tiles->Tiles[y * TileChunk::Size + x];
+                if (tile == EmptyTile)
+                    continue;
+                const SDL_FRect tileDest {
+                    dest.x + x * set.TileWidth * scaleX,
+                    dest.y + y * set.TileHeight * scaleY,
+                    set.TileWidth * scaleX,
+                    set.TileHeight * scaleY,
+                };
+                m_Queue.Submit(chunk.Layer, 0, set.Texture, set.GetTileSource(tile), tileDest);
+            }
+        }
+    }
+
+    m_Chunks.Trim();
+}
+
+bool RenderingEngine::DrawRetained()
+{
+    ENG_TRACE_ZONE("RenderingEngine::DrawRetained");
+
+    int width = 0;
+    int height = 0;
+    SDL_GetRendererOutputSize(m_Renderer, &width, &height);
+
+    bool full = m_Invalidated.exchange(false, std::memory_order_relaxed);
+    if (!m_Target || width != m_TargetWidth || height != m_TargetHeight) {
+        if (m_Target)
+            SDL_DestroyTexture(m_Target);
+        m_Target = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!m_Target) {
+            m_Logger->error("Couldn't create the retained frame, redrawing every frame: {}", SDL_GetError());
+            m_Retained = false;
+            SDL_SetRenderDrawColor(m_Renderer, 0, 0, 0, 255);
+            SDL_RenderClear(m_Renderer);
+            Execute(m_Queue, nullptr);
+            return true;
+        }
+        m_TargetWidth = width;
+        m_TargetHeight = height;
+        full = true;
+    }
+
+    // Anything that differs from what was drawn at the same position in
+    // the sorted order dirties both where it was and where it is now. That
+    // covers sprites that moved, changed or were reordered.
+    m_Dirty.Clear();
+    const SDL_Rect screen { 0, 0, width, height };
+    if (full) {
+        m_Dirty.Add(screen);
+    } else {
+        for (const auto& rect : m_RedrawnChunks)
+            m_Dirty.Add(rect);
+        const size_t count = m_Queue.GetSize();
+        for (size_t i = 0; i < std::max(count, m_Drawn.size()); i++) {
+            const DrawCommand* current = i < count ? &m_Queue.GetSorted(i) : nullptr;
+            const DrawCommand* previous = i < m_Drawn.size() ? &m_Drawn[i] : nullptr;
+            if (current && previous && IsSameDrawing(*current, *previous))
+                continue;
+            if (current)
+                m_Dirty.Add(GetBounds(*current));
+            if (previous)
+                m_Dirty.Add(GetBounds(*previous));
+        }
+    }
+    m_Dirty.Finish(screen);
+
+    m_Drawn.resize(m_Queue.GetSize());
+    for (size_t i = 0; i < m_Drawn.size(); i++)
+        m_Drawn[i] = m_Queue.GetSorted(i);
+
+    if (m_Dirty.IsEmpty())
+        return false;
+
+    SDL_SetRenderTarget(m_Renderer, m_Target);
+    SDL_SetRenderDrawBlendMode(m_Renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(m_Renderer, 0, 0, 0, 255);
+    for (const auto& rect : m_Dirty.GetRects()) {
+        SDL_RenderSetClipRect(m_Renderer, &rect);
+        SDL_RenderFillRect(m_Renderer, &rect);
+        Execute(m_Queue, &rect);
+    }
+    SDL_RenderSetClipRect(m_Renderer, nullptr);
+    SDL_SetRenderTarget(m_Renderer, nullptr);
+
+    // The back buffer is undefined after presenting, so the whole frame is
+    // copied over.
+    SDL_RenderCopy(m_Renderer, m_Target, nullptr, nullptr);
+    return true;
+}
+
+bool RenderingEngine::DrawScaled(const float scale)
+{
+    ENG_TRACE_ZONE("RenderingEngine::DrawScaled");
+
+    int width = 0;
+    int height = 0;
+    SDL_GetRendererOutputSize(m_Renderer, &width, &height);
+
+    if (!m_Scaled || width != m_ScaledWidth || height != m_ScaledHeight) {
+        if (m_Scaled)
+            SDL_DestroyTexture(m_Scaled);
+        m_Scaled = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!m_Scaled) {
+            m_Logger->error("Couldn't create the scaled frame, rendering at the native resolution: {}", SDL_GetError());
+            m_Scaler.reset();
+            return false;
+        }
+        SDL_SetTextureScaleMode(m_Scaled, SDL_ScaleModeLinear);
+        SDL_SetTextureBlendMode(m_Scaled, SDL_BLENDMODE_NONE);
+        m_ScaledWidth = width;
+        m_ScaledHeight = height;
+    }
+
+    // Drawing in window coordinates, scaled down into the top left.
+    SDL_SetRenderTarget(m_Renderer, m_Scaled);
     SDL_SetRenderDrawColor(m_Renderer, 0, 0, 0, 255);
     SDL_RenderClear(m_Renderer);
+    SDL_RenderSetScale(m_Renderer, scale, scale);
+    Execute(m_Queue, nullptr);
+    SDL_RenderSetScale(m_Renderer, 1.0f, 1.0f);
+    SDL_SetRenderTarget(m_Renderer, nullptr);
 
-    SDL_RenderPresent(m_Renderer);
+    const SDL_Rect source {
+        0,
+        0,
+        std::max(static_cast<int>(std::ceil(width * scale)), 1),
+        std::max(static_cast<int>(std::ceil(height * scale)), 1),
+    };
+    SDL_RenderCopy(m_Renderer, m_Scaled, &source, nullptr);
+    return true;
+}
 
-    return Result();
+void RenderingEngine::DrawSoftware()
+{
+    ENG_TRACE_ZONE("RenderingEngine::DrawSoftware");
+
+    int width = 0;
+    int height = 0;
+    SDL_GetRendererOutputSize(m_Renderer, &width, &height);
+
+    if (!m_SoftwareFrame || width != m_Software->GetWidth() || height != m_Software->GetHeight()) {
+        if (m_SoftwareFrame)
+            SDL_DestroyTexture(m_SoftwareFrame);
+        m_SoftwareFrame = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+        if (!m_SoftwareFrame) {
+            m_Logger->error("Couldn't create the software frame, rendering with SDL: {}", SDL_GetError());
+            m_Software.reset();
+            SDL_SetRenderDrawColor(m_Renderer, 0, 0, 0, 255);
+            SDL_RenderClear(m_Renderer);
+            Execute(m_Queue, nullptr);
+            return;
+        }
+        SDL_SetTextureBlendMode(m_SoftwareFrame, SDL_BLENDMODE_NONE);
+        m_Software->Resize(width, height);
+    }
+
+    m_Software->Draw(m_Queue, m_Tasks.get());
+
+    {
+        ENG_TRACE_ZONE("Software frame upload");
+        SDL_UpdateTexture(m_SoftwareFrame, nullptr, m_Software->GetPixels(), width * static_cast<int>(sizeof(uint32_t)));
+    }
+    SDL_RenderCopy(m_Renderer, m_SoftwareFrame, nullptr, nullptr);
+}
+
+void RenderingEngine::AddFrameTime(const double seconds)
+{
+    if (!m_Scaler || !m_Scaler->AddFrameTime(seconds))
+        return;
+
+    m_Logger->debug(
+        "Rendering at {:.0f}% of the resolution for a target of {:.2f}ms a frame",
+        m_Scaler->GetScale() * 100.0f,
+        m_Scaler->GetTargetFrameTime() * 1000.0
+    );
+}
+
+int RenderingEngine::WatchEvents(void* self, SDL_Event* event)
+{
+    auto* engine = static_cast<RenderingEngine*>(self);
+    if (event->type == SDL_RENDER_TARGETS_RESET || event->type == SDL_RENDER_DEVICE_RESET) {
+        engine->Invalidate();
+        engine->m_ChunksLost.store(true, std::memory_order_relaxed);
+    } else if (event->type == SDL_WINDOWEVENT) {
+        // The window system may have thrown away what was presented, so the
+        // next frame can't count on it.
+        switch (event->window.event) {
+        case SDL_WINDOWEVENT_EXPOSED:
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_SIZE_CHANGED:
+            engine->Invalidate();
+            break;
+        default:
+            break;
+        }
+    }
+    return 0;
+}
+
+void RenderingEngine::Execute(const RenderQueue& queue, const SDL_Rect* clip)
+{
+    ENG_TRACE_ZONE("RenderingEngine::Execute");
+
+    SDL_Texture* texture = nullptr;
+    BlendMode blend = BlendMode::Blend;
+    for (size_t i = 0; i < queue.GetSize(); i++) {
+        const auto& command = queue.GetSorted(i);
+        if (clip) {
+            const SDL_Rect bounds = GetBounds(command);
+            if (SDL_HasIntersection(&bounds, clip) != SDL_TRUE)
+                continue;
+        }
+
+        if (command.Texture != texture || command.Blend != blend) {
+            // The blend mode is texture state, queued quads of the same
+            // texture have to be drawn with the old one first.
+            if (command.Texture == texture)
+                m_Batch.Flush();
+            SDL_BlendMode current;
+            if (SDL_GetTextureBlendMode(command.Texture, &current) != 0 || current != ToSdlBlendMode(command.Blend)) {
+                SDL_SetTextureBlendMode(command.Texture, ToSdlBlendMode(command.Blend));
+                m_BlendChanges++;
+            }
+            texture = command.Texture;
+            blend = command.Blend;
+        }
+
+        m_Batch.Draw(command.Texture, command.Source, command.Destination, command.Color, command.Rotation);
+    }
+    m_Batch.Flush();
 }
 
 } // namespace engine
@@ -1,31 +1,181 @@
 #ifndef ENG_RENDERING_ENGINE_HPP
 #define ENG_RENDERING_ENGINE_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string_view>
+#include <vector>
 
 #include <SDL2/SDL.h>
 #include <spdlog/logger.h>
 
+#include "ChunkCache.hpp"
 #include "Config.hpp"
+#include "DirtyRegion.hpp"
+#include "FrameData.hpp"
+#include "RenderQueue.hpp"
+#include "ResolutionScaler.hpp"
 #include "Result.hpp"
+#include "SoftwareRasterizer.hpp"
+#include "SpriteBatch.hpp"
+#include "Task.hpp"
+#include "TextRenderer.hpp"
+#include "TextureMirror.hpp"
+#include "TextureUpload.hpp"
 
 namespace engine {
 
+// Counted over the last frame drawn.
+struct RenderStats {
+    // Entity sprites in and out of the camera's view.
+    size_t Visible = 0;
+    size_t Culled = 0;
+    size_t Commands = 0;
+    size_t BlendChanges = 0;
+    size_t Sprites = 0;
+    size_t Vertices = 0;
+    size_t DrawCalls = 0;
+    size_t Uploads = 0;
+    size_t UploadedBytes = 0;
+    size_t PendingUploads = 0;
+    // Retained mode only: what was redrawn, and whether anything was.
+    size_t DirtyRects = 0;
+    uint64_t DirtyPixels = 0;
+    bool Presented = false;
+    // Tile layer chunks drawn, and how many of them had to be drawn into
+    // their texture first.
+    size_t Chunks = 0;
+    size_t ChunkRenders = 0;
+    size_t ChunkEvictions = 0;
+    size_t ChunkBytes = 0;
+    // Glyphs rasterized this frame, and the state of the glyph atlas.
+    size_t GlyphMisses = 0;
+    size_t TextLayoutHits = 0;
+    size_t TextLayoutMisses = 0;
+    size_t GlyphPages = 0;
+    double GlyphOccupancy = 0.0;
+    // Share of the window's resolution the frame was rendered at, and the
+    // frame times steering it, in seconds.
+    float ResolutionScale = 1.0f;
+    double AverageFrameTime = 0.0;
+    double TargetFrameTime = 0.0;
+    // Software backend only: tiles with anything to draw, commands binned
+    // into them, and commands skipped for want of a texture's CPU copy.
+    size_t RasterTiles = 0;
+    size_t RasterCommands = 0;
+    size_t RasterMissing = 0;
+};
+
 class RenderingEngine final {
 public:
-    RenderingEngine(const std::shared_ptr<spdlog::logger> logger, SDL_Window* window, SDL_Renderer* renderer);
+    RenderingEngine(
+        const std::shared_ptr<spdlog::logger> logger,
+        SDL_Window* window,
+        SDL_Renderer* renderer,
+        const size_t uploadBudget,
+        const bool retained,
+        const size_t chunkBudget,
+        const std::optional<ResolutionScaler>& scaler,
+        const std::shared_ptr<TaskDispatcher> tasks,
+        const bool software
+    );
     ~RenderingEngine();
 
-    static Result<std::shared_ptr<RenderingEngine>> New(const std::shared_ptr<spdlog::logger> logger, const Config& cfg);
+    // The software backend rasterizes on `tasks`.
+    static Result<std::shared_ptr<RenderingEngine>> New(
+        const std::shared_ptr<spdlog::logger> logger,
+        const std::shared_ptr<TaskDispatcher> tasks,
+        const Config& cfg
+    );
 
     void SetWindowTitle(const std::string_view title);
 
-    Result<> Update();
+    inline SDL_Renderer* GetRenderer() const { return m_Renderer; }
+    // In pixels, which may differ from the window's size on high DPI
+    // displays. Main thread only.
+    SDL_Point GetOutputSize() const;
+    // Quads queued outside of `Update` need a `Flush` to reach the screen.
+    inline SpriteBatch& GetSpriteBatch() { return m_Batch; }
+    // Drained within the upload budget at the start of every `Update`.
+    inline TextureUploadQueue& GetUploadQueue() { return m_Uploads; }
+    inline TextRenderer& GetTextRenderer() { return m_Text; }
+
+    // Draws `frame`: its tile chunks and sprites through its camera, the
+    // sprites y-sorted on the default layer, and its commands and text, all
+    // in key order, with SDL or in software. In retained mode, only what
+    // changed since the last frame is redrawn and unchanged frames aren't
+    // presented. Must be called on the main thread.
+    Result<> Update(const FrameData& frame);
+
+    // Reports the time the engine spent on the last frame, waits for the
+    // frame cap aside, to the dynamic resolution scaling.
+    void AddFrameTime(const double seconds);
+
+    // Makes the next frame redraw everything in retained mode.
+    inline void Invalidate() { m_Invalidated.store(true, std::memory_order_relaxed); }
+
+    // How far, in the range 0-1, the last frame lay between the last two
+    // simulation ticks.
+    inline double GetInterpolationAlpha() const { return m_InterpolationAlpha; }
+    inline const RenderStats& GetFrameStats() const { return m_FrameStats; }
 
 private:
     SDL_Window *m_Window;
     SDL_Renderer *m_Renderer;
+    double m_InterpolationAlpha;
+    std::shared_ptr<TaskDispatcher> m_Tasks;
+    // CPU copies of the textures, software backend only.
+    std::unique_ptr<TextureMirror> m_Mirror;
+    SpriteBatch m_Batch;
+    RenderQueue m_Queue;
+    TextureUploadQueue m_Uploads;
+    ChunkCache m_Chunks;
+    TextRenderer m_Text;
+    RenderStats m_FrameStats;
+    size_t m_BlendChanges;
+
+    // Retained mode state: the frame so far and the commands it was drawn
+    // from, in order.
+    bool m_Retained;
+    SDL_Texture* m_Target;
+    int m_TargetWidth;
+    int m_TargetHeight;
+    std::vector<DrawCommand> m_Drawn;
+    DirtyRegion m_Dirty;
+    // Chunks drawn anew this frame. Their commands may not have changed.
+    std::vector<SDL_Rect> m_RedrawnChunks;
+    // Set from SDL's event watch when the renderer loses its targets.
+    std::atomic<bool> m_Invalidated;
+    std::atomic<bool> m_ChunksLost;
+
+    // Dynamic resolution: the frame is drawn into the top left of `m_Scaled`
+    // at the current scale, which is as large as the output so changing the
+    // scale never reallocates it.
+    std::optional<ResolutionScaler> m_Scaler;
+    SDL_Texture* m_Scaled;
+    int m_ScaledWidth;
+    int m_ScaledHeight;
+
+    // Software backend: the frame is rasterized on the CPU and streamed
+    // into `m_SoftwareFrame`.
+    std::unique_ptr<SoftwareRasterizer> m_Software;
+    SDL_Texture* m_SoftwareFrame;
+
+    void BuildQueue(const FrameData& frame);
+    void SubmitChunks(const FrameData& frame);
+    // Returns whether there's anything to present.
+    bool DrawRetained();
+    // Returns false if there's no offscreen target to draw into.
+    bool DrawScaled(const float scale);
+    // Falls back to SDL if there's no texture to stream the frame into.
+    void DrawSoftware();
+    // Draws the sorted queue, changing the blend mode only where it differs
+    // from the previous command's. With a `clip`, draws only what touches it.
+    void Execute(const RenderQueue& queue, const SDL_Rect* clip);
+    static int WatchEvents(void* self, SDL_Event* event);
 
 protected:
     const std::shared_ptr<spdlog::logger> m_Logger;
@@ -0,0 +1,66 @@
+#include "ResolutionScaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace engine {
+
+namespace {
+
+    // Frame time aimed for when changing the scale, below the target to
+    // leave room for noise.
+    constexpr double Headroom = 0.9;
+    // Below this share of the target there's time for more pixels.
+    constexpr double RaiseThreshold = 0.75;
+    // Bounds on a single change of the scale.
+    constexpr double MaxDecrease = 0.75;
+    constexpr double MaxIncrease = 1.1;
+    // Smaller changes aren't worth the blurrier or sharper jump.
+    constexpr float MinChange = 0.02f;
+
+} // namespace
+
+ResolutionScaler::ResolutionScaler(const float minScale, const float maxScale, const double targetFrameTime)
+    : m_MinScale(std::clamp(minScale, 0.1f, 1.0f))
+    , m_MaxScale(std::clamp(maxScale, m_MinScale, 1.0f))
+    , m_TargetFrameTime(targetFrameTime)
+    , m_Scale(m_MaxScale)
+    , m_Samples()
+    , m_Count(0)
+    , m_Sum(0.0)
+{
+}
+
+bool ResolutionScaler::AddFrameTime(const double seconds)
+{
+    m_Sum += seconds - (m_Count >= WindowSize ? m_Samples[m_Count % WindowSize] : 0.0);
+    m_Samples[m_Count % WindowSize] = seconds;
+    m_Count++;
+    if (m_Count < WindowSize || m_TargetFrameTime <= 0.0)
+        return false;
+
+    const double average = GetAverageFrameTime();
+    if (average <= m_TargetFrameTime && average >= m_TargetFrameTime * RaiseThreshold)
+        return false;
+
+    const double factor = std::clamp(std::sqrt(m_TargetFrameTime * Headroom / average), MaxDecrease, MaxIncrease);
+    const float scale = std::clamp(static_cast<float>(m_Scale * factor), m_MinScale, m_MaxScale);
+    if (std::abs(scale - m_Scale) < MinChange && scale != m_MinScale && scale != m_MaxScale)
+        return false;
+    if (scale == m_Scale)
+        return false;
+
+    m_Scale = scale;
+    m_Count = 0;
+    m_Sum = 0.0;
+    return true;
+}
+
+double ResolutionScaler::GetAverageFrameTime() const
+{
+    const size_t samples = std::min(m_Count, WindowSize);
+    return samples == 0 ? 0.0 : m_Sum / samples;
+}
+
+} // namespace engine
@@ -0,0 +1,41 @@
+#ifndef ENG_RESOLUTION_SCALER_HPP
+#define ENG_RESOLUTION_SCALER_HPP
+
+#include <array>
+#include <cstddef>
+
+namespace engine {
+
+// Picks the resolution scale that keeps the rolling average frame time
+// just under a target. Rendering cost follows the pixel count, the square
+// of the scale. The scale drops quickly and rises slowly, and holds for a
+// full window of frames after every change so each step can take effect.
+class ResolutionScaler final {
+public:
+    static constexpr size_t WindowSize = 32;
+
+    ResolutionScaler(const float minScale, const float maxScale, const double targetFrameTime);
+    ~ResolutionScaler() = default;
+
+    // Adds the time spent on a frame, in seconds, and returns whether the
+    // scale changed.
+    bool AddFrameTime(const double seconds);
+
+    inline float GetScale() const { return m_Scale; }
+    inline double GetTargetFrameTime() const { return m_TargetFrameTime; }
+    // Over the frames since the last change, 0 if there are none yet.
+    double GetAverageFrameTime() const;
+
+private:
+    float m_MinScale;
+    float m_MaxScale;
+    double m_TargetFrameTime;
+    float m_Scale;
+    std::array<double, WindowSize> m_Samples;
+    size_t m_Count;
+    double m_Sum;
+};
+
+} // namespace engine
+
+#endif // !ENG_RESOLUTION_SCALER_HPP
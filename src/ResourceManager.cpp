@@ -0,0 +1,676 @@
+#include "ResourceManager.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_stdinc.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_ttf.h>
+#include <spdlog/logger.h>
+
+#include "Atlas.hpp"
+#include "BinaryBuffer.hpp"
+#include "Game.hpp"
+#include "Pack.hpp"
+#include "Result.hpp"
+#include "Task.hpp"
+#include "TextRenderer.hpp"
+#include "TextureUpload.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+namespace {
+
+    // The first 32-bit format with alpha the renderer lists, which is the
+    // one it handles best.
+    Uint32 GetPreferredTextureFormat(SDL_Renderer* renderer)
+    {
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(renderer, &info) == 0) {
+            for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+                const Uint32 format = info.texture_formats[i];
+                if (SDL_ISPIXELFORMAT_ALPHA(format) && SDL_BITSPERPIXEL(format) == 32)
+                    return format;
+            }
+        }
+        return SDL_PIXELFORMAT_ARGB8888;
+    }
+
+} // namespace
+
+ResourceHandle::ResourceHandle(ResourceEntry* entry)
+    : m_Entry(entry)
+{
+    if (m_Entry)
+        m_Entry->Manager->AddRef(*m_Entry);
+}
+
+ResourceHandle::ResourceHandle(const ResourceHandle& other)
+    : ResourceHandle(other.m_Entry)
+{
+}
+
+ResourceHandle::ResourceHandle(ResourceHandle&& other) noexcept
+    : m_Entry(std::exchange(other.m_Entry, nullptr))
+{
+}
+
+ResourceHandle& ResourceHandle::operator=(ResourceHandle other) noexcept
+{
+    std::swap(m_Entry, other.m_Entry);
+    return *this;
+}
+
+ResourceHandle::~ResourceHandle()
+{
+    if (m_Entry)
+        m_Entry->Manager->Release(*m_Entry);
+}
+
+game::ResourceType ResourceHandle::GetType() const
+{
+    return m_Entry->Def.Type;
+}
+
+const std::string& ResourceHandle::GetKey() const
+{
+    return m_Entry->Def.Key;
+}
+
+bool ResourceHandle::IsStreaming() const
+{
+    return m_Entry && m_Entry->Streaming;
+}
+
+SDL_Texture* ResourceHandle::GetTexture() const
+{
+    return m_Entry ? m_Entry->Texture : nullptr;
+}
+
+SDL_Rect ResourceHandle::GetSourceRect() const
+{
+    return m_Entry ? m_Entry->SourceRect : SDL_Rect {};
+}
+
+Mix_Music* ResourceHandle::GetMusic() const
+{
+    return m_Entry ? m_Entry->Music : nullptr;
+}
+
+Mix_Chunk* ResourceHandle::GetSoundEffect() const
+{
+    return m_Entry ? m_Entry->SoundEffect : nullptr;
+}
+
+TTF_Font* ResourceHandle::GetFont() const
+{
+    return m_Entry ? m_Entry->Font : nullptr;
+}
+
+const std::string* ResourceHandle::GetText() const
+{
+    if (!m_Entry || m_Entry->Def.Type != game::ResourceType::Text)
+        return nullptr;
+    return &m_Entry->Text;
+}
+
+std::span<const std::byte> ResourceHandle::GetData() const
+{
+    if (!m_Entry || m_Entry->Def.Type != game::ResourceType::Animation)
+        return {};
+    return m_Entry->Data;
+}
+
+ResourceManager::ResourceManager(
+    const std::shared_ptr<spdlog::logger> logger,
+    SDL_Renderer* renderer,
+    const std::filesystem::path& root,
+    const std::shared_ptr<Pack> pack,
+    const std::shared_ptr<TaskDispatcher> tasks,
+    TextureUploadQueue& uploads,
+    const size_t budgetBytes,
+    const int atlasPageSize,
+    const int atlasPadding
+)
+    : m_Logger(logger)
+    , m_Renderer(renderer)
+    , m_Root(root)
+    , m_Pack(pack)
+    , m_Tasks(tasks)
+    , m_Uploads(&uploads)
+    , m_TextureFormat(GetPreferredTextureFormat(renderer))
+    , m_BudgetBytes(budgetBytes)
+    , m_AtlasPageSize(atlasPageSize)
+    , m_AtlasPadding(atlasPadding)
+    , m_Entries()
+    , m_Order()
+    , m_Lru()
+    , m_Atlas()
+    , m_Hits(0)
+    , m_Misses(0)
+    , m_Evictions(0)
+    , m_ResidentBytes(0)
+    , m_ResidentCount(0)
+{
+}
+
+ResourceManager::~ResourceManager()
+{
+    m_Logger->trace("Finalizing ResourceManager");
+
+    for (auto& [_, entry] : m_Entries) {
+        if (!entry.Streaming)
+            continue;
+        m_Tasks->Wait(entry.Decode);
+        m_Uploads->Cancel(&entry);
+        entry.Streaming = false;
+    }
+
+    for (auto& [_, entry] : m_Entries) {
+        if (entry.RefCount != 0)
+            m_Logger->warn("Resource {} is still referenced", entry.Def.Key);
+        if (entry.Resident)
+            Unload(entry);
+    }
+}
+
+Result<std::shared_ptr<ResourceManager>> ResourceManager::New(
+    const std::shared_ptr<spdlog::logger> logger,
+    SDL_Renderer* renderer,
+    const std::filesystem::path& root,
+    const std::shared_ptr<Pack> pack,
+    const std::shared_ptr<TaskDispatcher> tasks,
+    TextureUploadQueue& uploads,
+    const game::ResourceTable& table,
+    const Config& cfg
+)
+{
+    auto self = std::make_shared<ResourceManager>(
+        logger,
+        renderer,
+        root,
+        pack,
+        tasks,
+        uploads,
+        cfg.Resources.MemoryBudget,
+        cfg.Resources.AtlasPageSize,
+        cfg.Resources.AtlasPadding
+    );
+
+    self->m_Entries.reserve(table.Entries.size());
+    self->m_Order.reserve(table.Entries.size());
+    for (const auto& def : table.Entries) {
+        auto [it, inserted] = self->m_Entries.try_emplace(def.Key);
+        if (!inserted) {
+            logger->error("Duplicate resource key {}", def.Key);
+            return Error(Error::InvalidGame, "Duplicate resource key");
+        }
+        it->second.Def = def;
+        it->second.Manager = self.get();
+        self->m_Order.push_back(def.Key);
+    }
+
+    return Result(self);
+}
+
+Result<> ResourceManager::LoadEager(std::vector<BinaryBuffer>&& sources)
+{
+    ENG_TRACE_ZONE("ResourceManager::LoadEager");
+
+    if (sources.size() != m_Order.size())
+        return Error(Error::InvalidState, "Resource source count doesn't match the resource table");
+
+    // Sprites are only collected at first, then decoded in parallel.
+    std::vector<ResourceEntry*> sprites;
+    std::vector<std::span<const std::byte>> spriteBytes;
+    std::vector<SDL_Surface*> surfaces;
+    struct FreeOnExit {
+        std::vector<SDL_Surface*>& Surfaces;
+        ~FreeOnExit()
+        {
+            for (auto* surface : Surfaces) {
+                if (surface)
+                    SDL_FreeSurface(surface);
+            }
+        }
+    } freeSurfaces { surfaces };
+
+    for (size_t i = 0; i < m_Order.size(); i++) {
+        auto& entry = m_Entries.at(m_Order[i]);
+        if (entry.Def.Lazy)
+            continue;
+
+        std::span<const std::byte> bytes = sources[i].GetBytes();
+        if (m_Pack) {
+            auto packed = FindPacked(entry);
+            if (packed.IsErr())
+                return packed.UnwrapErr();
+            bytes = packed.Unwrap();
+        }
+
+        if (entry.Def.Type == game::ResourceType::Sprite) {
+            // `sources` outlives the decoding.
+            sprites.push_back(&entry);
+            spriteBytes.push_back(bytes);
+            continue;
+        }
+
+        if (auto res = Load(entry, bytes, std::move(sources[i])); !res)
+            return res;
+    }
+
+    // The atlas is built from RGBA32, individual textures from the
+    // renderer's format.
+    const bool useAtlas = m_AtlasPageSize > 0;
+    const Uint32 format = useAtlas ? static_cast<Uint32>(SDL_PIXELFORMAT_RGBA32) : m_TextureFormat;
+    surfaces.resize(sprites.size(), nullptr);
+    {
+        ENG_TRACE_ZONE("Decoding sprites");
+        m_Tasks->ParallelFor(0, sprites.size(), 1, [&](const size_t from, const size_t to) {
+            for (size_t i = from; i < to; i++) {
+                auto surface = DecodeSprite(*sprites[i], spriteBytes[i], format);
+                if (surface.IsOk())
+                    surfaces[i] = surface.Unwrap();
+            }
+        });
+    }
+    for (const auto* surface : surfaces) {
+        if (!surface)
+            return Error(Error::Sdl, "Couldn't decode a sprite");
+    }
+
+    if (useAtlas && !surfaces.empty()) {
+        auto atlas = Atlas::Build(m_Logger, m_Renderer, surfaces, m_AtlasPageSize, m_AtlasPadding, m_Uploads->GetMirror());
+        if (atlas.IsErr())
+            return atlas.UnwrapErr();
+        m_Atlas = atlas.UnwrapMove();
+        m_ResidentBytes += m_Atlas.GetStats().Bytes;
+    }
+
+    for (size_t i = 0; i < sprites.size(); i++) {
+        auto& entry = *sprites[i];
+        if (useAtlas && m_Atlas.GetRegion(i)) {
+            entry.Texture = m_Atlas.GetRegion(i)->Texture;
+            entry.SourceRect = m_Atlas.GetRegion(i)->Rect;
+            entry.Pinned = true;
+            MarkResident(entry);
+        } else if (auto res = LoadSprite(entry, surfaces[i]); !res) {
+            return res;
+        }
+    }
+
+    if (m_ResidentBytes > m_BudgetBytes)
+        m_Logger->warn("The eager resources ({} bytes) don't fit the resource budget ({} bytes)", m_ResidentBytes, m_BudgetBytes);
+
+    EnforceBudget();
+
+    m_Logger->debug("{} eager resources loaded, {} bytes resident", m_ResidentCount, m_ResidentBytes);
+
+    return Result();
+}
+
+ResourceEntry* ResourceManager::Find(const std::string_view key)
+{
+    auto it = m_Entries.find(std::string(key));
+    if (it == m_Entries.end()) {
+        m_Logger->error("No such resource: {}", key);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+Result<ResourceHandle> ResourceManager::Get(const std::string_view key)
+{
+    auto* entry = Find(key);
+    if (!entry)
+        return Error(Error::InvalidState, "No such resource");
+
+    if (entry->Resident) {
+        m_Hits++;
+        return Result(ResourceHandle(entry));
+    }
+
+    if (entry->Streaming) {
+        // Referenced before it turns resident, so it can't be evicted right
+        // away.
+        ResourceHandle handle(entry);
+        m_Tasks->Wait(entry->Decode);
+        m_Uploads->Finish(entry);
+        if (entry->Resident)
+            return Result(std::move(handle));
+        // Failed, try once more synchronously to get the error.
+    }
+
+    m_Misses++;
+
+    if (auto res = Read(*entry); !res)
+        return res.UnwrapErr();
+
+    ResourceHandle handle(entry);
+    EnforceBudget();
+    return Result(std::move(handle));
+}
+
+Result<ResourceHandle> ResourceManager::Request(const std::string_view key)
+{
+    auto* entry = Find(key);
+    if (!entry)
+        return Error(Error::InvalidState, "No such resource");
+
+    if (entry->Def.Type != game::ResourceType::Sprite)
+        return Get(key);
+
+    if (entry->Resident) {
+        m_Hits++;
+    } else if (!entry->Streaming) {
+        m_Misses++;
+        Stream(*entry);
+    }
+    return Result(ResourceHandle(entry));
+}
+
+ResourceStats ResourceManager::GetStats() const
+{
+    return ResourceStats {
+        .Hits = m_Hits,
+        .Misses = m_Misses,
+        .Evictions = m_Evictions,
+        .ResidentCount = m_ResidentCount,
+        .ResidentBytes = m_ResidentBytes,
+        .BudgetBytes = m_BudgetBytes,
+        .AtlasPages = m_Atlas.GetStats().Pages,
+        .AtlasSprites = m_Atlas.GetStats().Sprites,
+        .AtlasOccupancy = m_Atlas.GetStats().Occupancy,
+    };
+}
+
+Result<std::span<const std::byte>> ResourceManager::FindPacked(const ResourceEntry& entry) const
+{
+    const auto data = m_Pack->Find(entry.Def.Source);
+    if (!data) {
+        m_Logger->error("Resource {} ({}) is missing from the pack", entry.Def.Key, entry.Def.Source);
+        return Error(Error::InvalidGame, "A resource is missing from the pack");
+    }
+    return Result(*data);
+}
+
+Result<> ResourceManager::Read(ResourceEntry& entry)
+{
+    if (m_Pack) {
+        auto data = FindPacked(entry);
+        if (data.IsErr())
+            return data.UnwrapErr();
+        return Load(entry, data.Unwrap(), BinaryBuffer());
+    }
+
+    auto source = BinaryBuffer::FromFile(m_Root / entry.Def.Source);
+    if (source.IsErr()) {
+        m_Logger->error("Couldn't read resource {}: {}", entry.Def.Key, source.UnwrapErr().ToString());
+        return source.UnwrapErr();
+    }
+
+    auto owner = source.UnwrapMove();
+    const std::span<const std::byte> bytes = owner.GetBytes();
+    return Load(entry, bytes, std::move(owner));
+}
+
+Result<> ResourceManager::Load(ResourceEntry& entry, const std::span<const std::byte> bytes, BinaryBuffer&& owner)
+{
+    ENG_TRACE_ZONE("ResourceManager::Load");
+
+    const auto& def = entry.Def;
+
+    switch (def.Type) {
+    case game::ResourceType::Sprite: {
+        auto surface = DecodeSprite(entry, bytes, m_TextureFormat);
+        if (surface.IsErr())
+            return surface.UnwrapErr();
+        auto res = LoadSprite(entry, surface.Unwrap());
+        SDL_FreeSurface(surface.Unwrap());
+        return res;
+    }
+
+    case game::ResourceType::Music:
+    case game::ResourceType::SoundEffect: {
+        // Without an open audio device (e.g. headless) the data is kept but
+        // not decoded.
+        if (Mix_QuerySpec(nullptr, nullptr, nullptr) == 0) {
+            entry.Bytes = bytes.size();
+            entry.Source = std::move(owner);
+            entry.Data = bytes;
+            break;
+        }
+
+        if (def.Type == game::ResourceType::Music) {
+            entry.Music = Mix_LoadMUS_RW(SDL_RWFromConstMem(bytes.data(), static_cast<int>(bytes.size())), 1);
+            if (!entry.Music) {
+                m_Logger->error("Couldn't decode music {}: {}", def.Key, Mix_GetError());
+                return Error(Error::Sdl, "Couldn't decode music");
+            }
+            entry.Source = std::move(owner);
+            entry.Data = bytes;
+            entry.Bytes = bytes.size();
+        } else {
+            entry.SoundEffect = Mix_LoadWAV_RW(SDL_RWFromConstMem(bytes.data(), static_cast<int>(bytes.size())), 1);
+            if (!entry.SoundEffect) {
+                m_Logger->error("Couldn't decode sound effect {}: {}", def.Key, Mix_GetError());
+                return Error(Error::Sdl, "Couldn't decode a sound effect");
+            }
+            entry.Bytes = entry.SoundEffect->alen;
+        }
+        break;
+    }
+
+    case game::ResourceType::Font: {
+        entry.Font = TTF_OpenFontRW(SDL_RWFromConstMem(bytes.data(), static_cast<int>(bytes.size())), 1, TextRenderer::DefaultSize);
+        if (!entry.Font) {
+            m_Logger->error("Couldn't open font {}: {}", def.Key, TTF_GetError());
+            return Error(Error::Sdl, "Couldn't open a font");
+        }
+        entry.Source = std::move(owner);
+        entry.Data = bytes;
+        entry.Bytes = bytes.size();
+        break;
+    }
+
+    case game::ResourceType::Text:
+        entry.Text.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        entry.Bytes = entry.Text.size();
+        break;
+
+    case game::ResourceType::Animation:
+        entry.Bytes = bytes.size();
+        entry.Source = std::move(owner);
+        entry.Data = bytes;
+        break;
+    }
+
+    MarkResident(entry);
+    return Result();
+}
+
+Result<SDL_Surface*> ResourceManager::DecodeSprite(const ResourceEntry& entry, const std::span<const std::byte> bytes, const Uint32 format) const
+{
+    ENG_TRACE_ZONE("ResourceManager::DecodeSprite");
+
+    SDL_Surface* surface = IMG_Load_RW(SDL_RWFromConstMem(bytes.data(), static_cast<int>(bytes.size())), 1);
+    if (!surface) {
+        m_Logger->error("Couldn't decode sprite {}: {}", entry.Def.Key, IMG_GetError());
+        return Error(Error::Sdl, "Couldn't decode a sprite");
+    }
+
+    if (surface->format->format != format) {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+        SDL_FreeSurface(surface);
+        if (!converted) {
+            m_Logger->error("Couldn't convert sprite {}: {}", entry.Def.Key, SDL_GetError());
+            return Error(Error::Sdl, "Couldn't convert a sprite");
+        }
+        surface = converted;
+    }
+
+    return Result(surface);
+}
+
+Result<> ResourceManager::LoadSprite(ResourceEntry& entry, SDL_Surface* surface)
+{
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(m_Renderer, surface);
+    if (!texture) {
+        m_Logger->error("Couldn't create a texture for sprite {}: {}", entry.Def.Key, SDL_GetError());
+        return Error(Error::Sdl, "Couldn't create a texture");
+    }
+
+    if (auto* mirror = m_Uploads->GetMirror())
+        mirror->Add(texture, *surface);
+    AdoptTexture(entry, texture, *surface);
+    return Result();
+}
+
+void ResourceManager::AdoptTexture(ResourceEntry& entry, SDL_Texture* texture, const SDL_Surface& surface)
+{
+    entry.Texture = texture;
+    entry.SourceRect = SDL_Rect { 0, 0, surface.w, surface.h };
+    entry.Bytes = static_cast<size_t>(surface.w) * surface.h * 4;
+    MarkResident(entry);
+}
+
+void ResourceManager::Stream(ResourceEntry& entry)
+{
+    entry.Streaming = true;
+    entry.Decode = m_Tasks->Run([this, &entry] {
+        ENG_TRACE_ZONE("Streaming a sprite");
+
+        BinaryBuffer owner;
+        std::span<const std::byte> bytes;
+        if (m_Pack) {
+            if (auto packed = FindPacked(entry); packed.IsOk())
+                bytes = packed.Unwrap();
+        } else if (auto source = BinaryBuffer::FromFile(m_Root / entry.Def.Source); source.IsOk()) {
+            owner = source.UnwrapMove();
+            bytes = owner.GetBytes();
+        } else {
+            m_Logger->error("Couldn't read resource {}: {}", entry.Def.Key, source.UnwrapErr().ToString());
+        }
+
+        SDL_Surface* surface = nullptr;
+        if (!bytes.empty()) {
+            if (auto decoded = DecodeSprite(entry, bytes, m_TextureFormat); decoded.IsOk())
+                surface = decoded.Unwrap();
+        }
+
+        m_Uploads->Push(&entry, surface, [this, &entry](SDL_Texture* texture, const SDL_Surface* uploaded) {
+            FinishStreaming(entry, texture, uploaded);
+        });
+    });
+}
+
+void ResourceManager::FinishStreaming(ResourceEntry& entry, SDL_Texture* texture, const SDL_Surface* surface)
+{
+    entry.Streaming = false;
+    entry.Decode = TaskHandle();
+
+    if (!texture) {
+        // A failed decode was reported by the worker.
+        if (surface)
+            m_Logger->error("Couldn't create a texture for sprite {}: {}", entry.Def.Key, SDL_GetError());
+        return;
+    }
+
+    AdoptTexture(entry, texture, *surface);
+    EnforceBudget();
+}
+
+void ResourceManager::MarkResident(ResourceEntry& entry)
+{
+    entry.Resident = true;
+    m_ResidentBytes += entry.Bytes;
+    m_ResidentCount++;
+
+    if (entry.RefCount == 0 && !entry.Pinned) {
+        m_Lru.push_front(&entry);
+        entry.LruPosition = m_Lru.begin();
+        entry.InLru = true;
+    }
+
+    m_Logger->trace("Loaded resource {} ({} bytes)", entry.Def.Key, entry.Bytes);
+}
+
+void ResourceManager::Unload(ResourceEntry& entry)
+{
+    // Atlas pages belong to the atlas.
+    if (entry.Texture && !entry.Pinned) {
+        if (auto* mirror = m_Uploads->GetMirror())
+            mirror->Remove(entry.Texture);
+        SDL_DestroyTexture(entry.Texture);
+    }
+    if (entry.Music)
+        Mix_FreeMusic(entry.Music);
+    if (entry.SoundEffect)
+        Mix_FreeChunk(entry.SoundEffect);
+    if (entry.Font)
+        TTF_CloseFont(entry.Font);
+
+    entry.Texture = nullptr;
+    entry.SourceRect = SDL_Rect {};
+    entry.Music = nullptr;
+    entry.SoundEffect = nullptr;
+    entry.Font = nullptr;
+    entry.Source = BinaryBuffer();
+    entry.Data = {};
+    entry.Text = std::string();
+
+    if (entry.InLru) {
+        m_Lru.erase(entry.LruPosition);
+        entry.InLru = false;
+    }
+
+    m_ResidentBytes -= entry.Bytes;
+    m_ResidentCount--;
+    entry.Bytes = 0;
+    entry.Resident = false;
+}
+
+void ResourceManager::EnforceBudget()
+{
+    while (m_ResidentBytes > m_BudgetBytes && !m_Lru.empty()) {
+        auto& victim = *m_Lru.back();
+        m_Logger->trace("Evicting resource {} ({} bytes)", victim.Def.Key, victim.Bytes);
+        Unload(victim);
+        m_Evictions++;
+    }
+}
+
+void ResourceManager::AddRef(ResourceEntry& entry)
+{
+    if (entry.RefCount++ == 0 && entry.InLru) {
+        m_Lru.erase(entry.LruPosition);
+        entry.InLru = false;
+    }
+}
+
+void ResourceManager::Release(ResourceEntry& entry)
+{
+    if (--entry.RefCount != 0 || !entry.Resident || entry.Pinned)
+        return;
+
+    m_Lru.push_front(&entry);
+    entry.LruPosition = m_Lru.begin();
+    entry.InLru = true;
+
+    EnforceBudget();
+}
+
+} // namespace engine
@@ -0,0 +1,220 @@
+#ifndef ENG_RESOURCE_MANAGER_HPP
+#define ENG_RESOURCE_MANAGER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_stdinc.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include <spdlog/logger.h>
+
+#include "Atlas.hpp"
+#include "BinaryBuffer.hpp"
+#include "Config.hpp"
+#include "Game.hpp"
+#include "Pack.hpp"
+#include "Result.hpp"
+#include "Task.hpp"
+#include "TextureUpload.hpp"
+
+namespace engine {
+
+class ResourceManager;
+
+struct ResourceEntry {
+    game::ResourceDef Def;
+    ResourceManager* Manager = nullptr;
+
+    bool Resident = false;
+    // Pinned entries are never evicted. Sprites packed into the atlas are,
+    // as their texture is shared.
+    bool Pinned = false;
+    // A streamed sprite being decoded or waiting for its upload.
+    bool Streaming = false;
+    TaskHandle Decode;
+    uint32_t RefCount = 0;
+    // Approximate memory used while resident.
+    size_t Bytes = 0;
+
+    // Music and fonts are streamed from their data, so it's kept alive for
+    // them. Animations are kept as raw data. `Data` points either into
+    // `Source` or into the game's pack.
+    BinaryBuffer Source;
+    std::span<const std::byte> Data;
+    std::string Text;
+    SDL_Texture* Texture = nullptr;
+    // Where the sprite lies within `Texture`.
+    SDL_Rect SourceRect {};
+    Mix_Music* Music = nullptr;
+    Mix_Chunk* SoundEffect = nullptr;
+    TTF_Font* Font = nullptr;
+
+    // Position in the manager's LRU list while resident and unreferenced.
+    std::list<ResourceEntry*>::iterator LruPosition;
+    bool InLru = false;
+};
+
+// A counted reference to a loaded resource. Resident resources can only be
+// evicted once no handle refers to them. Handles must not outlive their
+// manager.
+class ResourceHandle final {
+public:
+    ResourceHandle() = default;
+    explicit ResourceHandle(ResourceEntry* entry);
+    ResourceHandle(const ResourceHandle& other);
+    ResourceHandle(ResourceHandle&& other) noexcept;
+    ResourceHandle& operator=(ResourceHandle other) noexcept;
+    ~ResourceHandle();
+
+    inline bool IsValid() const { return m_Entry != nullptr; }
+
+    game::ResourceType GetType() const;
+    const std::string& GetKey() const;
+    // Whether the resource is still being decoded or uploaded after a
+    // `ResourceManager::Request`.
+    bool IsStreaming() const;
+
+    // Return null if the resource is of another type.
+    SDL_Texture* GetTexture() const;
+    SDL_Rect GetSourceRect() const;
+    Mix_Music* GetMusic() const;
+    Mix_Chunk* GetSoundEffect() const;
+    TTF_Font* GetFont() const;
+    const std::string* GetText() const;
+    std::span<const std::byte> GetData() const;
+
+private:
+    ResourceEntry* m_Entry = nullptr;
+};
+
+struct ResourceStats {
+    uint64_t Hits;
+    uint64_t Misses;
+    uint64_t Evictions;
+    size_t ResidentCount;
+    size_t ResidentBytes;
+    size_t BudgetBytes;
+    size_t AtlasPages;
+    size_t AtlasSprites;
+    double AtlasOccupancy;
+};
+
+// Owns every resource of the loaded game. Eager resources are decoded with
+// the game, lazy ones on first `Get`. Resources are read from the game folder
+// or, if one is given, straight out of the game's pack. When the resident size goes over the
+// budget, unreferenced resources are evicted least recently used first and
+// transparently reloaded if requested again.
+//
+// Creates SDL textures, so it must only be used on the main thread.
+class ResourceManager final {
+public:
+    ResourceManager(
+        const std::shared_ptr<spdlog::logger> logger,
+        SDL_Renderer* renderer,
+        const std::filesystem::path& root,
+        const std::shared_ptr<Pack> pack,
+        const std::shared_ptr<TaskDispatcher> tasks,
+        TextureUploadQueue& uploads,
+        const size_t budgetBytes,
+        const int atlasPageSize,
+        const int atlasPadding
+    );
+    ~ResourceManager();
+
+    ResourceManager(const ResourceManager&) = delete;
+    ResourceManager& operator=(const ResourceManager&) = delete;
+
+    static Result<std::shared_ptr<ResourceManager>> New(
+        const std::shared_ptr<spdlog::logger> logger,
+        SDL_Renderer* renderer,
+        const std::filesystem::path& root,
+        const std::shared_ptr<Pack> pack,
+        const std::shared_ptr<TaskDispatcher> tasks,
+        TextureUploadQueue& uploads,
+        const game::ResourceTable& table,
+        const Config& cfg
+    );
+
+    // Decodes the eager resources from their already read sources, indexed
+    // like the resource table passed to `New`. With a pack the sources are
+    // ignored, the resources are read from the pack instead. Eager sprites
+    // are packed into the atlas. Sprites are decoded on the task workers.
+    Result<> LoadEager(std::vector<BinaryBuffer>&& sources);
+
+    // Loads the resource if it isn't resident. A sprite still streaming in
+    // is finished right away.
+    Result<ResourceHandle> Get(const std::string_view key);
+    // Like `Get`, but a sprite that isn't resident is decoded on a task
+    // worker and turned into a texture within the rendering engine's upload
+    // budget. Its texture stays null until then. Other resources are loaded
+    // right away.
+    Result<ResourceHandle> Request(const std::string_view key);
+
+    ResourceStats GetStats() const;
+
+private:
+    const std::shared_ptr<spdlog::logger> m_Logger;
+    SDL_Renderer* m_Renderer;
+    const std::filesystem::path m_Root;
+    const std::shared_ptr<Pack> m_Pack;
+    const std::shared_ptr<TaskDispatcher> m_Tasks;
+    TextureUploadQueue* m_Uploads;
+    // The renderer's preferred texture format, which sprites are converted
+    // to while decoding so creating their texture is a plain copy.
+    Uint32 m_TextureFormat;
+    const size_t m_BudgetBytes;
+    const int m_AtlasPageSize;
+    const int m_AtlasPadding;
+
+    std::unordered_map<std::string, ResourceEntry> m_Entries;
+    // Keys in resource table order.
+    std::vector<std::string> m_Order;
+    // Resident, unreferenced entries. Most recently used first.
+    std::list<ResourceEntry*> m_Lru;
+    // Destroyed after the entries are unloaded.
+    Atlas m_Atlas;
+
+    uint64_t m_Hits;
+    uint64_t m_Misses;
+    uint64_t m_Evictions;
+    size_t m_ResidentBytes;
+    size_t m_ResidentCount;
+
+    Result<std::span<const std::byte>> FindPacked(const ResourceEntry& entry) const;
+    // Reads the entry from the pack or the game folder and loads it.
+    Result<> Read(ResourceEntry& entry);
+    // Decodes to `format`. Thread safe.
+    Result<SDL_Surface*> DecodeSprite(const ResourceEntry& entry, const std::span<const std::byte> bytes, const Uint32 format) const;
+    // Gives the sprite its own texture. Doesn't free `surface`.
+    Result<> LoadSprite(ResourceEntry& entry, SDL_Surface* surface);
+    void AdoptTexture(ResourceEntry& entry, SDL_Texture* texture, const SDL_Surface& surface);
+    void Stream(ResourceEntry& entry);
+    void FinishStreaming(ResourceEntry& entry, SDL_Texture* texture, const SDL_Surface* surface);
+    ResourceEntry* Find(const std::string_view key);
+    // `owner` is moved into the entry if its data has to be kept, `bytes`
+    // must point into it or into the pack.
+    Result<> Load(ResourceEntry& entry, const std::span<const std::byte> bytes, BinaryBuffer&& owner);
+    void MarkResident(ResourceEntry& entry);
+    void Unload(ResourceEntry& entry);
+    void EnforceBudget();
+
+    void AddRef(ResourceEntry& entry);
+    void Release(ResourceEntry& entry);
+
+    friend class ResourceHandle;
+};
+
+} // namespace engine
+
+#endif // !ENG_RESOURCE_MANAGER_HPP
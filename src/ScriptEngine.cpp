@@ -1,7 +1,14 @@
 #include "ScriptEngine.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <string_view>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <atomic>
 #include <memory>
@@ -9,17 +16,77 @@
 
 #include <sol/state.hpp>
 #include <sol/error.hpp>
+#include <sol/optional.hpp>
+#include <sol/table.hpp>
 
 #include "Panic.hpp"
+#include "Policies.hpp"
 #include "Result.hpp"
+#include "Camera.hpp"
+#include "CollissionSystem.hpp"
+#include "LuaInterop.hpp"
+#include "StringInterner.hpp"
 #include "Constants.hpp"
+#include "RenderQueue.hpp"
+#include "TextRenderer.hpp"
+#include "Tilemap.hpp"
+#include "Trace.hpp"
+#include "Vector2.hpp"
 
 namespace engine {
 
+namespace {
+
+    // Anything that isn't a packed id, like a negative or fractional number,
+    // gives an id no entity has.
+    EntityId ToEntityId(const double number)
+    {
+        constexpr double MaxPacked = static_cast<double>(uint64_t(1) << (32 + EntityId::GenerationBits));
+        if (!(number >= 0.0 && number < MaxPacked) || number != std::floor(number))
+            return InvalidEntity;
+        return EntityId::Unpack(static_cast<uint64_t>(number));
+    }
+
+    double ToLuaNumber(const EntityId id)
+    {
+        return static_cast<double>(id.Pack());
+    }
+
+    unsigned int ToSize(const double size)
+    {
+        return static_cast<unsigned int>(std::max(size, 0.0));
+    }
+
+    Vector2 ToWorldPosition(const double x, const double y)
+    {
+        return Vector2(
+            static_cast<unsigned int>(std::max(x, 0.0)),
+            static_cast<unsigned int>(std::max(y, 0.0))
+        );
+    }
+
+    // Anything that isn't a tile number, like a negative one, clears the
+    // tile.
+    TileId ToTileId(const double number)
+    {
+        if (!(number >= 1.0 && number <= std::numeric_limits<TileId>::max()))
+            return EmptyTile;
+        return static_cast<TileId>(number);
+    }
+
+} // namespace
+
 ScriptEngine::ScriptEngine(sol::state&& lua, std::shared_ptr<spdlog::logger> logger, std::shared_ptr<std::atomic<bool>> engineRunningRef)
     : m_Logger(logger)
     , m_EngineRunning(engineRunningRef)
     , m_Lua(std::move(lua))
+    , m_Sprites()
+    , m_LazySprites()
+    , m_Fonts()
+    , m_DrawFrame(nullptr)
+    , m_Camera(nullptr)
+    , m_Entities(nullptr)
+    , m_TileLayers(nullptr)
 {
 }
 
@@ -27,6 +94,8 @@ Result<> ScriptEngine::LoadLibs()
 {
     namespace fs = std::filesystem;
 
+    ENG_TRACE_ZONE("ScriptEngine::LoadLibs");
+
     m_Logger->trace("Loading Lua libraries in {}", constants::RuntimeLibLuaDirPath);
 
     if (!std::filesystem::exists(constants::RuntimeLibLuaDirPath)) {
@@ -62,6 +131,9 @@ Result<> ScriptEngine::LoadLibs()
 
 Result<> ScriptEngine::InitGlobals()
 {
+    if (auto res = luaInterop::Register(m_Lua); !res)
+        return res;
+
     m_Lua.set_function("debug", [this](std::string msg){
         m_Logger->info("[lua-dbg]  {}", msg);
     });
@@ -78,6 +150,272 @@ Result<> ScriptEngine::InitGlobals()
         m_Logger->info("[lua-sys]  Quitting");
         m_EngineRunning->store(false);
     });
+    // draw_sprite(key, x, y[, layer[, depth]]): in screen space, unaffected
+    // by the camera. The depth defaults to the sprite's bottom edge, y-sorting
+    // it with the entities. Lazy sprites are streamed in on first draw.
+    m_Lua.set_function("draw_sprite", [this](std::string_view key, float x, float y, sol::optional<int> layer, sol::optional<double> depth){
+        if (!m_DrawFrame) {
+            m_Logger->warn("[lua-sys]  draw_sprite called outside of draw");
+            return;
+        }
+        const auto sprite = m_Sprites.find(key);
+        if (sprite == m_Sprites.end()) {
+            // Skipped until it's streamed in.
+            if (m_LazySprites.contains(key)) {
+                auto& requests = m_DrawFrame->SpriteRequests;
+                if (std::find(requests.begin(), requests.end(), key) == requests.end())
+                    requests.emplace_back(key);
+                return;
+            }
+            m_Logger->warn("[lua-sys]  Unknown sprite {}", key);
+            return;
+        }
+
+        const auto& source = sprite->second.Source;
+        const SDL_FRect destination { x, y, static_cast<float>(source.w), static_cast<float>(source.h) };
+        m_DrawFrame->Commands.Submit(
+            static_cast<uint8_t>(std::clamp(layer.value_or(renderKey::DefaultLayer), 0, 255)),
+            renderKey::ClampDepth(depth.value_or(destination.y + destination.h)),
+            sprite->second.Texture,
+            source,
+            destination
+        );
+    });
+    // draw_text(font, text, x, y[, size[, layer]]): in screen space, white.
+    m_Lua.set_function("draw_text", [this](std::string_view key, std::string text, float x, float y, sol::optional<int> size, sol::optional<int> layer){
+        if (!m_DrawFrame) {
+            m_Logger->warn("[lua-sys]  draw_text called outside of draw");
+            return;
+        }
+        const auto font = m_Fonts.find(key);
+        if (font == m_Fonts.end()) {
+            m_Logger->warn("[lua-sys]  Unknown font {}", key);
+            return;
+        }
+
+        m_DrawFrame->Texts.push_back(TextCommand {
+            .Font = font->second,
+            .Size = std::clamp(size.value_or(TextRenderer::DefaultSize), 1, TextRenderer::MaxSize),
+            .Text = std::move(text),
+            .X = x,
+            .Y = y,
+            .Color = SDL_Color { 255, 255, 255, 255 },
+            .Layer = static_cast<uint8_t>(std::clamp(layer.value_or(TextRenderer::DefaultLayer), 0, 255)),
+        });
+    });
+    // set_camera(x, y[, zoom]): the world position shown at the top left of
+    // the screen.
+    m_Lua.set_function("set_camera", [this](double x, double y, sol::optional<double> zoom){
+        if (!m_Camera) {
+            m_Logger->warn("[lua-sys]  set_camera called without a camera");
+            return;
+        }
+        if (zoom.has_value() && *zoom <= 0.0) {
+            m_Logger->warn("[lua-sys]  The camera zoom must be positive, got {}", *zoom);
+            return;
+        }
+        m_Camera->Position = ToWorldPosition(x, y);
+        if (zoom.has_value())
+            m_Camera->Zoom = static_cast<float>(*zoom);
+    });
+    // spawn_entity(x, y[, sprite[, class]]): an entity at the world position,
+    // drawn with the sprite and of the class if given. Returns its id, or
+    // nil. Ids are never reused, the functions below do nothing once an
+    // entity is despawned.
+    m_Lua.set_function("spawn_entity", [this](double x, double y, sol::optional<std::string_view> key, sol::optional<std::string_view> name) -> sol::optional<double> {
+        if (!m_Entities) {
+            m_Logger->warn("[lua-sys]  spawn_entity called without a scene");
+            return sol::nullopt;
+        }
+        const Vector2 position = ToWorldPosition(x, y);
+        const EntityId id = m_Entities->Create(Transform { .Position = position, .PreviousPosition = position });
+        if (key.has_value()) {
+            const auto sprite = m_Sprites.find(*key);
+            if (sprite != m_Sprites.end())
+                m_Entities->Add(id, sprite->second);
+            else
+                m_Logger->warn("[lua-sys]  Unknown sprite {}", *key);
+        }
+        if (name.has_value())
+            m_Entities->Add(id, EntityClass { .Name = StringInterner::Global().Intern(*name) });
+        return ToLuaNumber(id);
+    });
+    // despawn_entity(id): returns whether the entity was still there.
+    m_Lua.set_function("despawn_entity", [this](double number){
+        const EntityId id = ToEntityId(number);
+        if (!m_Entities || !m_Entities->IsAlive(id))
+            return false;
+        m_Entities->Destroy(id);
+        return true;
+    });
+    m_Lua.set_function("entity_exists", [this](double number){
+        return m_Entities && m_Entities->IsAlive(ToEntityId(number));
+    });
+    // get_entity_position(id): x, y, or nil if the entity is gone.
+    m_Lua.set_function("get_entity_position", [this](double number) -> std::tuple<sol::optional<double>, sol::optional<double>> {
+        const Transform* transform = m_Entities ? m_Entities->Find<Transform>(ToEntityId(number)) : nullptr;
+        if (!transform)
+            return { sol::nullopt, sol::nullopt };
+        return { static_cast<double>(transform->Position.X), static_cast<double>(transform->Position.Y) };
+    });
+    // set_entity_position(id, x, y[, interpolate]): teleports the entity,
+    // unless `interpolate` is true, in which case it's drawn sliding over
+    // from where it was at the start of the tick. Returns false if the
+    // entity is gone.
+    m_Lua.set_function("set_entity_position", [this](double number, double x, double y, sol::optional<bool> interpolate){
+        const EntityId id = ToEntityId(number);
+        Transform* transform = m_Entities ? m_Entities->Find<Transform>(id) : nullptr;
+        if (!transform)
+            return false;
+        transform->Position = ToWorldPosition(x, y);
+        if (!interpolate.value_or(false))
+            transform->PreviousPosition = transform->Position;
+        // Moves its sprite in the culling grid.
+        m_Entities->MarkChanged(id);
+        return true;
+    });
+    // set_entity_rect_collider(id, width, height[, layers[, mask]]),
+    // set_entity_circle_collider(id, radius[, layers[, mask]]): the shape's
+    // top left is at the entity's position. Two entities collide only if
+    // each one's layers are in the other's mask, both bitsets, by default
+    // layer 1 and everything. Return false if the entity is gone.
+    const auto setCollider = [this](const double number, Collission collission, const sol::optional<uint32_t> layers, const sol::optional<uint32_t> mask) {
+        const EntityId id = ToEntityId(number);
+        if (!m_Entities || !m_Entities->IsAlive(id))
+            return false;
+        collission.Layers = layers.value_or(collission.Layers);
+        collission.Mask = mask.value_or(collission.Mask);
+        m_Entities->Add(id, collission);
+        return true;
+    };
+    m_Lua.set_function("set_entity_rect_collider", [setCollider](double number, double width, double height, sol::optional<uint32_t> layers, sol::optional<uint32_t> mask){
+        return setCollider(number, Collission {
+            .RelativePosition = Vector2(),
+            .Type = CollissionType::Rectangular,
+            .Data = { .Rectangular = { .Width = ToSize(width), .Height = ToSize(height) } },
+        }, layers, mask);
+    });
+    m_Lua.set_function("set_entity_circle_collider", [setCollider](double number, double radius, sol::optional<uint32_t> layers, sol::optional<uint32_t> mask){
+        return setCollider(number, Collission {
+            .RelativePosition = Vector2(),
+            .Type = CollissionType::Circular,
+            .Data = { .Circular = { .Radius = ToSize(radius) } },
+        }, layers, mask);
+    });
+    // remove_entity_collider(id): the entity stops colliding, with exit
+    // events for what it touched.
+    m_Lua.set_function("remove_entity_collider", [this](double number){
+        if (m_Entities)
+            m_Entities->Remove<Collission>(ToEntityId(number));
+    });
+    // get_entity_class(id): the class, or nil if the entity has none or is
+    // gone.
+    m_Lua.set_function("get_entity_class", [this](double number) -> sol::optional<std::string_view> {
+        const EntityClass* entityClass = m_Entities ? m_Entities->Find<EntityClass>(ToEntityId(number)) : nullptr;
+        if (!entityClass)
+            return sol::nullopt;
+        return StringInterner::Global().GetString(entityClass->Name);
+    });
+    // set_entity_class(id, class): nil takes the class away. Returns false if
+    // the entity is gone.
+    m_Lua.set_function("set_entity_class", [this](double number, sol::optional<std::string_view> name){
+        const EntityId id = ToEntityId(number);
+        if (!m_Entities || !m_Entities->IsAlive(id))
+            return false;
+        if (name.has_value())
+            m_Entities->Add(id, EntityClass { .Name = StringInterner::Global().Intern(*name) });
+        else
+            m_Entities->Remove<EntityClass>(id);
+        return true;
+    });
+    // find_entities(class): an array of the ids of the entities of the
+    // class, in no particular order.
+    m_Lua.set_function("find_entities", [this](std::string_view name){
+        // A class never interned has no entities, and looking it up mustn't
+        // intern it.
+        const auto symbol = StringInterner::Global().Find(name);
+        const auto ids = (m_Entities && symbol.has_value()) ? m_Entities->GetClass(*symbol) : std::span<const EntityId>();
+
+        sol::table table = m_Lua.create_table(static_cast<int>(ids.size()), 0);
+        for (size_t i = 0; i < ids.size(); i++)
+            table[i + 1] = ToLuaNumber(ids[i]);
+        return table;
+    });
+    // set_tile_layer(index, tileset, tile_width, tile_height, rows[, layer]):
+    // replaces tile layer `index`, counted from 1, or adds one right after
+    // the last. `rows` is an array of arrays of tile numbers, counted from 1
+    // across the tileset sprite and then down, 0 for none. Drawn just below
+    // the sprites by default. Returns whether the layer was set.
+    m_Lua.set_function("set_tile_layer", [this](int index, std::string_view key, int tileWidth, int tileHeight, sol::table rows, sol::optional<int> layer){
+        if (!m_TileLayers) {
+            m_Logger->warn("[lua-sys]  set_tile_layer called without a scene");
+            return false;
+        }
+        if (index < 1 || static_cast<size_t>(index) > m_TileLayers->size() + 1) {
+            m_Logger->warn("[lua-sys]  No tile layer {} to set", index);
+            return false;
+        }
+        if (tileWidth <= 0 || tileHeight <= 0) {
+            m_Logger->warn("[lua-sys]  The tile size must be positive, got {}x{}", tileWidth, tileHeight);
+            return false;
+        }
+        const auto sprite = m_Sprites.find(key);
+        if (sprite == m_Sprites.end()) {
+            m_Logger->warn("[lua-sys]  Unknown sprite {}", key);
+            return false;
+        }
+
+        const int height = static_cast<int>(rows.size());
+        int width = 0;
+        for (int y = 1; y <= height; y++) {
+            if (const sol::optional<sol::table> row = rows[y])
+                width = std::max(width, static_cast<int>(row->size()));
+        }
+
+        const Tileset tileset {
+            .Texture = sprite->second.Texture,
+            .Source = sprite->second.Source,
+            .TileWidth = tileWidth,
+            .TileHeight = tileHeight,
+        };
+        TileLayer tiles(width, height, tileset, static_cast<uint8_t>(std::clamp(layer.value_or(renderKey::DefaultLayer - 1), 0, 255)));
+        for (int y = 1; y <= height; y++) {
+            const sol::optional<sol::table> row = rows[y];
+            if (!row)
+                continue;
+            const int rowWidth = static_cast<int>(row->size());
+            for (int x = 1; x <= rowWidth; x++)
+                tiles.SetTile(x - 1, y - 1, ToTileId((*row)[x].get_or(0.0)));
+        }
+
+        if (static_cast<size_t>(index) > m_TileLayers->size())
+            m_TileLayers->push_back(std::move(tiles));
+        else
+            (*m_TileLayers)[index - 1] = std::move(tiles);
+        return true;
+    });
+    // set_tile(index, x, y, tile): changes a tile of tile layer `index`, 0
+    // clearing it. Out of range tiles are ignored. Returns false if there's
+    // no such layer.
+    m_Lua.set_function("set_tile", [this](int index, int x, int y, double tile){
+        if (!m_TileLayers || index < 1 || static_cast<size_t>(index) > m_TileLayers->size())
+            return false;
+        (*m_TileLayers)[index - 1].SetTile(x, y, ToTileId(tile));
+        return true;
+    });
+    // get_tile(index, x, y): the tile number, 0 for none or out of range.
+    m_Lua.set_function("get_tile", [this](int index, int x, int y){
+        if (!m_TileLayers || index < 1 || static_cast<size_t>(index) > m_TileLayers->size())
+            return 0;
+        return static_cast<int>((*m_TileLayers)[index - 1].GetTile(x, y));
+    });
+#ifdef ENG_TRACE
+    m_Lua.set_function("dump_trace", [this](std::string path){
+        m_Logger->info("[lua-sys]  Writing the trace to {}", path);
+        if (auto res = trace::Dump(path); !res)
+            m_Logger->error("Couldn't write the trace: {}", res.UnwrapErr().ToString());
+    });
+#endif
 
     auto res = LoadLibs();
     if (!res)
@@ -107,6 +445,112 @@ Result<std::shared_ptr<ScriptEngine>> ScriptEngine::New(
     return Result(self);
 }
 
+Result<> ScriptEngine::Update(const double deltaTime)
+{
+    ENG_TRACE_ZONE("ScriptEngine::Update");
+
+    sol::object update = m_Lua["update"];
+    if (update.get_type() != sol::type::function)
+        return Result();
+
+    auto result = update.as<sol::protected_function>()(deltaTime);
+    if (!result.valid()) [[unlikely]] {
+        sol::error err = result;
+        m_Logger->error("Lua update failed: {}", err.what());
+
+        if constexpr (policies::script::CrashOnError)
+            return Error(Error::Lua, err.what());
+    }
+
+    return Result();
+}
+
+Result<> ScriptEngine::Collide(const std::vector<CollissionContact>& events)
+{
+    ENG_TRACE_ZONE("ScriptEngine::Collide");
+
+    if (events.empty())
+        return Result();
+
+    sol::object collide = m_Lua["collide"];
+    if (collide.get_type() != sol::type::function)
+        return Result();
+
+    sol::table batch = m_Lua.create_table(static_cast<int>(events.size()), 0);
+    for (size_t i = 0; i < events.size(); i++) {
+        const auto& event = events[i];
+        batch[i + 1] = luaInterop::CollissionEvent(event.Point.X, event.Point.Y, event.Phase, ToLuaNumber(event.A), ToLuaNumber(event.B));
+    }
+
+    auto result = collide.as<sol::protected_function>()(batch);
+    if (!result.valid()) [[unlikely]] {
+        sol::error err = result;
+        m_Logger->error("Lua collide failed: {}", err.what());
+
+        if constexpr (policies::script::CrashOnError)
+            return Error(Error::Lua, err.what());
+    }
+
+    return Result();
+}
+
+void ScriptEngine::SetSprites(SpriteTable&& sprites)
+{
+    m_Sprites = std::move(sprites);
+}
+
+void ScriptEngine::SetFonts(FontTable&& fonts)
+{
+    m_Fonts = std::move(fonts);
+}
+
+void ScriptEngine::SetLazySprites(SpriteKeySet&& keys)
+{
+    m_LazySprites = std::move(keys);
+}
+
+void ScriptEngine::AddSprite(const std::string& key, const Sprite& sprite)
+{
+    m_Sprites.insert_or_assign(key, sprite);
+}
+
+void ScriptEngine::SetCamera(Camera* camera)
+{
+    m_Camera = camera;
+}
+
+void ScriptEngine::SetEntities(EntityStore* entities)
+{
+    m_Entities = entities;
+}
+
+void ScriptEngine::SetTileLayers(std::vector<TileLayer>* layers)
+{
+    m_TileLayers = layers;
+}
+
+Result<> ScriptEngine::Draw(FrameData& frame)
+{
+    ENG_TRACE_ZONE("ScriptEngine::Draw");
+
+    sol::object draw = m_Lua["draw"];
+    if (draw.get_type() != sol::type::function)
+        return Result();
+
+    m_DrawFrame = &frame;
+    auto result = draw.as<sol::protected_function>()();
+    m_DrawFrame = nullptr;
+
+    if (!result.valid()) [[unlikely]] {
+        sol::error err = result;
+        m_Logger->error("Lua draw failed: {}", err.what());
+
+        if constexpr (policies::script::CrashOnError)
+            return Error(Error::Lua, err.what());
+    }
+
+    return Result();
+}
 
 Result<> ScriptEngine::Execute(const std::string_view source)
 {
@@ -121,6 +565,8 @@ Result<> ScriptEngine::Execute(const std::string_view source)
 
 Result<> ScriptEngine::ExecuteFile(const std::string_view path)
 {
+    ENG_TRACE_ZONE("ScriptEngine::ExecuteFile");
+
     auto result = m_Lua.script_file(path.data());
     if (result.valid())
         return Result();
@@ -2,24 +2,53 @@
 #define ENG_SCRIPT_ENGINE_HPP
 
 #include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <sol/sol.hpp>
 #include <spdlog/logger.h>
 #include <sol/state.hpp>
 
+#include "Camera.hpp"
+#include "CollissionSystem.hpp"
+#include "EntityStore.hpp"
 #include "EventEngine.hpp"
+#include "FrameData.hpp"
+#include "RenderQueue.hpp"
 #include "Result.hpp"
+#include "Scene.hpp"
+#include "Tilemap.hpp"
+#include "Util.hpp"
 
 namespace engine {
 
+// Sprites scripts can draw, by resource key.
+using SpriteTable = std::unordered_map<std::string, Sprite, util::StringHash, std::equal_to<>>;
+// Fonts scripts can draw text with, by resource key.
+using FontTable = std::unordered_map<std::string, TTF_Font*, util::StringHash, std::equal_to<>>;
+// Keys of the lazy sprites.
+using SpriteKeySet = std::unordered_set<std::string, util::StringHash, std::equal_to<>>;
+
 class ScriptEngine {
 private:
     std::shared_ptr<spdlog::logger> m_Logger;
     std::shared_ptr<std::atomic<bool>> m_EngineRunning;
     std::shared_ptr<EventEngine> m_Script;
     sol::state m_Lua;
+    SpriteTable m_Sprites;
+    // Not drawable until they're streamed in and added to `m_Sprites`.
+    SpriteKeySet m_LazySprites;
+    FontTable m_Fonts;
+    // Only set while the game's `draw` function runs.
+    FrameData* m_DrawFrame;
+    Camera* m_Camera;
+    EntityStore* m_Entities;
+    std::vector<TileLayer>* m_TileLayers;
 
     Result<> InitGlobals();
     Result<> LoadLibs();
@@ -30,6 +59,37 @@ public:
 
     static Result<std::shared_ptr<ScriptEngine>> New(std::shared_ptr<spdlog::logger> logger, std::shared_ptr<std::atomic<bool>> engineRunningFlagRef);
 
+    // Runs one simulation tick by calling the game's global `update`
+    // function, if it defines one.
+    Result<> Update(const double deltaTime);
+    // Hands a tick's collission events to the game's global `collide`
+    // function, if it defines one, in a single call with an array of
+    // `CollissionEvent`s.
+    Result<> Collide(const std::vector<CollissionContact>& events);
+
+    // The sprites and fonts must stay alive for as long as the script
+    // engine can draw them.
+    void SetSprites(SpriteTable&& sprites);
+    void SetFonts(FontTable&& fonts);
+    // Drawing one of the lazy sprites before it's added asks for it through
+    // the frame's `SpriteRequests` instead.
+    void SetLazySprites(SpriteKeySet&& keys);
+    // Makes a lazy sprite drawable once it's streamed in. Must not be called
+    // while the game's scripts run.
+    void AddSprite(const std::string& key, const Sprite& sprite);
+    // Lets scripts move `camera` through `set_camera`. It must outlive the
+    // script engine, or be reset to null.
+    void SetCamera(Camera* camera);
+    // Lets scripts spawn, move and despawn entities in `entities`. Ids reach
+    // Lua as numbers. The same lifetime rules as the camera's apply.
+    void SetEntities(EntityStore* entities);
+    // Lets scripts set the tiles of `layers`, tile coordinates counting from
+    // 0 and layers from 1. The same lifetime rules as the camera's apply.
+    void SetTileLayers(std::vector<TileLayer>* layers);
+    // Calls the game's global `draw` function, if it defines one, which
+    // adds to `frame` through `draw_sprite` and `draw_text`.
+    Result<> Draw(FrameData& frame);
+
     Result<> Execute(const std::string_view source);
     Result<> ExecuteFile(const std::string_view path);
 };
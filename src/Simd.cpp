@@ -0,0 +1,56 @@
+#include "Simd.hpp"
+
+#include <string_view>
+
+#include <SDL2/SDL_cpuinfo.h>
+#include <SDL2/SDL_stdinc.h>
+
+namespace engine {
+namespace simd {
+
+namespace {
+
+    Level Detect()
+    {
+#ifdef ENG_SIMD_X86
+        Level level = SDL_HasAVX2() == SDL_TRUE ? Level::Avx2
+            : SDL_HasSSE2() == SDL_TRUE        ? Level::Sse2
+                                               : Level::Scalar;
+#else
+        Level level = Level::Scalar;
+#endif
+
+        const char* requested = SDL_getenv("ENG_SIMD");
+        if (!requested)
+            return level;
+
+        const std::string_view name(requested);
+        const Level cap = name == "scalar" ? Level::Scalar
+            : name == "sse2"              ? Level::Sse2
+                                          : Level::Avx2;
+        return cap < level ? cap : level;
+    }
+
+} // namespace
+
+Level GetLevel()
+{
+    static const Level level = Detect();
+    return level;
+}
+
+std::string_view ToString(const Level level)
+{
+    switch (level) {
+    case Level::Scalar:
+        return "scalar";
+    case Level::Sse2:
+        return "SSE2";
+    case Level::Avx2:
+        return "AVX2";
+    }
+    return "unknown";
+}
+
+} // namespace simd
+} // namespace engine
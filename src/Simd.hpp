@@ -0,0 +1,36 @@
+#ifndef ENG_SIMD_HPP
+#define ENG_SIMD_HPP
+
+#include <string_view>
+
+// Kernels for newer instruction sets are compiled per function, so the rest
+// of the build doesn't require them, and picked at run time. SSE2 is only
+// assumed where it is baseline, so 32-bit x86 stays on the scalar kernels.
+#if defined(__x86_64__) || defined(_M_X64)
+#define ENG_SIMD_X86 1
+#if defined(__GNUC__) || defined(__clang__)
+#define ENG_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ENG_TARGET_AVX2
+#endif
+#endif
+
+namespace engine {
+namespace simd {
+
+    enum class Level {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // The best level the CPU supports, unless the `ENG_SIMD` environment
+    // variable asks for a lower one ("scalar", "sse2" or "avx2"), e.g. to
+    // compare the kernels. Detected once.
+    Level GetLevel();
+    std::string_view ToString(const Level level);
+
+} // namespace simd
+} // namespace engine
+
+#endif // !ENG_SIMD_HPP
@@ -0,0 +1,247 @@
+#include "SoftwareRasterizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+
+#include <SDL2/SDL_rect.h>
+
+#include "RasterKernels.hpp"
+#include "RenderQueue.hpp"
+#include "Simd.hpp"
+#include "Task.hpp"
+#include "TextureMirror.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+namespace {
+
+    constexpr uint32_t Black = 0xff000000u;
+    // Tiles drawn per task.
+    constexpr size_t TileGrain = 4;
+
+    uint32_t ToArgb(const SDL_Color color)
+    {
+        return static_cast<uint32_t>(color.a) << 24
+            | static_cast<uint32_t>(color.r) << 16
+            | static_cast<uint32_t>(color.g) << 8
+            | static_cast<uint32_t>(color.b);
+    }
+
+    raster::BlendRow GetRow(const raster::Kernels& kernels, const BlendMode blend)
+    {
+        switch (blend) {
+        case BlendMode::Blend:
+            return kernels.Blend;
+        case BlendMode::Add:
+            return kernels.Add;
+        case BlendMode::Modulate:
+            return kernels.Modulate;
+        case BlendMode::None:
+            return kernels.Copy;
+        }
+        return kernels.Blend;
+    }
+
+    // First pixel whose center lies at or after `edge`.
+    int FirstCovered(const float edge)
+    {
+        return static_cast<int>(std::ceil(edge - 0.5f));
+    }
+
+} // namespace
+
+SoftwareRasterizer::SoftwareRasterizer(const TextureMirror& mirror, const simd::Level level)
+    : m_Mirror(mirror)
+    , m_Kernels(&raster::GetKernels(level))
+    , m_Width(0)
+    , m_Height(0)
+    , m_TileColumns(0)
+    , m_TileRows(0)
+    , m_Pixels()
+    , m_Prepared()
+    , m_Bins()
+    , m_Stats()
+{
+}
+
+void SoftwareRasterizer::Resize(const int width, const int height)
+{
+    m_Width = std::max(width, 0);
+    m_Height = std::max(height, 0);
+    m_TileColumns = (m_Width + TileSize - 1) / TileSize;
+    m_TileRows = (m_Height + TileSize - 1) / TileSize;
+    m_Pixels.assign(static_cast<size_t>(m_Width) * m_Height, Black);
+    m_Bins.resize(static_cast<size_t>(m_TileColumns) * m_TileRows);
+}
+
+void SoftwareRasterizer::Draw(const RenderQueue& queue, TaskDispatcher* tasks)
+{
+    ENG_TRACE_ZONE("SoftwareRasterizer::Draw");
+
+    m_Stats = RasterStats();
+    Bin(queue);
+
+    const auto drawTiles = [this](const size_t from, const size_t to) {
+        for (size_t tile = from; tile < to; tile++)
+            DrawTile(tile);
+    };
+    if (tasks)
+        tasks->ParallelFor(0, m_Bins.size(), TileGrain, drawTiles);
+    else
+        drawTiles(0, m_Bins.size());
+}
+
+void SoftwareRasterizer::Bin(const RenderQueue& queue)
+{
+    ENG_TRACE_ZONE("SoftwareRasterizer::Bin");
+
+    for (auto& bin : m_Bins)
+        bin.clear();
+    m_Prepared.clear();
+
+    const SDL_Rect screen { 0, 0, m_Width, m_Height };
+    for (size_t i = 0; i < queue.GetSize(); i++) {
+        const auto& command = queue.GetSorted(i);
+        const MirroredImage* image = m_Mirror.Find(command.Texture);
+        if (!image) {
+            m_Stats.Missing++;
+            continue;
+        }
+
+        SDL_Rect source = command.Source;
+        if (source.w == 0 || source.h == 0)
+            source = SDL_Rect { 0, 0, image->Width, image->Height };
+        const SDL_Rect imageBounds { 0, 0, image->Width, image->Height };
+        SDL_Rect clippedSource;
+        if (SDL_IntersectRect(&source, &imageBounds, &clippedSource) != SDL_TRUE)
+            continue;
+        if (command.Destination.w <= 0.0f || command.Destination.h <= 0.0f)
+            continue;
+
+        const SDL_Rect bounds = GetBounds(command);
+        SDL_Rect visible;
+        if (SDL_IntersectRect(&bounds, &screen, &visible) != SDL_TRUE)
+            continue;
+
+        const float radians = command.Rotation * std::numbers::pi_v<float> / 180.0f;
+        const auto index = static_cast<uint32_t>(m_Prepared.size());
+        m_Prepared.push_back(Prepared {
+            .Image = image,
+            .Source = clippedSource,
+            .Destination = command.Destination,
+            .Bounds = visible,
+            .Tint = ToArgb(command.Color),
+            .Cos = command.Rotation == 0.0f ? 1.0f : std::cos(radians),
+            .Sin = command.Rotation == 0.0f ? 0.0f : std::sin(radians),
+            .Blend = command.Blend,
+        });
+
+        // Commands are visited in key order, so every bin stays sorted.
+        const int firstColumn = visible.x / TileSize;
+        const int lastColumn = (visible.x + visible.w - 1) / TileSize;
+        const int firstRow = visible.y / TileSize;
+        const int lastRow = (visible.y + visible.h - 1) / TileSize;
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int column = firstColumn; column <= lastColumn; column++)
+                m_Bins[static_cast<size_t>(row) * m_TileColumns + column].push_back(index);
+        }
+    }
+
+    for (const auto& bin : m_Bins) {
+        if (bin.empty())
+            continue;
+        m_Stats.Tiles++;
+        m_Stats.Binned += bin.size();
+    }
+}
+
+void SoftwareRasterizer::DrawTile(const size_t tile)
+{
+    const int column = static_cast<int>(tile % m_TileColumns);
+    const int row = static_cast<int>(tile / m_TileColumns);
+    const SDL_Rect rect {
+        column * TileSize,
+        row * TileSize,
+        std::min(TileSize, m_Width - column * TileSize),
+        std::min(TileSize, m_Height - row * TileSize),
+    };
+
+    for (int y = rect.y; y < rect.y + rect.h; y++)
+        m_Kernels->Fill(m_Pixels.data() + static_cast<size_t>(y) * m_Width + rect.x, rect.w, Black);
+
+    for (const uint32_t index : m_Bins[tile]) {
+        const auto& command = m_Prepared[index];
+        SDL_Rect clip;
+        if (SDL_IntersectRect(&command.Bounds, &rect, &clip) == SDL_TRUE)
+            DrawPrepared(command, clip);
+    }
+}
+
+void SoftwareRasterizer::DrawPrepared(const Prepared& command, const SDL_Rect& clip)
+{
+    const raster::BlendRow blend = GetRow(*m_Kernels, command.Blend);
+    const auto& dest = command.Destination;
+    const auto& source = command.Source;
+    const MirroredImage& image = *command.Image;
+    const float scaleX = source.w / dest.w;
+    const float scaleY = source.h / dest.h;
+
+    std::array<uint32_t, TileSize> texels;
+
+    if (command.Sin == 0.0f && command.Cos == 1.0f) {
+        // Texel coordinates in 16.16 fixed point, stepped along the row.
+        const int left = std::max(clip.x, FirstCovered(dest.x));
+        const int right = std::min(clip.x + clip.w, FirstCovered(dest.x + dest.w));
+        const int top = std::max(clip.y, FirstCovered(dest.y));
+        const int bottom = std::min(clip.y + clip.h, FirstCovered(dest.y + dest.h));
+        if (left >= right || top >= bottom)
+            return;
+
+        const auto step = static_cast<int64_t>(scaleX * 65536.0f);
+        const auto start = static_cast<int64_t>((left + 0.5f - dest.x) * scaleX * 65536.0f);
+        for (int y = top; y < bottom; y++) {
+            const int v = std::min(static_cast<int>((y + 0.5f - dest.y) * scaleY), source.h - 1);
+            const uint32_t* texelRow = image.Pixels.data() + static_cast<size_t>(source.y + v) * image.Width + source.x;
+            int64_t u = start;
+            for (int x = left; x < right; x++, u += step)
+                texels[x - left] = texelRow[std::min(static_cast<int>(u >> 16), source.w - 1)];
+            blend(m_Pixels.data() + static_cast<size_t>(y) * m_Width + left, texels.data(), right - left, command.Tint);
+        }
+        return;
+    }
+
+    // Rotated: each pixel center is turned back around the destination's
+    // center, and runs of pixels landing inside it are blended together.
+    const float centerX = dest.x + dest.w * 0.5f;
+    const float centerY = dest.y + dest.h * 0.5f;
+    for (int y = clip.y; y < clip.y + clip.h; y++) {
+        uint32_t* pixels = m_Pixels.data() + static_cast<size_t>(y) * m_Width;
+        const float dy = y + 0.5f - centerY;
+        int run = 0;
+        for (int x = clip.x; x <= clip.x + clip.w; x++) {
+            bool inside = false;
+            if (x < clip.x + clip.w) {
+                const float dx = x + 0.5f - centerX;
+                const float localX = dx * command.Cos + dy * command.Sin + dest.w * 0.5f;
+                const float localY = -dx * command.Sin + dy * command.Cos + dest.h * 0.5f;
+                if (localX >= 0.0f && localX < dest.w && localY >= 0.0f && localY < dest.h) {
+                    const int u = std::min(static_cast<int>(localX * scaleX), source.w - 1);
+                    const int v = std::min(static_cast<int>(localY * scaleY), source.h - 1);
+                    texels[run++] = image.Pixels[static_cast<size_t>(source.y + v) * image.Width + source.x + u];
+                    inside = true;
+                }
+            }
+            if (!inside && run > 0) {
+                blend(pixels + x - run, texels.data(), run, command.Tint);
+                run = 0;
+            }
+        }
+    }
+}
+
+} // namespace engine
@@ -0,0 +1,88 @@
+#ifndef ENG_SOFTWARE_RASTERIZER_HPP
+#define ENG_SOFTWARE_RASTERIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <SDL2/SDL_rect.h>
+
+#include "RasterKernels.hpp"
+#include "RenderQueue.hpp"
+#include "Simd.hpp"
+#include "TextureMirror.hpp"
+
+namespace engine {
+
+class TaskDispatcher;
+
+struct RasterStats {
+    // Tiles with anything to draw, and commands summed over them.
+    size_t Tiles = 0;
+    size_t Binned = 0;
+    // Commands skipped for want of a mirrored texture.
+    size_t Missing = 0;
+};
+
+// Draws render queues on the CPU into an ARGB8888 frame. Commands are binned
+// into `TileSize` squared tiles on the calling thread, then the tiles are
+// drawn in parallel, each one's commands in key order, with the row kernels
+// of the requested SIMD level. Samples the nearest texel and ignores
+// texture scale modes.
+class SoftwareRasterizer final {
+public:
+    static constexpr int TileSize = 64;
+
+    SoftwareRasterizer(const TextureMirror& mirror, const simd::Level level);
+    ~SoftwareRasterizer() = default;
+
+    SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+    SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+    // Clears the frame to black at the new size.
+    void Resize(const int width, const int height);
+    // Draws the sorted `queue` over a black frame. Without `tasks`, the
+    // tiles are drawn on the calling thread.
+    void Draw(const RenderQueue& queue, TaskDispatcher* tasks);
+
+    inline void SetLevel(const simd::Level level) { m_Kernels = &raster::GetKernels(level); }
+    inline simd::Level GetLevel() const { return m_Kernels->Level; }
+    // Rows `GetWidth` pixels apart, opaque.
+    inline const uint32_t* GetPixels() const { return m_Pixels.data(); }
+    inline int GetWidth() const { return m_Width; }
+    inline int GetHeight() const { return m_Height; }
+    inline const RasterStats& GetStats() const { return m_Stats; }
+
+private:
+    // A command with its texture resolved and what it covers on screen.
+    struct Prepared {
+        const MirroredImage* Image;
+        SDL_Rect Source;
+        SDL_FRect Destination;
+        SDL_Rect Bounds;
+        uint32_t Tint;
+        float Cos;
+        float Sin;
+        BlendMode Blend;
+    };
+
+    const TextureMirror& m_Mirror;
+    const raster::Kernels* m_Kernels;
+    int m_Width;
+    int m_Height;
+    int m_TileColumns;
+    int m_TileRows;
+    std::vector<uint32_t> m_Pixels;
+    std::vector<Prepared> m_Prepared;
+    // Indices into `m_Prepared` per tile, row major. Kept between frames.
+    std::vector<std::vector<uint32_t>> m_Bins;
+    RasterStats m_Stats;
+
+    void Bin(const RenderQueue& queue);
+    void DrawTile(const size_t tile);
+    void DrawPrepared(const Prepared& command, const SDL_Rect& clip);
+};
+
+} // namespace engine
+
+#endif // !ENG_SOFTWARE_RASTERIZER_HPP
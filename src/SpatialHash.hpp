@@ -0,0 +1,28 @@
+#ifndef ENG_SPATIAL_HASH_HPP
+#define ENG_SPATIAL_HASH_HPP
+
+#include <cstdint>
+
+namespace engine {
+
+// Cell arithmetic shared by the uniform grids, the culling grid and the
+// collission broad phase, so they agree on which cell a point is in.
+namespace spatialHash {
+
+    // Rounds towards negative infinity, unlike the division operator.
+    constexpr int FloorDiv(const int value, const int divisor)
+    {
+        const int quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+
+    constexpr uint64_t GetCellKey(const int x, const int y)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+} // namespace spatialHash
+
+} // namespace engine
+
+#endif // !ENG_SPATIAL_HASH_HPP
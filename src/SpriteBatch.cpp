@@ -0,0 +1,122 @@
+#include "SpriteBatch.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+
+#include "Trace.hpp"
+
+namespace engine {
+
+SpriteBatch::SpriteBatch(SDL_Renderer* renderer)
+    : m_Renderer(renderer)
+    , m_Texture(nullptr)
+    , m_TextureWidth(0)
+    , m_TextureHeight(0)
+    , m_Vertices()
+    , m_Indices()
+    , m_Stats()
+{
+}
+
+void SpriteBatch::Draw(
+    SDL_Texture* texture,
+    const SDL_Rect& source,
+    const SDL_FRect& destination,
+    const SDL_Color color,
+    const float rotation
+)
+{
+    // Nothing to take the size or the pixels from.
+    if (!texture)
+        return;
+
+    if (texture != m_Texture) {
+        Flush();
+        if (SDL_QueryTexture(texture, nullptr, nullptr, &m_TextureWidth, &m_TextureHeight) != 0 || m_TextureWidth == 0 || m_TextureHeight == 0) {
+            m_Texture = nullptr;
+            return;
+        }
+        m_Texture = texture;
+    }
+
+    float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+    if (source.w != 0 && source.h != 0) {
+        const float invWidth = 1.0f / static_cast<float>(m_TextureWidth);
+        const float invHeight = 1.0f / static_cast<float>(m_TextureHeight);
+        u0 = static_cast<float>(source.x) * invWidth;
+        v0 = static_cast<float>(source.y) * invHeight;
+        u1 = static_cast<float>(source.x + source.w) * invWidth;
+        v1 = static_cast<float>(source.y + source.h) * invHeight;
+    }
+
+    // Corners clockwise from the top left.
+    SDL_FPoint corners[4] = {
+        { destination.x, destination.y },
+        { destination.x + destination.w, destination.y },
+        { destination.x + destination.w, destination.y + destination.h },
+        { destination.x, destination.y + destination.h },
+    };
+
+    if (rotation != 0.0f) {
+        const float radians = rotation * std::numbers::pi_v<float> / 180.0f;
+        const float cos = std::cos(radians);
+        const float sin = std::sin(radians);
+        const float centerX = destination.x + destination.w * 0.5f;
+        const float centerY = destination.y + destination.h * 0.5f;
+        for (auto& corner : corners) {
+            const float x = corner.x - centerX;
+            const float y = corner.y - centerY;
+            corner.x = centerX + x * cos - y * sin;
+            corner.y = centerY + x * sin + y * cos;
+        }
+    }
+
+    m_Vertices.push_back(SDL_Vertex { corners[0], color, { u0, v0 } });
+    m_Vertices.push_back(SDL_Vertex { corners[1], color, { u1, v0 } });
+    m_Vertices.push_back(SDL_Vertex { corners[2], color, { u1, v1 } });
+    m_Vertices.push_back(SDL_Vertex { corners[3], color, { u0, v1 } });
+    m_Stats.Sprites++;
+}
+
+void SpriteBatch::Flush()
+{
+    // The texture may be destroyed once the caller is done drawing, and
+    // another one may later get its address.
+    SDL_Texture* texture = m_Texture;
+    m_Texture = nullptr;
+    if (m_Vertices.empty())
+        return;
+
+    ENG_TRACE_ZONE("SpriteBatch::Flush");
+
+    const size_t quads = m_Vertices.size() / 4;
+    for (size_t quad = m_Indices.size() / 6; quad < quads; quad++) {
+        const int first = static_cast<int>(quad * 4);
+        m_Indices.insert(m_Indices.end(), { first, first + 1, first + 2, first + 2, first + 3, first });
+    }
+
+    SDL_RenderGeometry(
+        m_Renderer,
+        texture,
+        m_Vertices.data(),
+        static_cast<int>(m_Vertices.size()),
+        m_Indices.data(),
+        static_cast<int>(quads * 6)
+    );
+
+    m_Stats.Vertices += m_Vertices.size();
+    m_Stats.DrawCalls++;
+    m_Vertices.clear();
+}
+
+void SpriteBatch::ResetStats()
+{
+    m_Stats = SpriteBatchStats();
+}
+
+} // namespace engine
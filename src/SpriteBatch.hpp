@@ -0,0 +1,66 @@
+#ifndef ENG_SPRITE_BATCH_HPP
+#define ENG_SPRITE_BATCH_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+
+namespace engine {
+
+struct SpriteBatchStats {
+    size_t Sprites = 0;
+    size_t Vertices = 0;
+    size_t DrawCalls = 0;
+};
+
+// Collects textured quads into one vertex and index buffer and draws every
+// run of quads sharing a texture with a single `SDL_RenderGeometry` call.
+// Anything else drawn with the renderer in between has to be preceded by a
+// `Flush`, or it ends up below the queued quads.
+class SpriteBatch final {
+public:
+    static constexpr SDL_Color White { 255, 255, 255, 255 };
+
+    explicit SpriteBatch(SDL_Renderer* renderer);
+    ~SpriteBatch() = default;
+
+    SpriteBatch(const SpriteBatch&) = delete;
+    SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+    // Queues `source` of `texture` stretched over `destination`, tinted by
+    // `color` and rotated by `rotation` degrees clockwise around its center.
+    // A zero sized `source` means the whole texture. Skipped for a null or
+    // unusable texture.
+    void Draw(
+        SDL_Texture* texture,
+        const SDL_Rect& source,
+        const SDL_FRect& destination,
+        const SDL_Color color = White,
+        const float rotation = 0.0f
+    );
+
+    // Draws everything queued so far.
+    void Flush();
+
+    // Starts counting a new frame.
+    void ResetStats();
+    inline const SpriteBatchStats& GetStats() const { return m_Stats; }
+
+private:
+    SDL_Renderer* m_Renderer;
+    SDL_Texture* m_Texture;
+    int m_TextureWidth;
+    int m_TextureHeight;
+    // Kept across flushes so a warmed up batch never allocates.
+    std::vector<SDL_Vertex> m_Vertices;
+    // Two triangles per quad, the same for every batch, so it only grows.
+    std::vector<int> m_Indices;
+    SpriteBatchStats m_Stats;
+};
+
+} // namespace engine
+
+#endif // !ENG_SPRITE_BATCH_HPP
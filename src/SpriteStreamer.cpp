@@ -0,0 +1,87 @@
+#include "SpriteStreamer.hpp"
+
+#include <span>
+#include <string>
+#include <utility>
+
+#include "Components.hpp"
+#include "ResourceManager.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+SpriteStreamer::SpriteStreamer()
+    : m_Entries()
+    , m_Loading(0)
+{
+}
+
+void SpriteStreamer::Request(ResourceManager& resources, const std::span<const std::string> keys)
+{
+    for (const auto& key : keys) {
+        if (m_Entries.contains(key))
+            continue;
+
+        ENG_TRACE_ZONE("SpriteStreamer::Request");
+
+        // Unknown keys are logged by the manager.
+        auto handle = resources.Request(key);
+        if (handle.IsErr()) {
+            m_Entries.emplace(key, Entry { .Handle = ResourceHandle(), .State = EntryState::Failed });
+            continue;
+        }
+        m_Entries.emplace(key, Entry { .Handle = handle.UnwrapMove(), .State = EntryState::Loading });
+        m_Loading++;
+    }
+}
+
+void SpriteStreamer::Collect(const SpriteReadyCallback& onReady)
+{
+    if (m_Loading == 0)
+        return;
+
+    ENG_TRACE_ZONE("SpriteStreamer::Collect");
+
+    for (auto& [key, entry] : m_Entries) {
+        if (entry.State != EntryState::Loading)
+            continue;
+
+        if (entry.Handle.GetTexture()) {
+            entry.State = EntryState::Ready;
+            m_Loading--;
+            onReady(key, Sprite { .Texture = entry.Handle.GetTexture(), .Source = entry.Handle.GetSourceRect() });
+        } else if (!entry.Handle.IsStreaming()) {
+            // The decode or the upload failed, which the manager logged.
+            entry.State = EntryState::Failed;
+            entry.Handle = ResourceHandle();
+            m_Loading--;
+        }
+    }
+}
+
+void SpriteStreamer::Clear()
+{
+    m_Entries.clear();
+    m_Loading = 0;
+}
+
+SpriteStreamerStats SpriteStreamer::GetStats() const
+{
+    SpriteStreamerStats stats;
+    for (const auto& [key, entry] : m_Entries) {
+        switch (entry.State) {
+        case EntryState::Loading:
+            stats.Loading++;
+            break;
+        case EntryState::Ready:
+            stats.Ready++;
+            break;
+        case EntryState::Failed:
+            stats.Failed++;
+            break;
+        }
+    }
+    return stats;
+}
+
+} // namespace engine
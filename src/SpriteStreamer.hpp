@@ -0,0 +1,67 @@
+#ifndef ENG_SPRITE_STREAMER_HPP
+#define ENG_SPRITE_STREAMER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "Components.hpp"
+#include "ResourceManager.hpp"
+#include "Util.hpp"
+
+namespace engine {
+
+// Called with each streamed sprite once it can be drawn.
+using SpriteReadyCallback = std::function<void(const std::string& key, const Sprite& sprite)>;
+
+struct SpriteStreamerStats {
+    size_t Loading = 0;
+    size_t Ready = 0;
+    size_t Failed = 0;
+};
+
+// Lazy sprites asked for before they were loaded. They're requested from the
+// resource manager, which decodes them on the task workers and uploads them
+// within the rendering engine's budget, and reported once they have a
+// texture. Each key is requested once, failed ones aren't retried. Held
+// resident until `Clear`.
+//
+// Main thread only, like the resource manager.
+class SpriteStreamer final {
+public:
+    SpriteStreamer();
+    ~SpriteStreamer() = default;
+
+    // Requests the keys not requested yet.
+    void Request(ResourceManager& resources, const std::span<const std::string> keys);
+    // Reports the sprites uploaded since the last call, so it should follow
+    // the upload queue's `Process`.
+    void Collect(const SpriteReadyCallback& onReady);
+    // Releases every sprite, which has to happen before their resource
+    // manager goes away.
+    void Clear();
+
+    SpriteStreamerStats GetStats() const;
+
+private:
+    enum class EntryState : uint8_t {
+        Loading,
+        Ready,
+        Failed,
+    };
+
+    struct Entry {
+        ResourceHandle Handle;
+        EntryState State;
+    };
+
+    std::unordered_map<std::string, Entry, util::StringHash, std::equal_to<>> m_Entries;
+    size_t m_Loading;
+};
+
+} // namespace engine
+
+#endif // !ENG_SPRITE_STREAMER_HPP
@@ -0,0 +1,65 @@
+#include "StringInterner.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+namespace engine {
+
+StringInterner::StringInterner()
+    : m_Mutex()
+    , m_Strings()
+    , m_Symbols()
+{
+    Intern("");
+}
+
+StringInterner& StringInterner::Global()
+{
+    static StringInterner interner;
+    return interner;
+}
+
+Symbol StringInterner::Intern(const std::string_view string)
+{
+    if (const auto symbol = Find(string))
+        return *symbol;
+
+    std::unique_lock lock(m_Mutex);
+    // Another thread may have interned it since.
+    if (const auto it = m_Symbols.find(string); it != m_Symbols.end())
+        return it->second;
+
+    const auto symbol = static_cast<Symbol>(m_Strings.size());
+    const std::string& stored = m_Strings.emplace_back(string);
+    m_Symbols.emplace(stored, symbol);
+    return symbol;
+}
+
+std::optional<Symbol> StringInterner::Find(const std::string_view string) const
+{
+    std::shared_lock lock(m_Mutex);
+    const auto it = m_Symbols.find(string);
+    if (it == m_Symbols.end())
+        return std::nullopt;
+    return it->second;
+}
+
+std::string_view StringInterner::GetString(const Symbol symbol) const
+{
+    std::shared_lock lock(m_Mutex);
+    if (symbol >= m_Strings.size())
+        return std::string_view();
+    return m_Strings[symbol];
+}
+
+size_t StringInterner::GetSize() const
+{
+    std::shared_lock lock(m_Mutex);
+    return m_Strings.size();
+}
+
+} // namespace engine
@@ -0,0 +1,51 @@
+#ifndef ENG_STRING_INTERNER_HPP
+#define ENG_STRING_INTERNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace engine {
+
+// A string turned into a small number by `StringInterner`. Equal strings
+// get equal symbols, so comparing and hashing them is comparing integers.
+using Symbol = uint32_t;
+// The empty string, interned up front.
+constexpr Symbol EmptySymbol = 0;
+
+// Keeps one copy of every string it's given, for good. Thread safe.
+class StringInterner final {
+public:
+    StringInterner();
+    ~StringInterner() = default;
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    // The one shared by the whole engine, e.g. for entity classes.
+    static StringInterner& Global();
+
+    Symbol Intern(const std::string_view string);
+    // Doesn't intern anything, for lookups that shouldn't grow the table.
+    std::optional<Symbol> Find(const std::string_view string) const;
+    // Valid for as long as the interner lives.
+    std::string_view GetString(const Symbol symbol) const;
+
+    size_t GetSize() const;
+
+private:
+    mutable std::shared_mutex m_Mutex;
+    // A deque, so the strings never move and the views keyed on them stay
+    // valid.
+    std::deque<std::string> m_Strings;
+    std::unordered_map<std::string_view, Symbol> m_Symbols;
+};
+
+} // namespace engine
+
+#endif // !ENG_STRING_INTERNER_HPP
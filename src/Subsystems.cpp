@@ -0,0 +1,208 @@
+#include "Subsystems.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include <spdlog/logger.h>
+
+#include "Clock.hpp"
+#include "Game.hpp"
+#include "Result.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+namespace {
+
+    std::string GetLowercaseExtension(const std::string& source)
+    {
+        auto extension = std::filesystem::path(source).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return extension;
+    }
+
+    int GetImageCodec(const std::string& extension)
+    {
+        if (extension == ".png")
+            return IMG_INIT_PNG;
+        if (extension == ".jpg" || extension == ".jpeg")
+            return IMG_INIT_JPG;
+        if (extension == ".tif" || extension == ".tiff")
+            return IMG_INIT_TIF;
+        if (extension == ".webp")
+            return IMG_INIT_WEBP;
+        // Built into SDL_image (BMP, GIF, TGA, ...).
+        return 0;
+    }
+
+    int GetMusicCodec(const std::string& extension)
+    {
+        if (extension == ".ogg")
+            return MIX_INIT_OGG;
+        if (extension == ".mp3")
+            return MIX_INIT_MP3;
+        if (extension == ".flac")
+            return MIX_INIT_FLAC;
+        if (extension == ".opus")
+            return MIX_INIT_OPUS;
+        if (extension == ".mid" || extension == ".midi")
+            return MIX_INIT_MID;
+        if (extension == ".mod" || extension == ".xm" || extension == ".it" || extension == ".s3m")
+            return MIX_INIT_MOD;
+        // Built into SDL_mixer (WAV, AIFF, VOC).
+        return 0;
+    }
+
+    double GetMillisecondsSince(const Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+} // namespace
+
+SubsystemNeeds SubsystemNeeds::FromResourceTable(const game::ResourceTable& table)
+{
+    SubsystemNeeds needs;
+    for (const auto& res : table.Entries) {
+        switch (res.Type) {
+        case game::ResourceType::Sprite:
+            needs.ImageCodecs |= GetImageCodec(GetLowercaseExtension(res.Source));
+            break;
+        case game::ResourceType::Music:
+        case game::ResourceType::SoundEffect:
+            needs.Audio = true;
+            needs.MusicCodecs |= GetMusicCodec(GetLowercaseExtension(res.Source));
+            break;
+        case game::ResourceType::Font:
+            needs.Fonts = true;
+            break;
+        case game::ResourceType::Text:
+        case game::ResourceType::Animation:
+            break;
+        }
+    }
+    return needs;
+}
+
+Subsystems::Subsystems(const std::shared_ptr<spdlog::logger> logger, const bool headless)
+    : m_Logger(logger)
+    , m_Headless(headless)
+    , m_ImageCodecs(0)
+    , m_Audio(false)
+    , m_MusicCodecs(0)
+    , m_Fonts(false)
+{
+}
+
+Subsystems::~Subsystems()
+{
+    m_Logger->trace("Finalizing Subsystems");
+
+    if (m_Fonts)
+        TTF_Quit();
+    if (m_Audio) {
+        if (Mix_QuerySpec(nullptr, nullptr, nullptr) != 0)
+            Mix_CloseAudio();
+        Mix_Quit();
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+    if (m_ImageCodecs != 0)
+        IMG_Quit();
+}
+
+Result<std::shared_ptr<Subsystems>> Subsystems::New(const std::shared_ptr<spdlog::logger> logger, const Config& cfg)
+{
+    return Result(std::make_shared<Subsystems>(logger, cfg.Headless.Enabled));
+}
+
+Result<> Subsystems::Initialize(const SubsystemNeeds& needs)
+{
+    ENG_TRACE_ZONE("Subsystems::Initialize");
+
+    if ((needs.ImageCodecs & ~m_ImageCodecs) != 0) {
+        if (auto res = InitImage(needs.ImageCodecs); !res)
+            return res;
+    }
+    if (needs.Audio && !m_Headless && (!m_Audio || (needs.MusicCodecs & ~m_MusicCodecs) != 0)) {
+        if (auto res = InitAudio(needs.MusicCodecs); !res)
+            return res;
+    }
+    if (needs.Fonts && !m_Fonts) {
+        if (auto res = InitFonts(); !res)
+            return res;
+    }
+    return Result();
+}
+
+Result<> Subsystems::InitImage(const int codecs)
+{
+    ENG_TRACE_ZONE("Subsystems::InitImage");
+    const auto start = Clock::now();
+
+    const int missing = codecs & ~m_ImageCodecs;
+    if ((IMG_Init(missing) & missing) != missing) {
+        m_Logger->critical("SDL Image init failed: {}", IMG_GetError());
+        return Error(Error::Sdl, "SDL Image init failed");
+    }
+    m_ImageCodecs |= missing;
+
+    m_Logger->debug("Initialized the image codecs in {:.2f} ms", GetMillisecondsSince(start));
+    return Result();
+}
+
+Result<> Subsystems::InitAudio(const int codecs)
+{
+    ENG_TRACE_ZONE("Subsystems::InitAudio");
+    const auto start = Clock::now();
+
+    if (!m_Audio) {
+        if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+            // Not fatal, the game just stays silent.
+            m_Logger->error("Couldn't initialize SDL audio: {}", SDL_GetError());
+            return Result();
+        }
+        m_Audio = true;
+    }
+
+    const int missing = codecs & ~m_MusicCodecs;
+    if (missing != 0 && (Mix_Init(missing) & missing) != missing) {
+        m_Logger->critical("SDL Mixer init failed: {}", Mix_GetError());
+        return Error(Error::Sdl, "SDL Mixer init failed");
+    }
+    m_MusicCodecs |= missing;
+
+    if (Mix_QuerySpec(nullptr, nullptr, nullptr) == 0 && Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 2048) != 0) {
+        // Not fatal either.
+        m_Logger->error("Couldn't open the audio device: {}", Mix_GetError());
+    }
+
+    m_Logger->debug("Initialized audio in {:.2f} ms", GetMillisecondsSince(start));
+    return Result();
+}
+
+Result<> Subsystems::InitFonts()
+{
+    ENG_TRACE_ZONE("Subsystems::InitFonts");
+    const auto start = Clock::now();
+
+    if (TTF_Init() != 0) {
+        m_Logger->critical("SDL TTF init failed: {}", TTF_GetError());
+        return Error(Error::Sdl, "SDL TTF init failed");
+    }
+    m_Fonts = true;
+
+    m_Logger->debug("Initialized fonts in {:.2f} ms", GetMillisecondsSince(start));
+    return Result();
+}
+
+} // namespace engine
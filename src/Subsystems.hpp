@@ -0,0 +1,64 @@
+#ifndef ENG_SUBSYSTEMS_HPP
+#define ENG_SUBSYSTEMS_HPP
+
+#include <memory>
+
+#include <spdlog/logger.h>
+
+#include "Config.hpp"
+#include "Game.hpp"
+#include "Result.hpp"
+
+namespace engine {
+
+// What a game needs beyond the video, event and timer subsystems, which are
+// always up.
+struct SubsystemNeeds {
+    // IMG_INIT_* flags of the image codecs to load.
+    int ImageCodecs = 0;
+    bool Audio = false;
+    // MIX_INIT_* flags of the music codecs to load.
+    int MusicCodecs = 0;
+    bool Fonts = false;
+
+    // Derived from the resource types and source file extensions.
+    static SubsystemNeeds FromResourceTable(const game::ResourceTable& table);
+};
+
+// The optional SDL subsystems and satellite libraries (SDL_image codecs,
+// audio with SDL_mixer, SDL_ttf). Nothing is initialized up front; each
+// piece is brought up once a game needs it, on the main thread: SDL
+// doesn't promise subsystem init is thread safe, and some audio backends
+// need the main thread.
+class Subsystems final {
+public:
+    Subsystems(const std::shared_ptr<spdlog::logger> logger, const bool headless);
+    ~Subsystems();
+
+    Subsystems(const Subsystems&) = delete;
+    Subsystems& operator=(const Subsystems&) = delete;
+
+    static Result<std::shared_ptr<Subsystems>> New(const std::shared_ptr<spdlog::logger> logger, const Config& cfg);
+
+    // Initializes whatever in `needs` isn't up yet. Call it from the main
+    // thread. A missing audio device isn't an error, the game just stays
+    // silent. Audio is never initialized in headless mode.
+    Result<> Initialize(const SubsystemNeeds& needs);
+
+private:
+    const std::shared_ptr<spdlog::logger> m_Logger;
+    const bool m_Headless;
+
+    int m_ImageCodecs;
+    bool m_Audio;
+    int m_MusicCodecs;
+    bool m_Fonts;
+
+    Result<> InitImage(const int codecs);
+    Result<> InitAudio(const int codecs);
+    Result<> InitFonts();
+};
+
+} // namespace engine
+
+#endif // !ENG_SUBSYSTEMS_HPP
@@ -0,0 +1,412 @@
+#include "Task.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <spdlog/logger.h>
+
+#include "Result.hpp"
+#include "Trace.hpp"
+
+namespace engine {
+
+namespace detail {
+
+    namespace {
+
+        // Tasks are recycled through the free list of whichever thread drops
+        // the last reference, so steady-state scheduling doesn't allocate.
+        constexpr size_t MaxPooledTasks = 1024;
+
+        struct TaskPool {
+            std::vector<Task*> Free;
+
+            ~TaskPool()
+            {
+                for (auto task : Free)
+                    delete task;
+            }
+        };
+
+        thread_local TaskPool t_TaskPool;
+
+    } // namespace
+
+    Task* AcquireTask()
+    {
+        auto& pool = t_TaskPool.Free;
+        if (pool.empty())
+            return new Task();
+
+        Task* task = pool.back();
+        pool.pop_back();
+        return task;
+    }
+
+    void ReleaseTask(Task* task)
+    {
+        if (task->RefCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        task->Function.Reset();
+        task->Continuations.clear();
+        task->Done.store(false, std::memory_order_relaxed);
+
+        auto& pool = t_TaskPool.Free;
+        if (pool.size() >= MaxPooledTasks) {
+            delete task;
+            return;
+        }
+        pool.push_back(task);
+    }
+
+} // namespace detail
+
+namespace {
+
+    // Chase-Lev work-stealing deque, following "Correct and Efficient
+    // Work-Stealing for Weak Memory Models" (Lê et al., 2013). Only the owner
+    // calls `Push` and `Pop`, any thread may `Steal`.
+    class WorkStealingDeque final {
+    public:
+        WorkStealingDeque()
+            : m_Top(0)
+            , m_Bottom(0)
+            , m_Array(new Array(256))
+        {
+            m_Retired.emplace_back(m_Array.load(std::memory_order_relaxed));
+        }
+
+        void Push(detail::Task* task)
+        {
+            const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+            const int64_t top = m_Top.load(std::memory_order_acquire);
+            Array* array = m_Array.load(std::memory_order_relaxed);
+
+            if (bottom - top > array->Capacity - 1)
+                array = Grow(array, top, bottom);
+
+            array->Put(bottom, task);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        detail::Task* Pop()
+        {
+            const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+            Array* array = m_Array.load(std::memory_order_relaxed);
+            m_Bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_Top.load(std::memory_order_relaxed);
+
+            if (top > bottom) {
+                m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            detail::Task* task = array->Get(bottom);
+            if (top == bottom) {
+                // Last element, race the thieves for it.
+                if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    task = nullptr;
+                m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return task;
+        }
+
+        detail::Task* Steal()
+        {
+            int64_t top = m_Top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+            if (top >= bottom)
+                return nullptr;
+
+            Array* array = m_Array.load(std::memory_order_acquire);
+            detail::Task* task = array->Get(top);
+            if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return task;
+        }
+
+        inline bool IsEmpty() const
+        {
+            return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Array {
+            const int64_t Capacity;
+            std::unique_ptr<std::atomic<detail::Task*>[]> Items;
+
+            Array(const int64_t capacity)
+                : Capacity(capacity)
+                , Items(new std::atomic<detail::Task*>[capacity])
+            {
+            }
+
+            inline detail::Task* Get(const int64_t i) const
+            {
+                return Items[i & (Capacity - 1)].load(std::memory_order_relaxed);
+            }
+
+            inline void Put(const int64_t i, detail::Task* task)
+            {
+                Items[i & (Capacity - 1)].store(task, std::memory_order_relaxed);
+            }
+        };
+
+        std::atomic<int64_t> m_Top;
+        std::atomic<int64_t> m_Bottom;
+        std::atomic<Array*> m_Array;
+        // Thieves may still be reading an old array after a grow, so they are
+        // kept around until the deque dies.
+        std::vector<std::unique_ptr<Array>> m_Retired;
+
+        Array* Grow(Array* old, const int64_t top, const int64_t bottom)
+        {
+            auto array = new Array(old->Capacity * 2);
+            for (int64_t i = top; i < bottom; i++)
+                array->Put(i, old->Get(i));
+
+            m_Retired.emplace_back(array);
+            m_Array.store(array, std::memory_order_release);
+            return array;
+        }
+    };
+
+    // The worker running on the current thread, if any.
+    thread_local TaskDispatcher* t_Dispatcher = nullptr;
+    thread_local void* t_Worker = nullptr;
+
+} // namespace
+
+struct TaskDispatcher::Worker {
+    unsigned int Index;
+    WorkStealingDeque Queue;
+    // xorshift state for picking steal victims.
+    uint32_t Seed;
+};
+
+TaskDispatcher::TaskDispatcher(const std::shared_ptr<spdlog::logger> logger, const unsigned int workerCount)
+    : m_Logger(logger)
+    , m_Workers()
+    , m_Threads()
+    , m_Stopping(false)
+    , m_Injection()
+    , m_InjectionSize(0)
+    , m_WorkEpoch(0)
+    , m_SleepingCount(0)
+{
+    m_Workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->Index = i;
+        worker->Seed = 0x9E3779B9u * (i + 1);
+        m_Workers.push_back(std::move(worker));
+    }
+}
+
+TaskDispatcher::~TaskDispatcher()
+{
+    m_Logger->trace("Finalizing TaskDispatcher");
+
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Stopping.store(true);
+    }
+    m_SleepCondition.notify_all();
+
+    for (auto& thread : m_Threads)
+        thread.join();
+
+    // Anything still queued never ran; drop the references the queues held.
+    for (auto& worker : m_Workers) {
+        while (auto task = worker->Queue.Pop())
+            detail::ReleaseTask(task);
+    }
+    for (auto task : m_Injection)
+        detail::ReleaseTask(task);
+}
+
+Result<std::shared_ptr<TaskDispatcher>> TaskDispatcher::New(const std::shared_ptr<spdlog::logger> logger, unsigned int workerCount)
+{
+    if (workerCount == 0) {
+        const unsigned int hardwareConcurrency = std::thread::hardware_concurrency();
+        workerCount = std::max(1u, hardwareConcurrency > 1 ? hardwareConcurrency - 1 : 1u);
+    }
+
+    auto self = std::make_shared<TaskDispatcher>(logger, workerCount);
+
+    try {
+        self->m_Threads.reserve(workerCount);
+        for (auto& worker : self->m_Workers) {
+            self->m_Threads.emplace_back(&TaskDispatcher::WorkerMain, self.get(), worker.get());
+        }
+    } catch (const std::system_error& ex) {
+        logger->error("Couldn't start a worker thread: {}", ex.what());
+        return Error(Error::Unknown, "Couldn't start a worker thread");
+    }
+
+    logger->info("Started {} task worker threads", workerCount);
+
+    return Result(self);
+}
+
+void TaskDispatcher::AddDependency(detail::Task* task, detail::Task* dependency)
+{
+    // Count the dependency first so it can't finish and schedule us early.
+    task->Pending.fetch_add(1, std::memory_order_relaxed);
+
+    while (dependency->ContinuationLock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    const bool done = dependency->Done.load(std::memory_order_relaxed);
+    if (!done) {
+        task->RefCount.fetch_add(1, std::memory_order_relaxed);
+        dependency->Continuations.push_back(task);
+    }
+
+    dependency->ContinuationLock.clear(std::memory_order_release);
+
+    if (done)
+        task->Pending.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void TaskDispatcher::Schedule(detail::Task* task)
+{
+    if (t_Dispatcher == this) {
+        static_cast<Worker*>(t_Worker)->Queue.Push(task);
+    } else {
+        std::lock_guard<std::mutex> lock(m_InjectionMutex);
+        m_Injection.push_back(task);
+        m_InjectionSize.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Paired with the sleeping worker re-checking the epoch under the lock.
+    m_WorkEpoch.fetch_add(1, std::memory_order_seq_cst);
+    if (m_SleepingCount.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_SleepCondition.notify_one();
+    }
+}
+
+void TaskDispatcher::Execute(detail::Task* task)
+{
+    task->Function();
+    task->Function.Reset();
+
+    while (task->ContinuationLock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+    task->Done.store(true, std::memory_order_release);
+    std::vector<detail::Task*> continuations = std::move(task->Continuations);
+    task->Continuations.clear();
+    task->ContinuationLock.clear(std::memory_order_release);
+
+    for (auto continuation : continuations) {
+        if (continuation->Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            Schedule(continuation);
+        detail::ReleaseTask(continuation);
+    }
+
+    detail::ReleaseTask(task);
+}
+
+detail::Task* TaskDispatcher::FindWork(Worker* self)
+{
+    if (self) {
+        if (auto task = self->Queue.Pop())
+            return task;
+    }
+
+    if (m_InjectionSize.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(m_InjectionMutex);
+        if (!m_Injection.empty()) {
+            auto task = m_Injection.front();
+            m_Injection.pop_front();
+            m_InjectionSize.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    const size_t workerCount = m_Workers.size();
+    if (workerCount == 0)
+        return nullptr;
+
+    size_t start = 0;
+    if (self) {
+        self->Seed ^= self->Seed << 13;
+        self->Seed ^= self->Seed >> 17;
+        self->Seed ^= self->Seed << 5;
+        start = self->Seed % workerCount;
+    }
+
+    for (size_t i = 0; i < workerCount; i++) {
+        auto& victim = m_Workers[(start + i) % workerCount];
+        if (victim.get() == self)
+            continue;
+        if (auto task = victim->Queue.Steal())
+            return task;
+    }
+
+    return nullptr;
+}
+
+void TaskDispatcher::Wait(const TaskHandle& handle)
+{
+    Worker* self = t_Dispatcher == this ? static_cast<Worker*>(t_Worker) : nullptr;
+
+    while (!handle.IsDone()) {
+        if (auto task = FindWork(self)) {
+            Execute(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TaskDispatcher::WorkerMain(Worker* self)
+{
+    t_Dispatcher = this;
+    t_Worker = self;
+    ENG_TRACE_THREAD_NAME("Task worker");
+
+    constexpr int SpinCount = 64;
+
+    while (!m_Stopping.load(std::memory_order_relaxed)) {
+        const uint64_t epoch = m_WorkEpoch.load(std::memory_order_seq_cst);
+
+        detail::Task* task = nullptr;
+        for (int i = 0; i < SpinCount && !task; i++) {
+            task = FindWork(self);
+            if (!task)
+                std::this_thread::yield();
+        }
+
+        if (task) {
+            ENG_TRACE_ZONE("Task");
+            Execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_SleepingCount.fetch_add(1, std::memory_order_seq_cst);
+        m_SleepCondition.wait(lock, [this, epoch] {
+            return m_Stopping.load(std::memory_order_relaxed) || m_WorkEpoch.load(std::memory_order_seq_cst) != epoch;
+        });
+        m_SleepingCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    t_Dispatcher = nullptr;
+    t_Worker = nullptr;
+}
+
+} // namespace engine
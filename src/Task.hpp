@@ -1,21 +1,264 @@
 #ifndef ENG_TASK_HPP
 #define ENG_TASK_HPP
 
-#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <spdlog/logger.h>
+
+#include "Result.hpp"
 
 namespace engine {
 
-class TaskDispatcher {
+class TaskDispatcher;
+
+// Type-erased `void()` callable. Small callables (a handful of captured
+// pointers) are stored inline so scheduling a task doesn't allocate.
+class TaskFunction final {
+public:
+    static constexpr size_t InlineSize = 48;
+
+    TaskFunction() = default;
+    ~TaskFunction() { Reset(); }
+
+    TaskFunction(const TaskFunction&) = delete;
+    TaskFunction& operator=(const TaskFunction&) = delete;
+
+    template <typename F>
+    void Emplace(F&& function)
+    {
+        using Fn = std::decay_t<F>;
+
+        Reset();
+
+        if constexpr (sizeof(Fn) <= InlineSize && alignof(Fn) <= alignof(std::max_align_t)) {
+            new (m_Storage) Fn(std::forward<F>(function));
+            m_Invoke = [](void* storage) { (*static_cast<Fn*>(storage))(); };
+            m_Destroy = [](void* storage) { static_cast<Fn*>(storage)->~Fn(); };
+        } else {
+            *reinterpret_cast<Fn**>(m_Storage) = new Fn(std::forward<F>(function));
+            m_Invoke = [](void* storage) { (**static_cast<Fn**>(storage))(); };
+            m_Destroy = [](void* storage) { delete *static_cast<Fn**>(storage); };
+        }
+    }
+
+    inline void operator()() { m_Invoke(m_Storage); }
+
+    inline void Reset()
+    {
+        if (m_Destroy)
+            m_Destroy(m_Storage);
+        m_Invoke = nullptr;
+        m_Destroy = nullptr;
+    }
+
+private:
+    alignas(std::max_align_t) std::byte m_Storage[InlineSize];
+    void (*m_Invoke)(void*) = nullptr;
+    void (*m_Destroy)(void*) = nullptr;
+};
+
+namespace detail {
+
+    // Intrusively reference counted and recycled through a per-thread free
+    // list, see `AcquireTask` and `ReleaseTask`.
+    struct Task {
+        TaskFunction Function;
+        std::atomic<uint32_t> RefCount { 0 };
+        // One for the task itself plus one per unfinished dependency.
+        std::atomic<uint32_t> Pending { 0 };
+        std::atomic<bool> Done { false };
+        std::atomic_flag ContinuationLock = ATOMIC_FLAG_INIT;
+        std::vector<Task*> Continuations;
+    };
+
+    Task* AcquireTask();
+    void ReleaseTask(Task* task);
+
+} // namespace detail
+
+class TaskHandle final {
 public:
-    TaskDispatcher();
-    virtual ~TaskDispatcher() = default;
+    TaskHandle() = default;
+
+    inline explicit TaskHandle(detail::Task* task)
+        : m_Task(task)
+    {
+        if (m_Task)
+            m_Task->RefCount.fetch_add(1, std::memory_order_relaxed);
+    }
 
-    static std::shared_ptr<TaskDispatcher> New();
+    inline TaskHandle(const TaskHandle& other)
+        : TaskHandle(other.m_Task)
+    {
+    }
 
-    void Run(std::function<void()> task);
+    inline TaskHandle(TaskHandle&& other) noexcept
+        : m_Task(std::exchange(other.m_Task, nullptr))
+    {
+    }
+
+    inline TaskHandle& operator=(TaskHandle other) noexcept
+    {
+        std::swap(m_Task, other.m_Task);
+        return *this;
+    }
+
+    inline ~TaskHandle()
+    {
+        if (m_Task)
+            detail::ReleaseTask(m_Task);
+    }
+
+    // An empty handle counts as done.
+    inline bool IsDone() const
+    {
+        return !m_Task || m_Task->Done.load(std::memory_order_acquire);
+    }
+
+    inline bool IsValid() const { return m_Task != nullptr; }
 
 private:
+    detail::Task* m_Task = nullptr;
+
+    friend class TaskDispatcher;
+};
+
+// Work-stealing job system. Each worker owns a Chase-Lev deque: it pushes and
+// pops its own work LIFO and steals FIFO from the others when it runs dry.
+// Tasks scheduled from threads that aren't workers go through a shared
+// injection queue.
+class TaskDispatcher final {
+public:
+    TaskDispatcher(const std::shared_ptr<spdlog::logger> logger, const unsigned int workerCount);
+    ~TaskDispatcher();
+
+    TaskDispatcher(const TaskDispatcher&) = delete;
+    TaskDispatcher& operator=(const TaskDispatcher&) = delete;
+
+    // A `workerCount` of 0 picks the hardware concurrency minus the calling
+    // (main) thread.
+    static Result<std::shared_ptr<TaskDispatcher>> New(const std::shared_ptr<spdlog::logger> logger, const unsigned int workerCount = 0);
+
+    template <typename F>
+    TaskHandle Run(F&& task)
+    {
+        return Run(std::forward<F>(task), {});
+    }
+
+    // Runs `task` once every task in `dependencies` has finished.
+    template <typename F>
+    TaskHandle Run(F&& task, std::initializer_list<TaskHandle> dependencies)
+    {
+        return Run(std::forward<F>(task), dependencies.begin(), dependencies.end());
+    }
+
+    template <typename F, typename It>
+    TaskHandle Run(F&& task, It dependenciesBegin, It dependenciesEnd)
+    {
+        detail::Task* t = detail::AcquireTask();
+        t->Function.Emplace(std::forward<F>(task));
+        TaskHandle handle(t);
+        Submit(t, dependenciesBegin, dependenciesEnd);
+        return handle;
+    }
+
+    // Schedules `continuation` to run after `task`.
+    template <typename F>
+    TaskHandle Then(const TaskHandle& task, F&& continuation)
+    {
+        return Run(std::forward<F>(continuation), { task });
+    }
+
+    // Blocks until `task` is done, running other tasks in the meantime.
+    void Wait(const TaskHandle& task);
+
+    // Calls `body(from, to)` for consecutive sub-ranges of [begin, end) no
+    // longer than `grain`, spread across the workers and the calling thread.
+    // Returns once the whole range has been processed.
+    template <typename F>
+    void ParallelFor(const size_t begin, const size_t end, const size_t grain, F&& body)
+    {
+        if (begin >= end)
+            return;
+
+        const size_t chunkSize = std::max<size_t>(grain, 1);
+        const size_t chunkCount = (end - begin + chunkSize - 1) / chunkSize;
+
+        std::atomic<size_t> nextChunk { 0 };
+        auto drain = [&nextChunk, &body, begin, end, chunkSize, chunkCount]() {
+            for (;;) {
+                const size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= chunkCount)
+                    return;
+                const size_t from = begin + chunk * chunkSize;
+                body(from, std::min(end, from + chunkSize));
+            }
+        };
+
+        const size_t helperCount = std::min<size_t>(chunkCount - 1, GetWorkerCount());
+        std::vector<TaskHandle> helpers;
+        helpers.reserve(helperCount);
+        for (size_t i = 0; i < helperCount; i++)
+            helpers.push_back(Run(drain));
+
+        drain();
+
+        for (const auto& helper : helpers)
+            Wait(helper);
+    }
+
+    inline unsigned int GetWorkerCount() const { return static_cast<unsigned int>(m_Workers.size()); }
+
+private:
+    struct Worker;
+
+    const std::shared_ptr<spdlog::logger> m_Logger;
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::vector<std::thread> m_Threads;
+    std::atomic<bool> m_Stopping;
+
+    std::mutex m_InjectionMutex;
+    std::deque<detail::Task*> m_Injection;
+    std::atomic<size_t> m_InjectionSize;
+
+    std::mutex m_SleepMutex;
+    std::condition_variable m_SleepCondition;
+    std::atomic<uint64_t> m_WorkEpoch;
+    std::atomic<unsigned int> m_SleepingCount;
+
+    template <typename It>
+    void Submit(detail::Task* task, It dependenciesBegin, It dependenciesEnd)
+    {
+        task->Pending.store(1, std::memory_order_relaxed);
+        task->RefCount.fetch_add(1, std::memory_order_relaxed); // Held until executed.
+
+        for (auto it = dependenciesBegin; it != dependenciesEnd; ++it) {
+            if (it->m_Task)
+                AddDependency(task, it->m_Task);
+        }
+
+        if (task->Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            Schedule(task);
+    }
+
+    void AddDependency(detail::Task* task, detail::Task* dependency);
+    void Schedule(detail::Task* task);
+    void Execute(detail::Task* task);
+    detail::Task* FindWork(Worker* self);
+    void WorkerMain(Worker* self);
 };
 
 } // namespace engine
@@ -0,0 +1,330 @@
+#include "TextRenderer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "Trace.hpp"
+
+namespace engine {
+
+namespace {
+
+    constexpr uint32_t ReplacementCharacter = 0xfffd;
+    // Transparent pixels around every glyph, so filtering never samples a
+    // neighbour.
+    constexpr int GlyphPadding = 1;
+
+    // Decodes the UTF-8 sequence at `index` and moves past it. Malformed
+    // sequences decode to U+FFFD a byte at a time.
+    uint32_t DecodeUtf8(const std::string_view text, size_t& index)
+    {
+        const auto lead = static_cast<unsigned char>(text[index++]);
+        if (lead < 0x80)
+            return lead;
+
+        int length;
+        uint32_t codepoint;
+        if ((lead & 0xe0) == 0xc0) {
+            length = 1;
+            codepoint = lead & 0x1f;
+        } else if ((lead & 0xf0) == 0xe0) {
+            length = 2;
+            codepoint = lead & 0x0f;
+        } else if ((lead & 0xf8) == 0xf0) {
+            length = 3;
+            codepoint = lead & 0x07;
+        } else {
+            return ReplacementCharacter;
+        }
+
+        if (index + length > text.size())
+            return ReplacementCharacter;
+        for (int i = 0; i < length; i++) {
+            const auto next = static_cast<unsigned char>(text[index + i]);
+            if ((next & 0xc0) != 0x80)
+                return ReplacementCharacter;
+            codepoint = (codepoint << 6) | (next & 0x3f);
+        }
+        index += length;
+        return codepoint;
+    }
+
+    size_t CombineHash(const size_t seed, const size_t value)
+    {
+        return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    }
+
+} // namespace
+
+size_t TextRenderer::GlyphKeyHash::operator()(const GlyphKey& key) const
+{
+    size_t hash = std::hash<const void*>()(key.Font);
+    hash = CombineHash(hash, std::hash<int>()(key.Size));
+    return CombineHash(hash, std::hash<uint32_t>()(key.Codepoint));
+}
+
+size_t TextRenderer::LayoutKeyHash::operator()(const LayoutKey& key) const
+{
+    return (*this)(LayoutKeyView { .Font = key.Font, .Size = key.Size, .Text = key.Text });
+}
+
+size_t TextRenderer::LayoutKeyHash::operator()(const LayoutKeyView& key) const
+{
+    size_t hash = std::hash<const void*>()(key.Font);
+    hash = CombineHash(hash, std::hash<int>()(key.Size));
+    return CombineHash(hash, std::hash<std::string_view>()(key.Text));
+}
+
+bool TextRenderer::LayoutKeyEqual::operator()(const LayoutKey& a, const LayoutKey& b) const
+{
+    return a.Font == b.Font && a.Size == b.Size && a.Text == b.Text;
+}
+
+bool TextRenderer::LayoutKeyEqual::operator()(const LayoutKeyView& a, const LayoutKey& b) const
+{
+    return a.Font == b.Font && a.Size == b.Size && a.Text == b.Text;
+}
+
+bool TextRenderer::LayoutKeyEqual::operator()(const LayoutKey& a, const LayoutKeyView& b) const
+{
+    return (*this)(b, a);
+}
+
+TextRenderer::TextRenderer(SDL_Renderer* renderer, TextureMirror* mirror)
+    : m_Renderer(renderer)
+    , m_Mirror(mirror)
+    , m_Pages()
+    , m_Glyphs()
+    , m_Layouts()
+    , m_Lru()
+    , m_Full(false)
+    , m_UsedArea(0)
+    , m_Stats()
+{
+}
+
+TextRenderer::~TextRenderer()
+{
+    Clear();
+}
+
+void TextRenderer::BeginFrame()
+{
+    if (m_Full) {
+        Clear();
+        m_Stats.Resets++;
+    }
+
+    m_Stats.GlyphMisses = 0;
+    m_Stats.LayoutHits = 0;
+    m_Stats.LayoutMisses = 0;
+}
+
+void TextRenderer::Submit(RenderQueue& queue, const TextCommand& text)
+{
+    if (!text.Font || text.Text.empty())
+        return;
+
+    const Layout& layout = GetLayout(text.Font, text.Size, text.Text);
+    for (const auto& placed : layout.Glyphs) {
+        const auto& glyph = *placed.Cached;
+        const SDL_FRect destination {
+            text.X + placed.X,
+            text.Y + placed.Y,
+            static_cast<float>(glyph.Source.w),
+            static_cast<float>(glyph.Source.h),
+        };
+        queue.Submit(text.Layer, 0, glyph.Page, glyph.Source, destination, text.Color);
+    }
+
+    m_Stats.Glyphs = m_Glyphs.size();
+    m_Stats.Layouts = m_Layouts.size();
+    m_Stats.Pages = m_Pages.size();
+    m_Stats.Occupancy = m_Pages.empty()
+        ? 0.0
+        : static_cast<double>(m_UsedArea) / (static_cast<double>(PageSize) * PageSize * m_Pages.size());
+}
+
+const TextRenderer::Layout& TextRenderer::GetLayout(TTF_Font* font, const int size, const std::string_view text)
+{
+    const LayoutKeyView view { .Font = font, .Size = size, .Text = text };
+    if (auto it = m_Layouts.find(view); it != m_Layouts.end()) {
+        m_Lru.splice(m_Lru.begin(), m_Lru, it->second.LruPosition);
+        m_Stats.LayoutHits++;
+        return it->second;
+    }
+
+    ENG_TRACE_ZONE("TextRenderer::GetLayout");
+    m_Stats.LayoutMisses++;
+
+    TTF_SetFontSize(font, size);
+    const int lineSkip = TTF_FontLineSkip(font);
+
+    Layout layout;
+    int penX = 0;
+    int penY = 0;
+    uint32_t previous = 0;
+    for (size_t i = 0; i < text.size();) {
+        const uint32_t codepoint = DecodeUtf8(text, i);
+        if (codepoint == '\n') {
+            penX = 0;
+            penY += lineSkip;
+            previous = 0;
+            continue;
+        }
+
+        const Glyph* glyph = GetGlyph(font, size, codepoint);
+        if (!glyph)
+            continue;
+        if (previous != 0)
+            penX += TTF_GetFontKerningSizeGlyphs32(font, previous, codepoint);
+        previous = codepoint;
+
+        // Whitespace has an advance but nothing to draw.
+        if (glyph->Source.w > 0 && glyph->Source.h > 0) {
+            layout.Glyphs.push_back(PlacedGlyph {
+                .Cached = glyph,
+                .X = static_cast<float>(penX + glyph->OffsetX),
+                .Y = static_cast<float>(penY),
+            });
+        }
+        penX += glyph->Advance;
+    }
+
+    if (m_Layouts.size() >= MaxLayouts) {
+        // Erased through an iterator, the key lives in the erased node.
+        m_Layouts.erase(m_Layouts.find(*m_Lru.back()));
+        m_Lru.pop_back();
+    }
+
+    auto [it, inserted] = m_Layouts.emplace(LayoutKey { .Font = font, .Size = size, .Text = std::string(text) }, std::move(layout));
+    m_Lru.push_front(&it->first);
+    it->second.LruPosition = m_Lru.begin();
+    return it->second;
+}
+
+const TextRenderer::Glyph* TextRenderer::GetGlyph(TTF_Font* font, const int size, const uint32_t codepoint)
+{
+    const GlyphKey key { .Font = font, .Size = size, .Codepoint = codepoint };
+    if (auto it = m_Glyphs.find(key); it != m_Glyphs.end())
+        return &it->second;
+
+    ENG_TRACE_ZONE("TextRenderer::GetGlyph");
+    m_Stats.GlyphMisses++;
+
+    int minX = 0;
+    int maxX = 0;
+    int minY = 0;
+    int maxY = 0;
+    int advance = 0;
+    if (TTF_GlyphMetrics32(font, codepoint, &minX, &maxX, &minY, &maxY, &advance) != 0) {
+        if (codepoint == ReplacementCharacter)
+            return nullptr;
+        return GetGlyph(font, size, ReplacementCharacter);
+    }
+
+    Glyph glyph {
+        .Page = nullptr,
+        .Source = SDL_Rect {},
+        // Glyphs reaching left of the pen are rendered from where they start.
+        .OffsetX = std::min(minX, 0),
+        .Advance = advance,
+    };
+
+    SDL_Surface* rendered = TTF_RenderGlyph32_Blended(font, codepoint, SDL_Color { 255, 255, 255, 255 });
+    if (rendered && rendered->w > 0 && rendered->h > 0) {
+        SDL_Surface* surface = SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_ARGB8888, 0);
+        const int width = surface ? surface->w : 0;
+        const int height = surface ? surface->h : 0;
+        const auto region = surface ? Allocate(width + GlyphPadding * 2, height + GlyphPadding * 2) : std::nullopt;
+        if (!region.has_value()) {
+            if (surface)
+                SDL_FreeSurface(surface);
+            SDL_FreeSurface(rendered);
+            // Not cached, the atlas starts over next frame.
+            return nullptr;
+        }
+
+        const int stride = width + GlyphPadding * 2;
+        std::vector<uint32_t> pixels(static_cast<size_t>(stride) * (height + GlyphPadding * 2), 0);
+        for (int row = 0; row < height; row++) {
+            std::memcpy(
+                &pixels[static_cast<size_t>(row + GlyphPadding) * stride + GlyphPadding],
+                static_cast<const uint8_t*>(surface->pixels) + static_cast<size_t>(row) * surface->pitch,
+                static_cast<size_t>(width) * sizeof(uint32_t)
+            );
+        }
+        SDL_UpdateTexture(region->Texture, &region->Rect, pixels.data(), stride * static_cast<int>(sizeof(uint32_t)));
+        if (m_Mirror)
+            m_Mirror->Update(region->Texture, region->Rect, pixels.data(), stride * static_cast<int>(sizeof(uint32_t)));
+        SDL_FreeSurface(surface);
+
+        glyph.Page = region->Texture;
+        glyph.Source = SDL_Rect { region->Rect.x + GlyphPadding, region->Rect.y + GlyphPadding, width, height };
+    }
+    if (rendered)
+        SDL_FreeSurface(rendered);
+
+    return &m_Glyphs.emplace(key, glyph).first->second;
+}
+
+std::optional<AtlasRegion> TextRenderer::Allocate(const int width, const int height)
+{
+    if (m_Full)
+        return std::nullopt;
+
+    for (auto& page : m_Pages) {
+        if (const auto rect = page.Packer.Insert(width, height)) {
+            m_UsedArea += static_cast<uint64_t>(width) * height;
+            return AtlasRegion { .Texture = page.Texture, .Rect = *rect };
+        }
+    }
+
+    if (m_Pages.size() < MaxPages && width <= PageSize && height <= PageSize) {
+        SDL_Texture* texture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, PageSize, PageSize);
+        if (texture) {
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            if (m_Mirror)
+                m_Mirror->Create(texture, PageSize, PageSize);
+            m_Pages.push_back(Page { .Texture = texture, .Packer = SkylinePacker(PageSize, PageSize) });
+            const auto rect = m_Pages.back().Packer.Insert(width, height);
+            m_UsedArea += static_cast<uint64_t>(width) * height;
+            return AtlasRegion { .Texture = texture, .Rect = *rect };
+        }
+    }
+
+    m_Full = true;
+    return std::nullopt;
+}
+
+void TextRenderer::Clear()
+{
+    ENG_TRACE_ZONE("TextRenderer::Clear");
+
+    for (auto& page : m_Pages) {
+        if (m_Mirror)
+            m_Mirror->Remove(page.Texture);
+        SDL_DestroyTexture(page.Texture);
+    }
+    m_Pages.clear();
+    m_Glyphs.clear();
+    m_Layouts.clear();
+    m_Lru.clear();
+    m_UsedArea = 0;
+    m_Full = false;
+}
+
+} // namespace engine
@@ -0,0 +1,168 @@
+#ifndef ENG_TEXT_RENDERER_HPP
+#define ENG_TEXT_RENDERER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "Atlas.hpp"
+#include "RenderQueue.hpp"
+#include "TextureMirror.hpp"
+
+namespace engine {
+
+// A string to draw, queued by the simulation and laid out by the renderer.
+struct TextCommand {
+    TTF_Font* Font;
+    int Size;
+    std::string Text;
+    // Top left of the first line, in screen pixels.
+    float X;
+    float Y;
+    SDL_Color Color;
+    uint8_t Layer;
+};
+
+struct TextStats {
+    // Counted since the last `BeginFrame`.
+    size_t GlyphMisses = 0;
+    size_t LayoutHits = 0;
+    size_t LayoutMisses = 0;
+    size_t Glyphs = 0;
+    size_t Layouts = 0;
+    size_t Pages = 0;
+    // Glyph area over page area, in the range 0-1.
+    double Occupancy = 0.0;
+    // Times the atlas filled up and was started over.
+    size_t Resets = 0;
+};
+
+// Draws text as quads from a glyph atlas. Every (font, size, glyph) is
+// rasterized once into an atlas page, and the glyph positions of recently
+// drawn strings are kept, so repeated text costs a lookup and a quad per
+// glyph. Main thread only.
+class TextRenderer final {
+public:
+    static constexpr int PageSize = 1024;
+    static constexpr size_t MaxPages = 4;
+    static constexpr size_t MaxLayouts = 1024;
+    // Fonts are opened at the default size. Sizes are in points.
+    static constexpr int DefaultSize = 16;
+    static constexpr int MaxSize = 256;
+    // Above the entities by default.
+    static constexpr uint8_t DefaultLayer = 192;
+
+    // Glyph pages are kept in `mirror` too, if given.
+    TextRenderer(SDL_Renderer* renderer, TextureMirror* mirror);
+    ~TextRenderer();
+
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer& operator=(const TextRenderer&) = delete;
+
+    // Starts over if the atlas filled up, which can't happen while a frame
+    // still refers to its pages.
+    void BeginFrame();
+    // Queues the glyphs of `text`, a command each.
+    void Submit(RenderQueue& queue, const TextCommand& text);
+    // Forgets every glyph and layout and frees the pages, for when fonts are
+    // closed and their addresses may be reused, or the renderer is going
+    // away. Not within a frame.
+    void Clear();
+
+    inline const TextStats& GetStats() const { return m_Stats; }
+
+private:
+    struct Glyph {
+        SDL_Texture* Page;
+        SDL_Rect Source;
+        // From the pen position, the top of the quad being the line's.
+        int OffsetX;
+        int Advance;
+    };
+
+    struct GlyphKey {
+        const TTF_Font* Font;
+        int Size;
+        uint32_t Codepoint;
+
+        bool operator==(const GlyphKey&) const = default;
+    };
+
+    struct GlyphKeyHash {
+        size_t operator()(const GlyphKey& key) const;
+    };
+
+    struct PlacedGlyph {
+        const Glyph* Cached;
+        float X;
+        float Y;
+    };
+
+    struct LayoutKey {
+        const TTF_Font* Font;
+        int Size;
+        std::string Text;
+    };
+
+    // Looks layouts up without copying the text.
+    struct LayoutKeyView {
+        const TTF_Font* Font;
+        int Size;
+        std::string_view Text;
+    };
+
+    struct LayoutKeyHash {
+        using is_transparent = void;
+        size_t operator()(const LayoutKey& key) const;
+        size_t operator()(const LayoutKeyView& key) const;
+    };
+
+    struct LayoutKeyEqual {
+        using is_transparent = void;
+        bool operator()(const LayoutKey& a, const LayoutKey& b) const;
+        bool operator()(const LayoutKeyView& a, const LayoutKey& b) const;
+        bool operator()(const LayoutKey& a, const LayoutKeyView& b) const;
+    };
+
+    struct Layout {
+        std::vector<PlacedGlyph> Glyphs;
+        std::list<const LayoutKey*>::iterator LruPosition;
+    };
+
+    struct Page {
+        SDL_Texture* Texture;
+        SkylinePacker Packer;
+    };
+
+    SDL_Renderer* m_Renderer;
+    TextureMirror* m_Mirror;
+    std::vector<Page> m_Pages;
+    // Node based, so glyph and key pointers survive rehashing.
+    std::unordered_map<GlyphKey, Glyph, GlyphKeyHash> m_Glyphs;
+    std::unordered_map<LayoutKey, Layout, LayoutKeyHash, LayoutKeyEqual> m_Layouts;
+    // Most recently used first.
+    std::list<const LayoutKey*> m_Lru;
+    bool m_Full;
+    uint64_t m_UsedArea;
+    TextStats m_Stats;
+
+    const Layout& GetLayout(TTF_Font* font, const int size, const std::string_view text);
+    // Null for a glyph that couldn't be rasterized or didn't fit.
+    const Glyph* GetGlyph(TTF_Font* font, const int size, const uint32_t codepoint);
+    // Room for a glyph, opening a new page if needed.
+    std::optional<AtlasRegion> Allocate(const int width, const int height);
+};
+
+} // namespace engine
+
+#endif // !ENG_TEXT_RENDERER_HPP
@@ -0,0 +1,125 @@
+#include "TextureMirror.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+
+namespace engine {
+
+namespace {
+
+    size_t GetImageBytes(const MirroredImage& image)
+    {
+        return image.Pixels.size() * sizeof(uint32_t);
+    }
+
+} // namespace
+
+TextureMirror::TextureMirror()
+    : m_Mutex()
+    , m_Images()
+    , m_Bytes(0)
+{
+}
+
+bool TextureMirror::Add(const SDL_Texture* texture, SDL_Surface& surface)
+{
+    SDL_Surface* source = &surface;
+    SDL_Surface* converted = nullptr;
+    if (surface.format->format != SDL_PIXELFORMAT_ARGB8888) {
+        converted = SDL_ConvertSurfaceFormat(&surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (!converted)
+            return false;
+        source = converted;
+    }
+
+    auto image = std::make_unique<MirroredImage>();
+    image->Width = source->w;
+    image->Height = source->h;
+    image->Pixels.resize(static_cast<size_t>(source->w) * source->h);
+
+    SDL_LockSurface(source);
+    for (int y = 0; y < source->h; y++) {
+        const auto* row = static_cast<const uint8_t*>(source->pixels) + static_cast<size_t>(y) * source->pitch;
+        std::memcpy(image->Pixels.data() + static_cast<size_t>(y) * source->w, row, static_cast<size_t>(source->w) * sizeof(uint32_t));
+    }
+    SDL_UnlockSurface(source);
+
+    if (converted)
+        SDL_FreeSurface(converted);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& slot = m_Images[texture];
+    if (slot)
+        m_Bytes -= GetImageBytes(*slot);
+    m_Bytes += GetImageBytes(*image);
+    slot = std::move(image);
+    return true;
+}
+
+void TextureMirror::Create(const SDL_Texture* texture, const int width, const int height)
+{
+    auto image = std::make_unique<MirroredImage>();
+    image->Width = width;
+    image->Height = height;
+    image->Pixels.assign(static_cast<size_t>(width) * height, 0);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& slot = m_Images[texture];
+    if (slot)
+        m_Bytes -= GetImageBytes(*slot);
+    m_Bytes += GetImageBytes(*image);
+    slot = std::move(image);
+}
+
+void TextureMirror::Update(const SDL_Texture* texture, const SDL_Rect& rect, const uint32_t* pixels, const int pitch)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const auto it = m_Images.find(texture);
+    if (it == m_Images.end())
+        return;
+
+    auto& image = *it->second;
+    const SDL_Rect bounds { 0, 0, image.Width, image.Height };
+    SDL_Rect clipped;
+    if (SDL_IntersectRect(&rect, &bounds, &clipped) != SDL_TRUE)
+        return;
+
+    for (int y = clipped.y; y < clipped.y + clipped.h; y++) {
+        const auto* row = reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(pixels) + static_cast<size_t>(y - rect.y) * pitch);
+        std::copy_n(row + (clipped.x - rect.x), clipped.w, image.Pixels.data() + static_cast<size_t>(y) * image.Width + clipped.x);
+    }
+}
+
+void TextureMirror::Remove(const SDL_Texture* texture)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const auto it = m_Images.find(texture);
+    if (it == m_Images.end())
+        return;
+    m_Bytes -= GetImageBytes(*it->second);
+    m_Images.erase(it);
+}
+
+const MirroredImage* TextureMirror::Find(const SDL_Texture* texture) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const auto it = m_Images.find(texture);
+    return it == m_Images.end() ? nullptr : it->second.get();
+}
+
+size_t TextureMirror::GetBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Bytes;
+}
+
+} // namespace engine
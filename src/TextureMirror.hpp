@@ -0,0 +1,56 @@
+#ifndef ENG_TEXTURE_MIRROR_HPP
+#define ENG_TEXTURE_MIRROR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+
+namespace engine {
+
+// A texture's pixels as ARGB8888 words in straight alpha, rows `Width` apart.
+struct MirroredImage {
+    int Width;
+    int Height;
+    std::vector<uint32_t> Pixels;
+};
+
+// CPU copies of textures, for the software rasterizer to sample from since
+// SDL can't read textures back. Whatever creates, updates or destroys a
+// texture the rasterizer may draw reports it here. Images stay at their
+// address until removed, so `Find` can be called without holding on to the
+// lock while nothing is removed. Thread safe.
+class TextureMirror final {
+public:
+    TextureMirror();
+    ~TextureMirror() = default;
+
+    TextureMirror(const TextureMirror&) = delete;
+    TextureMirror& operator=(const TextureMirror&) = delete;
+
+    // Copies `surface`, converted if needed. Returns false if it couldn't be.
+    bool Add(const SDL_Texture* texture, SDL_Surface& surface);
+    // A transparent image, to be filled with `Update`.
+    void Create(const SDL_Texture* texture, const int width, const int height);
+    // Mirrors `SDL_UpdateTexture` with ARGB8888 `pixels`.
+    void Update(const SDL_Texture* texture, const SDL_Rect& rect, const uint32_t* pixels, const int pitch);
+    void Remove(const SDL_Texture* texture);
+
+    // Null if `texture` isn't mirrored.
+    const MirroredImage* Find(const SDL_Texture* texture) const;
+    size_t GetBytes() const;
+
+private:
+    mutable std::mutex m_Mutex;
+    std::unordered_map<const SDL_Texture*, std::unique_ptr<MirroredImage>> m_Images;
+    size_t m_Bytes;
+};
+
+} // namespace engine
+
+#endif // !ENG_TEXTURE_MIRROR_HPP
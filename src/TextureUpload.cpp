@@ -0,0 +1,112 @@
+#include "TextureUpload.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+
+#include "Trace.hpp"
+
+namespace engine {
+
+TextureUploadQueue::TextureUploadQueue(SDL_Renderer* renderer, const size_t budgetBytes)
+    : m_Renderer(renderer)
+    , m_BudgetBytes(budgetBytes)
+    , m_Mutex()
+    , m_Queue()
+    , m_Stats()
+    , m_Mirror(nullptr)
+{
+}
+
+TextureUploadQueue::~TextureUploadQueue()
+{
+    for (auto& upload : m_Queue) {
+        if (upload.Surface)
+            SDL_FreeSurface(upload.Surface);
+    }
+}
+
+void TextureUploadQueue::Push(const void* owner, SDL_Surface* surface, UploadCallback&& done)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Queue.push_back(PendingUpload { .Owner = owner, .Surface = surface, .Done = std::move(done) });
+}
+
+void TextureUploadQueue::Process()
+{
+    ENG_TRACE_ZONE("TextureUploadQueue::Process");
+
+    m_Stats = UploadStats();
+    while (m_BudgetBytes == 0 || m_Stats.Uploads == 0 || m_Stats.Bytes < m_BudgetBytes) {
+        PendingUpload upload;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Queue.empty())
+                break;
+            upload = std::move(m_Queue.front());
+            m_Queue.pop_front();
+        }
+        m_Stats.Bytes += Upload(upload);
+        m_Stats.Uploads++;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stats.Pending = m_Queue.size();
+}
+
+void TextureUploadQueue::Finish(const void* owner)
+{
+    std::deque<PendingUpload> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_Queue.begin(); it != m_Queue.end();) {
+            if (it->Owner != owner) {
+                ++it;
+                continue;
+            }
+            finished.push_back(std::move(*it));
+            it = m_Queue.erase(it);
+        }
+    }
+
+    // Uploaded outside the lock, the callbacks may push more.
+    for (auto& upload : finished)
+        Upload(upload);
+}
+
+void TextureUploadQueue::Cancel(const void* owner)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto it = m_Queue.begin(); it != m_Queue.end();) {
+        if (it->Owner != owner) {
+            ++it;
+            continue;
+        }
+        if (it->Surface)
+            SDL_FreeSurface(it->Surface);
+        it = m_Queue.erase(it);
+    }
+}
+
+size_t TextureUploadQueue::Upload(PendingUpload& upload)
+{
+    if (!upload.Surface) {
+        upload.Done(nullptr, nullptr);
+        return 0;
+    }
+
+    ENG_TRACE_ZONE("Texture upload");
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(m_Renderer, upload.Surface);
+    const size_t bytes = static_cast<size_t>(upload.Surface->pitch) * upload.Surface->h;
+    if (texture && m_Mirror)
+        m_Mirror->Add(texture, *upload.Surface);
+    upload.Done(texture, upload.Surface);
+    SDL_FreeSurface(upload.Surface);
+    return bytes;
+}
+
+} // namespace engine
@@ -0,0 +1,80 @@
+#ifndef ENG_TEXTURE_UPLOAD_HPP
+#define ENG_TEXTURE_UPLOAD_HPP
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+
+#include "TextureMirror.hpp"
+
+namespace engine {
+
+// Called on the main thread with the new texture, or null if it couldn't be
+// created. The surface is freed afterwards.
+using UploadCallback = std::function<void(SDL_Texture* texture, const SDL_Surface* surface)>;
+
+struct UploadStats {
+    size_t Uploads = 0;
+    size_t Bytes = 0;
+    size_t Pending = 0;
+};
+
+// Surfaces decoded on worker threads, waiting to become textures. SDL only
+// allows creating textures on the thread owning the renderer, so the main
+// thread drains the queue once per frame, uploading no more than a byte
+// budget to keep frames from stalling while assets stream in.
+class TextureUploadQueue final {
+public:
+    // A `budgetBytes` of 0 uploads everything queued each frame.
+    TextureUploadQueue(SDL_Renderer* renderer, const size_t budgetBytes);
+    ~TextureUploadQueue();
+
+    TextureUploadQueue(const TextureUploadQueue&) = delete;
+    TextureUploadQueue& operator=(const TextureUploadQueue&) = delete;
+
+    // Takes ownership of `surface`, which may be null to report a failed
+    // decode through `done`. `owner` identifies the upload for `Cancel` and
+    // `Finish`. Thread safe.
+    void Push(const void* owner, SDL_Surface* surface, UploadCallback&& done);
+
+    // Uploads queued surfaces in order until the budget is used up, but at
+    // least one. Main thread only.
+    void Process();
+    // Uploads everything queued for `owner` right away. Main thread only.
+    void Finish(const void* owner);
+    // Frees what's queued for `owner` without calling back. Main thread only.
+    void Cancel(const void* owner);
+
+    // Uploaded surfaces are copied into `mirror` too, if set. Textures
+    // created elsewhere for the same renderer look it up here.
+    inline void SetMirror(TextureMirror* mirror) { m_Mirror = mirror; }
+    inline TextureMirror* GetMirror() const { return m_Mirror; }
+
+    // Counted over the last `Process`.
+    inline const UploadStats& GetStats() const { return m_Stats; }
+
+private:
+    struct PendingUpload {
+        const void* Owner;
+        SDL_Surface* Surface;
+        UploadCallback Done;
+    };
+
+    SDL_Renderer* m_Renderer;
+    const size_t m_BudgetBytes;
+    std::mutex m_Mutex;
+    std::deque<PendingUpload> m_Queue;
+    UploadStats m_Stats;
+    TextureMirror* m_Mirror;
+
+    // Returns the bytes uploaded.
+    size_t Upload(PendingUpload& upload);
+};
+
+} // namespace engine
+
+#endif // !ENG_TEXTURE_UPLOAD_HPP
@@ -0,0 +1,131 @@
+#include "Tilemap.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <SDL2/SDL_rect.h>
+
+namespace engine {
+
+namespace {
+
+    std::atomic<uint32_t> NextLayerId = 0;
+
+    int DivCeil(const int value, const int divisor)
+    {
+        return (value + divisor - 1) / divisor;
+    }
+
+} // namespace
+
+int Tileset::GetColumns() const
+{
+    return TileWidth > 0 ? std::max(Source.w / TileWidth, 1) : 1;
+}
+
+SDL_Rect Tileset::GetTileSource(const TileId tile) const
+{
+    const int index = tile - 1;
+    const int columns = GetColumns();
+    return SDL_Rect {
+        Source.x + (index % columns) * TileWidth,
+        Source.y + (index / columns) * TileHeight,
+        TileWidth,
+        TileHeight,
+    };
+}
+
+TileLayer::TileLayer(const int width, const int height, const Tileset& tileset, const uint8_t layer)
+    : m_Id(NextLayerId.fetch_add(1, std::memory_order_relaxed))
+    , m_Width(std::max(width, 0))
+    , m_Height(std::max(height, 0))
+    , m_ChunkColumns(DivCeil(m_Width, TileChunk::Size))
+    , m_Tileset(tileset)
+    , m_Layer(layer)
+    , m_Chunks(static_cast<size_t>(m_ChunkColumns) * DivCeil(m_Height, TileChunk::Size))
+    , m_Versions(m_Chunks.size(), 0)
+    , m_Version(0)
+{
+}
+
+TileId TileLayer::GetTile(const int x, const int y) const
+{
+    if (x < 0 || y < 0 || x >= m_Width || y >= m_Height)
+        return EmptyTile;
+
+    const auto& chunk = m_Chunks[(y / TileChunk::Size) * m_ChunkColumns + x / TileChunk::Size];
+    if (!chunk)
+        return EmptyTile;
+    return chunk->Tiles[(y % TileChunk::Size) * TileChunk::Size + x % TileChunk::Size];
+}
+
+void TileLayer::SetTile(const int x, const int y, const TileId tile)
+{
+    if (x < 0 || y < 0 || x >= m_Width || y >= m_Height)
+        return;
+
+    const size_t index = (y / TileChunk::Size) * m_ChunkColumns + x / TileChunk::Size;
+    auto& chunk = m_Chunks[index];
+    if (!chunk) {
+        if (tile == EmptyTile)
+            return;
+        chunk = std::make_shared<TileChunk>();
+    }
+
+    const size_t offset = (y % TileChunk::Size) * TileChunk::Size + x % TileChunk::Size;
+    if (chunk->Tiles[offset] == tile)
+        return;
+
+    // A frame being drawn may still hold the chunk. Only this thread hands
+    // out references, so a count of one can't go up behind our back.
+    if (chunk.use_count() > 1)
+        chunk = std::make_shared<TileChunk>(*chunk);
+
+    auto& target = chunk->Tiles[offset];
+    if (target == EmptyTile)
+        chunk->Filled++;
+    else if (tile == EmptyTile)
+        chunk->Filled--;
+    target = tile;
+    m_Versions[index] = ++m_Version;
+}
+
+void TileLayer::GetChunks(const SDL_Rect& view, std::vector<TileChunkInstance>& out) const
+{
+    const int chunkWidth = TileChunk::Size * m_Tileset.TileWidth;
+    const int chunkHeight = TileChunk::Size * m_Tileset.TileHeight;
+    if (chunkWidth <= 0 || chunkHeight <= 0 || view.w <= 0 || view.h <= 0)
+        return;
+    if (view.x + view.w <= 0 || view.y + view.h <= 0)
+        return;
+
+    const int chunkRows = static_cast<int>(m_Chunks.size()) / std::max(m_ChunkColumns, 1);
+    const int left = std::max(view.x, 0) / chunkWidth;
+    const int top = std::max(view.y, 0) / chunkHeight;
+    const int right = std::min((view.x + view.w - 1) / chunkWidth, m_ChunkColumns - 1);
+    const int bottom = std::min((view.y + view.h - 1) / chunkHeight, chunkRows - 1);
+
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++) {
+            const size_t index = static_cast<size_t>(y) * m_ChunkColumns + x;
+            const auto& chunk = m_Chunks[index];
+            if (!chunk || chunk->Filled == 0)
+                continue;
+
+            out.push_back(TileChunkInstance {
+                .Key = (static_cast<uint64_t>(m_Id) << 32) | index,
+                .Version = m_Versions[index],
+                .Tiles = chunk,
+                .Set = m_Tileset,
+                .Bounds = SDL_Rect { x * chunkWidth, y * chunkHeight, chunkWidth, chunkHeight },
+                .Layer = m_Layer,
+            });
+        }
+    }
+}
+
+} // namespace engine
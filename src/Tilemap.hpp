@@ -0,0 +1,96 @@
+#ifndef ENG_TILEMAP_HPP
+#define ENG_TILEMAP_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <SDL2/SDL_rect.h>
+#include <SDL2/SDL_render.h>
+
+namespace engine {
+
+// Tiles are numbered from 1, 0 being no tile.
+using TileId = uint16_t;
+constexpr TileId EmptyTile = 0;
+
+// A grid of equally sized tiles within a texture, numbered left to right
+// and then top to bottom.
+struct Tileset {
+    SDL_Texture* Texture;
+    // Part of `Texture` holding the tiles, which may be an atlas page.
+    SDL_Rect Source;
+    int TileWidth;
+    int TileHeight;
+
+    int GetColumns() const;
+    // Part of `Texture` showing `tile`, which must not be `EmptyTile`.
+    SDL_Rect GetTileSource(const TileId tile) const;
+};
+
+struct TileChunk {
+    // Width and height of a chunk in tiles.
+    static constexpr int Size = 16;
+
+    std::array<TileId, Size * Size> Tiles {};
+    // Number of tiles that aren't `EmptyTile`.
+    size_t Filled = 0;
+};
+
+// A chunk of a layer to draw, copied into the frame data. The tiles are
+// shared with the layer, which copies a chunk rather than changing it
+// while a frame still refers to it.
+struct TileChunkInstance {
+    // Unique per layer and chunk. `Version` changes whenever its tiles do.
+    uint64_t Key;
+    uint64_t Version;
+    std::shared_ptr<const TileChunk> Tiles;
+    Tileset Set;
+    // In world pixels.
+    SDL_Rect Bounds;
+    uint8_t Layer;
+};
+
+// A static layer of tiles, drawn in chunks the renderer caches as textures
+// and redraws only once their tiles change.
+class TileLayer final {
+public:
+    // `width` and `height` are in tiles, `layer` is the render key layer.
+    TileLayer(const int width, const int height, const Tileset& tileset, const uint8_t layer);
+    ~TileLayer() = default;
+
+    // Layers are identified by the renderer's chunk cache, copies would be
+    // mistaken for each other.
+    TileLayer(const TileLayer&) = delete;
+    TileLayer& operator=(const TileLayer&) = delete;
+    TileLayer(TileLayer&&) = default;
+    TileLayer& operator=(TileLayer&&) = default;
+
+    // Out of range coordinates read as `EmptyTile` and are ignored when set.
+    TileId GetTile(const int x, const int y) const;
+    void SetTile(const int x, const int y, const TileId tile);
+
+    // Appends the chunks with tiles intersecting `view`, in world pixels.
+    void GetChunks(const SDL_Rect& view, std::vector<TileChunkInstance>& out) const;
+
+    inline int GetWidth() const { return m_Width; }
+    inline int GetHeight() const { return m_Height; }
+    inline const Tileset& GetTileset() const { return m_Tileset; }
+
+private:
+    uint32_t m_Id;
+    int m_Width;
+    int m_Height;
+    int m_ChunkColumns;
+    Tileset m_Tileset;
+    uint8_t m_Layer;
+    std::vector<std::shared_ptr<TileChunk>> m_Chunks;
+    std::vector<uint64_t> m_Versions;
+    uint64_t m_Version;
+};
+
+} // namespace engine
+
+#endif // !ENG_TILEMAP_HPP
@@ -0,0 +1,244 @@
+#include "Trace.hpp"
+
+#ifdef ENG_TRACE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "Result.hpp"
+
+namespace engine {
+namespace trace {
+
+    namespace {
+
+        enum class EventType : uint8_t {
+            Zone,
+            Counter,
+            Frame,
+        };
+
+        struct Event {
+            const char* Name;
+            uint64_t Timestamp;
+            uint64_t Duration;
+            double Value;
+            EventType Type;
+        };
+
+        // Must be a power of two. Once full, the oldest events are overwritten.
+        constexpr size_t BufferCapacity = 1 << 16;
+
+        // Single-producer ring buffer. Only the owning thread writes to it,
+        // `Dump` reads it from any thread without stopping the writer.
+        struct ThreadBuffer {
+            uint32_t Id;
+            std::atomic<const char*> Name { nullptr };
+            std::atomic<uint64_t> Head { 0 };
+            std::array<Event, BufferCapacity> Events;
+
+            inline void Push(const Event& event)
+            {
+                const auto head = Head.load(std::memory_order_relaxed);
+                Events[head & (BufferCapacity - 1)] = event;
+                Head.store(head + 1, std::memory_order_release);
+            }
+        };
+
+        struct Registry {
+            std::mutex Mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> Buffers;
+            const std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+        };
+
+        Registry& GetRegistry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        ThreadBuffer& GetThreadBuffer()
+        {
+            // The registry keeps the buffer alive after the thread exits so its
+            // events still make it into the dump.
+            thread_local ThreadBuffer* buffer = [] {
+                auto& registry = GetRegistry();
+                auto owned = std::make_shared<ThreadBuffer>();
+
+                std::lock_guard<std::mutex> lock(registry.Mutex);
+                owned->Id = static_cast<uint32_t>(registry.Buffers.size());
+                registry.Buffers.push_back(owned);
+                return owned.get();
+            }();
+
+            return *buffer;
+        }
+
+        std::string EscapeJson(const std::string_view str)
+        {
+            std::string out;
+            out.reserve(str.size());
+            for (const char c : str) {
+                switch (c) {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                        out += fmt::format("\\u{:04x}", c);
+                    else
+                        out += c;
+                    break;
+                }
+            }
+            return out;
+        }
+
+    } // namespace
+
+    uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - GetRegistry().Epoch
+        ).count();
+    }
+
+    void RecordZone(const char* name, const uint64_t start, const uint64_t end)
+    {
+        GetThreadBuffer().Push(Event {
+            .Name = name,
+            .Timestamp = start,
+            .Duration = end - start,
+            .Value = 0.0,
+            .Type = EventType::Zone,
+        });
+    }
+
+    void RecordCounter(const char* name, const double value)
+    {
+        GetThreadBuffer().Push(Event {
+            .Name = name,
+            .Timestamp = Now(),
+            .Duration = 0,
+            .Value = value,
+            .Type = EventType::Counter,
+        });
+    }
+
+    void RecordFrame()
+    {
+        GetThreadBuffer().Push(Event {
+            .Name = "Frame",
+            .Timestamp = Now(),
+            .Duration = 0,
+            .Value = 0.0,
+            .Type = EventType::Frame,
+        });
+    }
+
+    void SetThreadName(const char* name)
+    {
+        GetThreadBuffer().Name.store(name, std::memory_order_relaxed);
+    }
+
+    Result<> Dump(const std::filesystem::path& path)
+    {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            auto& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.Mutex);
+            buffers = registry.Buffers;
+        }
+
+        std::ofstream file(path);
+        if (!file)
+            return Error(Error::Io, "Couldn't open the trace file");
+
+        file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+        bool first = true;
+        const auto separator = [&first]() -> std::string_view {
+            if (first) {
+                first = false;
+                return "\n";
+            }
+            return ",\n";
+        };
+
+        std::vector<Event> events;
+        for (const auto& buffer : buffers) {
+            if (const char* name = buffer->Name.load(std::memory_order_relaxed)) {
+                file << separator() << fmt::format(
+                    R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+                    buffer->Id, EscapeJson(name)
+                );
+            }
+
+            const auto end = buffer->Head.load(std::memory_order_acquire);
+            const auto begin = end > BufferCapacity ? end - BufferCapacity : 0;
+
+            events.clear();
+            for (auto i = begin; i < end; i++)
+                events.push_back(buffer->Events[i & (BufferCapacity - 1)]);
+
+            // The owning thread kept writing while we copied; anything it
+            // lapped in the meantime is garbage.
+            const auto after = buffer->Head.load(std::memory_order_acquire);
+            const auto firstValid = after > BufferCapacity ? after - BufferCapacity : 0;
+            const size_t skip = firstValid > begin ? std::min<size_t>(firstValid - begin, events.size()) : 0;
+
+            for (size_t i = skip; i < events.size(); i++) {
+                const auto& event = events[i];
+                const double timestamp = event.Timestamp / 1000.0;
+
+                switch (event.Type) {
+                case EventType::Zone:
+                    file << separator() << fmt::format(
+                        R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                        EscapeJson(event.Name), buffer->Id, timestamp, event.Duration / 1000.0
+                    );
+                    break;
+                case EventType::Counter:
+                    file << separator() << fmt::format(
+                        R"({{"name":"{}","ph":"C","pid":1,"tid":{},"ts":{:.3f},"args":{{"value":{}}}}})",
+                        EscapeJson(event.Name), buffer->Id, timestamp, event.Value
+                    );
+                    break;
+                case EventType::Frame:
+                    file << separator() << fmt::format(
+                        R"({{"name":"{}","ph":"i","s":"g","pid":1,"tid":{},"ts":{:.3f}}})",
+                        EscapeJson(event.Name), buffer->Id, timestamp
+                    );
+                    break;
+                }
+            }
+        }
+
+        file << "\n]}\n";
+
+        if (!file)
+            return Error(Error::Io, "Couldn't write the trace file");
+
+        return Result();
+    }
+
+} // namespace trace
+} // namespace engine
+
+#endif // ENG_TRACE
@@ -0,0 +1,73 @@
+#ifndef ENG_TRACE_HPP
+#define ENG_TRACE_HPP
+
+// Lightweight instrumentation. Build with `-Dtracing=true` to enable it,
+// otherwise every `ENG_TRACE_*` macro expands to nothing.
+//
+// Zone, counter and thread names must be string literals (or otherwise
+// outlive the process), only the pointer is recorded.
+
+#ifdef ENG_TRACE
+
+#include <cstdint>
+#include <filesystem>
+
+#include "Result.hpp"
+
+namespace engine {
+namespace trace {
+
+    // Nanoseconds since the tracer was first used.
+    uint64_t Now();
+
+    void RecordZone(const char* name, const uint64_t start, const uint64_t end);
+    void RecordCounter(const char* name, const double value);
+    void RecordFrame();
+    void SetThreadName(const char* name);
+
+    // Writes everything recorded so far as Chrome trace event JSON, which can
+    // be opened in chrome://tracing or https://ui.perfetto.dev.
+    Result<> Dump(const std::filesystem::path& path);
+
+    class Zone final {
+    public:
+        inline Zone(const char* name)
+            : m_Name(name)
+            , m_Start(Now())
+        {
+        }
+
+        inline ~Zone()
+        {
+            RecordZone(m_Name, m_Start, Now());
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* m_Name;
+        uint64_t m_Start;
+    };
+
+} // namespace trace
+} // namespace engine
+
+#define ENG_TRACE_CONCAT_IMPL(a, b) a##b
+#define ENG_TRACE_CONCAT(a, b) ENG_TRACE_CONCAT_IMPL(a, b)
+
+#define ENG_TRACE_ZONE(name) ::engine::trace::Zone ENG_TRACE_CONCAT(engTraceZone, __LINE__)(name)
+#define ENG_TRACE_COUNTER(name, value) ::engine::trace::RecordCounter(name, static_cast<double>(value))
+#define ENG_TRACE_FRAME() ::engine::trace::RecordFrame()
+#define ENG_TRACE_THREAD_NAME(name) ::engine::trace::SetThreadName(name)
+
+#else
+
+#define ENG_TRACE_ZONE(name) ((void)0)
+#define ENG_TRACE_COUNTER(name, value) ((void)0)
+#define ENG_TRACE_FRAME() ((void)0)
+#define ENG_TRACE_THREAD_NAME(name) ((void)0)
+
+#endif // ENG_TRACE
+
+#endif // !ENG_TRACE_HPP
@@ -2,7 +2,10 @@
 #define ENG_UTIL_HPP
 
 #include "Result.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <string_view>
 
 #define ENG_ASSERT(cond, msg)                                               \
@@ -31,6 +34,27 @@ namespace util {
         unsigned int Patch;
     };
 
+    constexpr uint64_t Fnv1aOffsetBasis = 0xcbf29ce484222325;
+
+    // 64-bit FNV-1a. Pass the previous result as `hash` to continue hashing.
+    constexpr uint64_t Fnv1a(const std::string_view data, uint64_t hash = Fnv1aOffsetBasis)
+    {
+        for (const char c : data) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3;
+        }
+        return hash;
+    }
+
+    // Lets string keyed unordered containers be searched with a
+    // `std::string_view` without building a `std::string`. Use it with
+    // `std::equal_to<>`.
+    struct StringHash {
+        using is_transparent = void;
+
+        inline size_t operator()(const std::string_view str) const { return std::hash<std::string_view> {}(str); }
+    };
+
 }
 }
 